@@ -20,6 +20,8 @@
 #ifndef ADVECT_H
 #define ADVECT_H
 
+#include "rectilinear.hpp"
+
 struct advect2D {
   FS4D dvar;
   FS2D fluxx, fluxy;
@@ -60,4 +62,24 @@ struct advect3D {
   }
 };
 
+// divergence of the face fluxes over the widths of a rectilinear cell
+struct advectRect3D {
+  FS4D dvar;
+  FS3D wenox;
+  FS3D wenoy;
+  FS3D wenoz;
+  rectGrid rg;
+  int v;
+
+  advectRect3D(FS4D dvar_, FS3D wenox_, FS3D wenoy_, FS3D wenoz_, rectGrid rg_, int v_)
+      : dvar(dvar_), wenox(wenox_), wenoy(wenoy_), wenoz(wenoz_), rg(rg_), v(v_) {}
+
+  KOKKOS_INLINE_FUNCTION
+  void operator()(const int i, const int j, const int k) const {
+    dvar(i, j, k, v) = -((wenox(i, j, k) - wenox(i - 1, j, k)) / rg.width(0, i) +
+                         (wenoy(i, j, k) - wenoy(i, j - 1, k)) / rg.width(1, j) +
+                         (wenoz(i, j, k) - wenoz(i, j, k - 1)) / rg.width(2, k));
+  }
+};
+
 #endif
@@ -31,6 +31,10 @@
 #include <vector>
 #include <numeric>
 #include <map>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
 #include "xdmf.hpp"
 #include "timer.hpp"
 #include "fmt/core.h"
@@ -41,16 +45,157 @@
 #include "h5.hpp"
 #include "log2.hpp"
 #include "fiesta.hpp"
+#include "iothread.hpp"
+#include "staging.hpp"
+#include "stats.hpp"
 
 using namespace std;
 using fmt::format;
 
+// Copy a strided, optionally block averaged, selection of one variable into a
+// compact buffer.  The buffer is ordered with i fastest, matching the hdf5
+// hyperslab written for the block.
+template <typename T>
+struct packBlock {
+  FS4D src;
+  Kokkos::View<T*, Kokkos::MemoryUnmanaged> dst;
+  int v;
+  size_t offset;
+  int si, sj, sk;   // local starting cell
+  int di, dj, dk;   // stride
+  int ei, ej;       // extent of compact block
+  int ng, ngk;      // ghost offset
+  bool average;
+
+  packBlock(FS4D src_, Kokkos::View<T*, Kokkos::MemoryUnmanaged> dst_, int v_, size_t offset_, int si_, int sj_, int sk_,
+            int di_, int dj_, int dk_, int ei_, int ej_, int ng_, int ngk_, bool average_)
+    : src(src_), dst(dst_), v(v_), offset(offset_), si(si_), sj(sj_), sk(sk_), di(di_), dj(dj_), dk(dk_),
+      ei(ei_), ej(ej_), ng(ng_), ngk(ngk_), average(average_) {}
+
+  KOKKOS_INLINE_FUNCTION
+  void operator()(const int ii, const int jj, const int kk) const {
+    int i = si + ii*di;
+    int j = sj + jj*dj;
+    int k = sk + kk*dk;
+    size_t idx = offset + (size_t)ei*ej*kk + (size_t)ei*jj + ii;
+
+    if (average){
+      FSCAL mean = 0.0;
+      for (int ia=0; ia<di; ++ia)
+        for (int ja=0; ja<dj; ++ja)
+          for (int ka=0; ka<dk; ++ka)
+            mean += src(i+ia+ng, j+ja+ng, k+ka+ngk, v);
+      dst(idx) = mean/(di*dj*dk);
+    }else{
+      dst(idx) = src(i+ng, j+ng, k+ngk, v);
+    }
+  }
+};
+
+// Round away the mantissa bits below a field's error bound.  The trailing bits
+// of every value are then zero, which shuffle and deflate compress well, and
+// the values stay ordinary floats that need no filter to read.  The bound is
+// relative to each value, or absolute, in which case values inside the bound
+// are set to zero.
+template <typename T>
+struct groomBlock {
+  using U = typename std::conditional<sizeof(T)==4,uint32_t,uint64_t>::type;
+  static constexpr int mbits = std::numeric_limits<T>::digits-1;  // stored mantissa bits
+  static constexpr int ebias = std::numeric_limits<T>::max_exponent-1;
+  static constexpr U emask = ((U(1) << (sizeof(T)*8-1-mbits)) - 1) << mbits;
+
+  Kokkos::View<T*, Kokkos::MemoryUnmanaged> data;
+  size_t offset;
+  bool relative;
+  int keep;       // mantissa bits kept for a relative bound
+  int tolExp;     // floor(log2) of an absolute bound
+  T tolerance;
+
+  groomBlock(Kokkos::View<T*, Kokkos::MemoryUnmanaged> data_, size_t offset_, bool relative_, int keep_, int tolExp_, T tolerance_)
+    : data(data_), offset(offset_), relative(relative_), keep(keep_), tolExp(tolExp_), tolerance(tolerance_) {}
+
+  KOKKOS_INLINE_FUNCTION
+  void operator()(const size_t ii) const {
+    union { T f; U u; } b;
+    b.f = data(offset+ii);
+
+    // leave infinities and nans alone
+    if ((b.u & emask) == emask) return;
+
+    int k = keep;
+    if (!relative){
+      if (b.f <= tolerance && b.f >= -tolerance){
+        data(offset+ii) = 0.0;
+        return;
+      }
+      // the rounding error of x = m*2^e with k mantissa bits is at most 2^(e-k-1)
+      int e = (int)((b.u & emask) >> mbits) - ebias;
+      k = e - 1 - tolExp;
+    }
+    if (k >= mbits) return;
+    if (k < 0) k = 0;
+
+    int drop = mbits - k;
+    b.u = (b.u + (U(1) << (drop-1))) & ~((U(1) << drop) - 1);
+    data(offset+ii) = b.f;
+  }
+};
+
 template <typename T>
 size_t blockWriter<T>::frq() { return freq; }
 
 template <typename T>
 blockWriter<T>::blockWriter(){}
 
+// Select the combined layout, which stores the solution and the grid as one
+// multi-component dataset each so a file takes a single collective write per
+// group instead of one per variable.
+template <typename T>
+void blockWriter<T>::combineFields(bool combined_){
+  combined = combined_;
+}
+
+// Append every output to unlimited datasets of one file, or of a new file every
+// perFile outputs, instead of writing a file per output
+template <typename T>
+void blockWriter<T>::appendSteps(size_t perFile){
+  series = true;
+  seriesSpan = perFile;
+}
+
+// Trim the output fields to an error bound before writing, and compress every
+// dataset with the shuffle and deflate filters.  Fields without a bound of
+// their own use the default bound.
+template <typename T>
+void blockWriter<T>::compressLossy(errorBound boundDefault_, std::map<std::string,errorBound> bounds_, int level){
+  boundDefault = boundDefault_;
+  bounds = bounds_;
+  deflateLevel = level;
+}
+
+// Write the means, variances and covariances of a statistics accumulator
+// instead of the solution
+template <typename T>
+void blockWriter<T>::writeStatistics(std::shared_ptr<class runningStats> stats_){
+  stats = stats_;
+  writeVarx = false;
+}
+
+// Store the raw accumulators of a statistics view alongside the solution, so
+// they can be recovered on restart
+template <typename T>
+void blockWriter<T>::carryStatistics(std::shared_ptr<class runningStats> stats_){
+  carried.push_back(stats_);
+}
+
+// wait for any asynchronous write still using this view's buffers before the
+// last copy of the view frees its communicators
+template <typename T>
+blockWriter<T>::~blockWriter(){
+  if (inflight.valid())
+    inflight.wait();
+}
+
 template <typename T>
 blockWriter<T>::blockWriter(struct inputConfig& cf, std::unique_ptr<class rk_func>& f, string name_, string path_, bool avg_, size_t frq_, bool appStep_):
   name(name_), path(path_), avg(avg_), freq(frq_), appStep(appStep_),
@@ -73,6 +218,10 @@ blockWriter<T>::blockWriter(struct inputConfig& cf, std::unique_ptr<class rk_fun
   myColor=1;
   slicePresent=true;
   writeVarx=false;
+  combined=false;
+  series=false;
+  seriesSpan=0;
+  deflateLevel=0;
   pad = (int)log10(cf.tend) + 1;
   chunkable = cf.chunkable;
 #ifdef HAVE_MPI
@@ -81,7 +230,7 @@ blockWriter<T>::blockWriter(struct inputConfig& cf, std::unique_ptr<class rk_fun
   sliceSize = cf.numProcs;
 #endif
 
-  if (cf.rank==0){
+  if (cf.rank==0 && !cf.dryRun){
     if (!std::filesystem::exists(path)){
       Log::message("Creating directory: '{}'",path);
       std::filesystem::create_directories(path);
@@ -99,14 +248,8 @@ blockWriter<T>::blockWriter(struct inputConfig& cf, std::unique_ptr<class rk_fun
   lElems  = std::accumulate(lExt.begin(), lExt.end(), 1, std::multiplies<int>());
   lElemsG = std::accumulate(lExtG.begin(), lExtG.end(), 1, std::multiplies<int>());
 
-  // allocate pack buffers
-  fill_n(back_inserter(varData),lElems,0.0);
-  fill_n(back_inserter(gridData),lElemsG,0.0);
 
-  // create kokkos host mirrors
-  gridH = Kokkos::create_mirror_view(f->grid);
-  varH = Kokkos::create_mirror_view(f->var);
-  varxH = Kokkos::create_mirror_view(f->varx);
+  initAsync(cf);
 
   // if(sliceRank==0)
   //   Log::debugAll("IO VIEW: name={}, rank={}, size={}, chunkable={} compressible={}",name,sliceRank,sliceSize,cf.chunkable,cf.compressible);
@@ -158,7 +301,7 @@ blockWriter<T>::blockWriter(struct inputConfig& cf, std::unique_ptr<class rk_fun
   int strideDelta;
   size_t gMin;
 
-  if (cf.rank==0){
+  if (cf.rank==0 && !cf.dryRun){
     if (!std::filesystem::exists(path)){
       Log::message("Creating directory: '{}'",path);
       std::filesystem::create_directories(path);
@@ -172,6 +315,10 @@ blockWriter<T>::blockWriter(struct inputConfig& cf, std::unique_ptr<class rk_fun
   myColor=1;
   slicePresent=true;
   writeVarx=true;
+  combined=false;
+  series=false;
+  seriesSpan=0;
+  deflateLevel=0;
 
   for (int i=0; i<cf.ndim; ++i){
     //adjust block global size if it does not line up with strides
@@ -283,23 +430,162 @@ blockWriter<T>::blockWriter(struct inputConfig& cf, std::unique_ptr<class rk_fun
     }
   }
  
-  // allocate pack buffers
-  fill_n(back_inserter(varData),lElems,0.0);
-  fill_n(back_inserter(gridData),lElemsG,0.0);
-
-  // create kokkos host mirrors
-  gridH = Kokkos::create_mirror_view(f->grid);
-  varH = Kokkos::create_mirror_view(f->var);
-  varxH = Kokkos::create_mirror_view(f->varx);
   /* if(sliceRank==0) */
   /*   Log::debugAll("IO VIEW: name={}, rank={}, size={}, start={}, end={}, stride={}, extent={}",name,sliceRank,sliceSize,gStart,gEnd,stride,gExt); */
 
-  chunkable=false;
-  Log::warning("Chunking it not supported for IO views with strides.  Chunking will be disabled for {}.",name);
+  // per-rank chunks differ in size across a strided view, so these views are
+  // only chunked with a fixed chunk shape
+  chunkable = cf.chunkable && !h5Settings().chunk.empty();
+  if (cf.chunkable && !chunkable)
+    Log::warning("Chunking is not supported for IO views with strides.  Chunking will be disabled for {}.",name);
+
+  initAsync(cf);
+}
+
+#ifdef HAVE_MPI
+// Duplicate a communicator.  Views are copied into the ioview list, so the
+// duplicate is shared and freed when the last copy is destroyed.
+static std::shared_ptr<MPI_Comm> duplicate(MPI_Comm comm){
+  MPI_Comm *dup = new MPI_Comm;
+  MPI_Comm_dup(comm,dup);
+  return std::shared_ptr<MPI_Comm>(dup, [](MPI_Comm *c){
+    MPI_Comm_free(c);
+    delete c;
+  });
+}
+#endif
+
+// Set up communicators for writes.  Asynchronous writes issue their collectives
+// from the I/O thread, so they get private duplicates of the communicators used
+// by the solver.
+template<typename T>
+void blockWriter<T>::initAsync(struct inputConfig &cf){
+  async = cf.asyncIO;
+#ifdef HAVE_MPI
+  writeComm = sliceComm;
+  reportComm = cf.comm;
+  if (async){
+    if (myColor==1){
+      writeDup = duplicate(sliceComm);
+      writeComm = *writeDup;
+    }
+    reportDup = duplicate(cf.comm);
+    reportComm = *reportDup;
+  }
+#endif
+}
+
+// Extract this view's slice of the device data into the shared staging buffer
+// and copy it to a leased host buffer.  Only the selected, strided and averaged
+// cells are moved.
+template<typename T>
+void blockWriter<T>::snapshot(struct inputConfig &cf, std::unique_ptr<class rk_func>&f){
+  dgNames.clear();
+  if (stats){
+    varNames = stats->resultNames();
+    varxNames.clear();
+  }else{
+    varNames = f->varNames;
+    varxNames = f->varxNames;
+    for (auto const& [name, data] : f->dgmap)
+      dgNames.push_back(name);
+  }
+
+  lease = -1;
+  if (myColor!=1) return;
+
+  nFields = varNames.size();
+  if (writeVarx) nFields += varxNames.size();
+  if (cf.diagnostics) nFields += dgNames.size()*cf.nvt;
+
+  size_t nVar = nFields*lElems;
+  size_t nGrid = (cf.grid > 0) ? cf.ndim*lElemsG : 0;
+  size_t nStats = 0;
+  carriedSamples.clear();
+  for (auto& s : carried){
+    carriedSamples.push_back(s->samples);
+    nStats += s->acc.extent(3)*lElems;
+  }
+
+  auto packD = cf.staging->device<T>(nVar+nGrid+nStats);
+
+  size_t field = 0;
+  if (stats){
+    FS4D &result = stats->result();
+    for (size_t vn=0; vn<varNames.size(); ++vn)
+      pack(cf.ndim, result, vn, packD, lElems*field++, cf.ng, lExt, avg);
+  }else{
+    for (int vn=0; vn<cf.nvt; ++vn)
+      pack(cf.ndim, f->var, vn, packD, lElems*field++, cf.ng, lExt, avg);
+    if (writeVarx)
+      for (size_t vn=0; vn<varxNames.size(); ++vn)
+        pack(cf.ndim, f->varx, vn, packD, lElems*field++, cf.ng, lExt, avg);
+    if (cf.diagnostics)
+      for (auto const& [name, data] : f->dgmap)
+        for (int vn=0; vn<cf.nvt; ++vn)
+          pack(cf.ndim, data, vn, packD, lElems*field++, cf.ng, lExt, avg);
+  }
+  if (deflateLevel > 0){
+    vector<string> fieldNames(varNames);
+    if (writeVarx)
+      fieldNames.insert(fieldNames.end(), varxNames.begin(), varxNames.end());
+    if (cf.diagnostics)
+      for (auto const& dname : dgNames)
+        for (int vn=0; vn<cf.nvt; ++vn)
+          fieldNames.push_back(format("{}-{}",dname,vn));
+    for (size_t fn=0; fn<nFields; ++fn)
+      groom(fieldNames[fn], packD, lElems*fn);
+  }
+
+  for (size_t vn=0; vn<nGrid/lElemsG; ++vn)
+    pack(cf.ndim, f->grid, vn, packD, nVar+lElemsG*vn, 0, lExtG, false);
+
+  size_t offset = nVar+nGrid;
+  for (auto& s : carried){
+    for (size_t vn=0; vn<s->acc.extent(3); ++vn){
+      pack(cf.ndim, s->acc, vn, packD, offset, cf.ng, lExt, avg);
+      offset += lElems;
+    }
+  }
+
+  lease = cf.staging->acquire((nVar+nGrid+nStats)*sizeof(T));
+  auto packHost = cf.staging->host<T>(lease, nVar+nGrid+nStats);
+  Kokkos::deep_copy(packHost,packD);
+
+  packH = packHost.data();
+  gridPackH = packH + nVar;
+  statsPackH = gridPackH + nGrid;
 }
 
 template<typename T>
 void blockWriter<T>::write(struct inputConfig cf, std::unique_ptr<class rk_func>&f, int tdx, FSCAL time) {
+  if (!async){
+    snapshot(cf,f);
+    writeFiles(cf,tdx,time);
+    return;
+  }
+
+  // Backpressure: the previous write from this view must finish before its
+  // host buffers can be overwritten.
+  if (inflight.valid() && inflight.wait_for(std::chrono::seconds(0)) != std::future_status::ready){
+    Timer::fiestaTimer waitTimer = Timer::fiestaTimer();
+    inflight.wait();
+    Log::debug("[{}] Waited {:.2f}s for previous '{}' write",cf.t,waitTimer.check(),name);
+  }
+
+  snapshot(cf,f);
+  Kokkos::fence();
+  inflight = ioThread::instance().push([this,cf,tdx,time](){ writeFiles(cf,tdx,time); });
+}
+
+// Pack host buffers and write the HDF5 and XDMF files
+template<typename T>
+void blockWriter<T>::writeFiles(struct inputConfig cf, int tdx, FSCAL time) {
+  if (series){
+    writeSeriesFiles(cf,tdx,time);
+    return;
+  }
+
   string baseFormat,blockBase;
   if(appStep){
     baseFormat = format("{{}}-{{:0{}d}}",pad);
@@ -322,45 +608,82 @@ void blockWriter<T>::write(struct inputConfig cf, std::unique_ptr<class rk_func>
   if (myColor==1){
     h5Writer<T> writer;
 #ifdef HAVE_MPI
-    writer.open(sliceComm, MPI_INFO_NULL, hdfPath);
+    writer.open(writeComm, MPI_INFO_NULL, hdfPath);
 #else
     writer.open(hdfPath);
 #endif
+    writer.deflate(deflateLevel);
 
-    if (cf.grid > 0){
-      writer.openGroup("/Grid");
-      Kokkos::deep_copy(gridH,f->grid);
-      for (int vn=0; vn<cf.ndim; ++vn){
-        dataPack(cf.ndim, 0, lStart, lEndG, lExtG, stride, gridData, gridH,vn,false);
-        writer.write(format("Dimension{}",vn), cf.ndim, gExtG, lExtG, lOffset, gridData, chunkable, cf.compressible); 
+    if (combined){
+      if (cf.grid > 0){
+        writer.openGroup("/Grid");
+        writer.writeFields("Coordinates", cf.ndim, cf.ndim, gExtG, lExtG, lOffset, gridPackH, chunkable, cf.compressible);
+        writer.closeGroup();
       }
+
+      // record the field order so readers do not need the xdmf file
+      string fieldNames;
+      for (auto const& vname : varNames)
+        fieldNames += format(",{}",vname);
+      if (writeVarx)
+        for (auto const& vname : varxNames)
+          fieldNames += format(",{}",vname);
+      if (cf.diagnostics)
+        for (auto const& dname : dgNames)
+          for (int vn = 0; vn < cf.nvt; ++vn)
+            fieldNames += format(",{}-{}",dname,vn);
+
+      writer.openGroup("/Solution");
+      writer.writeFields("Fields", cf.ndim, nFields, gExt, lExt, lOffset, packH, chunkable, cf.compressible);
+      writer.writeAttribute("field_names",fieldNames.substr(1));
+      if (!describeBounds().empty())
+        writer.writeAttribute("error_bounds",describeBounds());
       writer.closeGroup();
-    }
+    }else{
+      if (cf.grid > 0){
+        writer.openGroup("/Grid");
+        for (int vn=0; vn<cf.ndim; ++vn){
+          writer.write(format("Dimension{}",vn), cf.ndim, gExtG, lExtG, lOffset, gridPackH+lElemsG*vn, chunkable, cf.compressible); 
+        }
+        writer.closeGroup();
+      }
 
-    writer.openGroup("/Solution");
-    Kokkos::deep_copy(varH,f->var);
-    for (int vn=0; vn<cf.nvt; ++vn){
-      dataPack(cf.ndim, cf.ng, lStart, lEnd, lExt, stride, varData, varH,vn,avg);
-      writer.write(f->varNames[vn], cf.ndim, gExt, lExt, lOffset, varData, chunkable, cf.compressible); 
-    }
-    if (writeVarx){
-      Kokkos::deep_copy(varxH,f->varx);
-      for (size_t vn = 0; vn < f->varxNames.size(); ++vn) {
-        dataPack(cf.ndim, cf.ng, lStart, lEnd, lExt, stride, varData, varxH,vn,avg);
-        writer.write(f->varxNames[vn], cf.ndim, gExt, lExt, lOffset, varData, chunkable, cf.compressible); 
+      writer.openGroup("/Solution");
+      if (!describeBounds().empty())
+        writer.writeAttribute("error_bounds",describeBounds());
+      T *data = packH;
+      for (size_t vn=0; vn<varNames.size(); ++vn){
+        writer.write(varNames[vn], cf.ndim, gExt, lExt, lOffset, data, chunkable, cf.compressible); 
+        data += lElems;
       }
+      if (writeVarx){
+        for (size_t vn = 0; vn < varxNames.size(); ++vn) {
+          writer.write(varxNames[vn], cf.ndim, gExt, lExt, lOffset, data, chunkable, cf.compressible); 
+          data += lElems;
+        }
+      }
+      if (cf.diagnostics){
+        for (auto const& dname : dgNames){
+          for (int vn = 0; vn < cf.nvt; ++vn) {
+            writer.write(fmt::format("{}-{}",dname,vn), cf.ndim, gExt, lExt, lOffset, data, chunkable, cf.compressible); 
+            data += lElems;
+          }
+        }
+      }
+      writer.closeGroup();
     }
-    if (cf.diagnostics){
-      for (auto const& [name, data] : f->dgmap){
-        FS4DH dataH = Kokkos::create_mirror_view(data);
-        Kokkos::deep_copy(dataH,data);
-        for (int vn = 0; vn < cf.nvt; ++vn) {
-          dataPack(cf.ndim, cf.ng, lStart, lEnd, lExt, stride, varData, dataH,vn,avg);
-          writer.write(fmt::format("{}-{}",name,vn), cf.ndim, gExt, lExt, lOffset, varData, chunkable, cf.compressible); 
+
+    if (!carried.empty()){
+      writer.openGroup("/Statistics");
+      T *data = statsPackH;
+      for (auto& s : carried){
+        for (auto const& sname : s->accumulatorNames()){
+          writer.write(sname, cf.ndim, gExt, lExt, lOffset, data, chunkable, cf.compressible);
+          data += lElems;
         }
       }
+      writer.closeGroup();
     }
-    writer.closeGroup();
 
     writer.openGroup("/Properties");
     writer.writeAttribute("time_index",tdx);
@@ -371,16 +694,20 @@ void blockWriter<T>::write(struct inputConfig cf, std::unique_ptr<class rk_func>
     writer.writeAttribute("fiesta_options",std::string(FIESTA_OPTIONS));
     writer.writeAttribute("fiesta_btime",std::string(FIESTA_BTIME));
     writer.writeAttribute("restart_file_version",FIESTA_RESTART_VERSION);
+    for (size_t n=0; n<carried.size(); ++n)
+      writer.writeAttribute(format("{} samples",carried[n]->name),carriedSamples[n]);
     writer.closeGroup();
 
     writer.close();
     //#ifdef HAVE_MPI
     //    MPI_Barrier(sliceComm);
     //#endif
+
+    cf.staging->release(lease);
   }
 
 #ifdef HAVE_MPI
-  MPI_Barrier(cf.comm);
+  MPI_Barrier(reportComm);
 #endif
 
   if (cf.rank==0){
@@ -388,70 +715,230 @@ void blockWriter<T>::write(struct inputConfig cf, std::unique_ptr<class rk_func>
     auto fsize = filesystem::file_size(hdfFilePath);
     FSCAL ftime = writeTimer.check();
     FSCAL frate = (fsize/1048576.0)/ftime;
+    string tuning = h5Settings().summary();
+    if (!tuning.empty()) tuning = format(" [{}]",tuning);
 
     if (fsize > 1073741824)
-      Log::message("[{}] '{}': {:.2f} GiB in {:.2f}s ({:.2f} MiB/s)",cf.t,hdfPath,fsize/1073741824.0,ftime,frate);  //divide by bytes per GiB (1024*1024*1024)
+      Log::message("[{}] '{}': {:.2f} GiB in {:.2f}s ({:.2f} MiB/s){}",cf.t,hdfPath,fsize/1073741824.0,ftime,frate,tuning);  //divide by bytes per GiB (1024*1024*1024)
     else
-      Log::message("[{}] '{}': {:.2f} MiB in {:.2f}s ({:.2f} MiB/s)",cf.t,hdfPath,fsize/1048576.0,ftime,frate);     //divide by bytes per MiB (1024*1024)
+      Log::message("[{}] '{}': {:.2f} MiB in {:.2f}s ({:.2f} MiB/s){}",cf.t,hdfPath,fsize/1048576.0,ftime,frate,tuning);     //divide by bytes per MiB (1024*1024)
   }
 
   //Log::message("[{}] Writing '{}'",cf.t,xmfPath);
   if (myColor==1){
-    writeXMF(xmfPath, hdfName, cf.grid, time, cf.ndim, gExt.data(),gOrigin,iodx, cf.nvt, writeVarx,f->varNames,f->varxNames,f->dgmap);
+    writeXMF(xmfPath, hdfName, cf.grid, time, cf.ndim, gExt.data(),gOrigin,iodx, varNames.size(), writeVarx,varNames,varxNames,dgNames,combined,!stats);
   }
 }
 
+// Add one output to a time series file.  The file holding the restart step is
+// continued after a restart, replacing its entries from that step on.
 template<typename T>
-void blockWriter<T>::dataPack(int ndim, int ng, const vector<size_t>& start, const vector<size_t>& end, const vector<size_t>& extent, const vector<size_t>& stride, vector<T>& dest, const FS4DH& source, const int vn, const bool average){
-  int ii,jj,kk;
-  int idx;
-  FSCAL mean;
+void blockWriter<T>::writeSeriesFiles(struct inputConfig cf, int tdx, FSCAL time) {
+  string blockBase = name;
+  if (seriesSpan > 0){
+    size_t first = (tdx/(seriesSpan*freq))*(seriesSpan*freq);
+    blockBase = format(format("{{}}-{{:0{}d}}",pad),name,first);
+  }
+  string hdfName   = format("{}.h5",blockBase);
+  string hdfPath   = format("{}/{}",path,hdfName);
+  string xmfPath   = format("{}/{}.xmf",path,blockBase);
 
-  if (ndim==3){
-    for (size_t i = start[0]; i < end[0]+1; i+=stride[0]) {
-      for (size_t j = start[1]; j < end[1]+1; j+=stride[1]) {
-        for (size_t k = start[2]; k < end[2]+1; k+=stride[2]) {
-          ii=(i-start[0])/stride[0];
-          jj=(j-start[1])/stride[1];
-          kk=(k-start[2])/stride[2];
-          idx = (extent[0] * extent[1]) * kk + extent[0] * jj + ii;
-          if (average){
-            mean=0.0;
-            for (size_t ia=0; ia<stride[0]; ++ia){
-              for (size_t ja=0; ja<stride[1]; ++ja){
-                for (size_t ka=0; ka<stride[2]; ++ka){
-                  mean += source (i+ia+ng,j+ja+ng,k+ka+ng,vn);
-                }
-              }
-            }
-            dest[idx] = mean/(stride[0]*stride[1]*stride[2]);
-          }else{
-            dest[idx] = source(i+ng, j+ng, k+ng,vn);
+  Log::message("[{}] Writing '{}'",cf.t,hdfPath);
+  Timer::fiestaTimer writeTimer = Timer::fiestaTimer();
+
+  if (myColor==1){
+    h5Writer<T> writer;
+    writer.deflate(deflateLevel);
+    bool fresh = (blockBase != seriesBase);
+    bool open = false;
+    bool root = true;
+#ifdef HAVE_MPI
+    root = (sliceRank == 0);
+#endif
+
+    if (fresh){
+      seriesTimes.clear();
+      if (cf.restart && seriesBase.empty() && filesystem::exists(hdfPath)){
+#ifdef HAVE_MPI
+        writer.openAppend(writeComm, MPI_INFO_NULL, hdfPath);
+#else
+        writer.openAppend(hdfPath);
+#endif
+        bool match = writer.hasDataset("Properties/Step") && writer.hasDataset("Properties/Time");
+        if (combined)
+          match = match && writer.hasDataset("Solution/Fields");
+        else
+          for (auto const& vname : varNames)
+            match = match && writer.hasDataset(format("Solution/{}",vname));
+
+        if (match){
+          auto steps = writer.template readEntryValues<int>("Properties/Step");
+          auto times = writer.template readEntryValues<FSCAL>("Properties/Time");
+          for (size_t e=0; e<steps.size() && steps[e] < tdx; ++e)
+            seriesTimes.push_back(times[e]);
+          fresh = false;
+          open = true;
+        }else{
+          writer.close();
+          if (root){
+            Log::warning("Series file '{}' does not match ioview '{}' and was moved to '{}.old'.",hdfPath,name,hdfPath);
+            filesystem::rename(hdfPath, hdfPath + ".old");
           }
+#ifdef HAVE_MPI
+          MPI_Barrier(writeComm);
+#endif
         }
       }
+      seriesBase = blockBase;
     }
-  }else{
-    for (size_t i = start[0]; i < end[0]+1; i+=stride[0]) {
-      for (size_t j = start[1]; j < end[1]+1; j+=stride[1]) {
-        ii=(i-start[0])/stride[0];
-        jj=(j-start[1])/stride[1];
-        idx = extent[0] * jj + ii;
-        if (average){
-          mean=0.0;
-          for (size_t ia=0; ia<stride[0]; ++ia){
-            for (size_t ja=0; ja<stride[1]; ++ja){
-              mean += source (i+ia+ng,j+ja+ng,0,vn);
-            }
+
+    // the grid and descriptive properties are written once per file
+    if (fresh){
+#ifdef HAVE_MPI
+      writer.open(writeComm, MPI_INFO_NULL, hdfPath);
+#else
+      writer.open(hdfPath);
+#endif
+      if (cf.grid > 0){
+        writer.openGroup("/Grid");
+        if (combined)
+          writer.writeFields("Coordinates", cf.ndim, cf.ndim, gExtG, lExtG, lOffset, gridPackH, chunkable, cf.compressible);
+        else
+          for (int vn=0; vn<cf.ndim; ++vn)
+            writer.write(format("Dimension{}",vn), cf.ndim, gExtG, lExtG, lOffset, gridPackH+lElemsG*vn, chunkable, cf.compressible);
+        writer.closeGroup();
+      }
+
+      writer.openGroup("/Properties");
+      writer.writeAttribute("title",cf.title);
+      writer.writeAttribute("metadata",cf.metadata);
+      writer.writeAttribute("fiesta_version",std::string(FIESTA_VERSION));
+      writer.writeAttribute("fiesta_options",std::string(FIESTA_OPTIONS));
+      writer.writeAttribute("fiesta_btime",std::string(FIESTA_BTIME));
+      writer.closeGroup();
+    }else if (!open){
+#ifdef HAVE_MPI
+      writer.openAppend(writeComm, MPI_INFO_NULL, hdfPath);
+#else
+      writer.openAppend(hdfPath);
+#endif
+    }
+
+    size_t entry = seriesTimes.size();
+
+    writer.openGroup("/Solution");
+    if (fresh && !describeBounds().empty())
+      writer.writeAttribute("error_bounds",describeBounds());
+    if (combined){
+      writer.writeEntryFields("Fields", entry, cf.ndim, nFields, gExt, lExt, lOffset, packH, chunkable, cf.compressible);
+      if (fresh){
+        string fieldNames;
+        for (auto const& vname : varNames)
+          fieldNames += format(",{}",vname);
+        if (writeVarx)
+          for (auto const& vname : varxNames)
+            fieldNames += format(",{}",vname);
+        if (cf.diagnostics)
+          for (auto const& dname : dgNames)
+            for (int vn = 0; vn < cf.nvt; ++vn)
+              fieldNames += format(",{}-{}",dname,vn);
+        writer.writeAttribute("field_names",fieldNames.substr(1));
+      }
+    }else{
+      T *data = packH;
+      for (size_t vn=0; vn<varNames.size(); ++vn){
+        writer.writeEntry(varNames[vn], entry, cf.ndim, gExt, lExt, lOffset, data, chunkable, cf.compressible);
+        data += lElems;
+      }
+      if (writeVarx){
+        for (size_t vn = 0; vn < varxNames.size(); ++vn) {
+          writer.writeEntry(varxNames[vn], entry, cf.ndim, gExt, lExt, lOffset, data, chunkable, cf.compressible);
+          data += lElems;
+        }
+      }
+      if (cf.diagnostics){
+        for (auto const& dname : dgNames){
+          for (int vn = 0; vn < cf.nvt; ++vn) {
+            writer.writeEntry(fmt::format("{}-{}",dname,vn), entry, cf.ndim, gExt, lExt, lOffset, data, chunkable, cf.compressible);
+            data += lElems;
           }
-          dest[idx] = mean/(stride[0]*stride[1]);
-        }else{
-          dest[idx] = source(i+ng, j+ng, 0,vn);
         }
       }
     }
+    writer.closeGroup();
+
+    writer.openGroup("/Properties");
+    writer.writeEntryValue("Step", entry, tdx, root);
+    writer.writeEntryValue("Time", entry, time, root);
+    writer.closeGroup();
+
+    writer.close();
+    seriesTimes.push_back(time);
+
+    cf.staging->release(lease);
+  }
+
+#ifdef HAVE_MPI
+  MPI_Barrier(reportComm);
+#endif
+
+  if (cf.rank==0){
+    string tuning = h5Settings().summary();
+    if (!tuning.empty()) tuning = format(" [{}]",tuning);
+    Log::message("[{}] '{}': {:.2f} MiB after {:.2f}s{}",cf.t,hdfPath,filesystem::file_size(hdfPath)/1048576.0,writeTimer.check(),tuning);
+  }
+
+  if (myColor==1){
+    writeXMFSeries(xmfPath, hdfName, cf.grid, seriesTimes, cf.ndim, gExt.data(),gOrigin,iodx, varNames.size(), writeVarx,varNames,varxNames,dgNames,combined,!stats);
   }
 }
 
+// describe the error bounds of lossy output for the file attributes, empty
+// when the output is lossless
+template<typename T>
+string blockWriter<T>::describeBounds(){
+  string desc;
+  if (boundDefault.tolerance > 0.0)
+    desc += format(", default {} {}",boundDefault.relative ? "relative" : "absolute",boundDefault.tolerance);
+  for (auto const& [fname, bound] : bounds)
+    desc += format(", {} {} {}",fname,bound.relative ? "relative" : "absolute",bound.tolerance);
+  return desc.empty() ? desc : desc.substr(2);
+}
+
+// apply the error bound of a field to its packed block
+template<typename T>
+void blockWriter<T>::groom(const string& fieldName, Kokkos::View<T*, Kokkos::MemoryUnmanaged>& dest, const size_t offset){
+  auto it = bounds.find(fieldName);
+  errorBound bound = (it == bounds.end()) ? boundDefault : it->second;
+  if (bound.tolerance <= 0.0) return;
+
+  int keep = 0;
+  int tolExp = 0;
+  if (bound.relative)
+    keep = std::max(0, (int)std::ceil(-std::log2(bound.tolerance)-1.0));
+  else
+    tolExp = (int)std::floor(std::log2(bound.tolerance));
+
+  Kokkos::parallel_for(Kokkos::RangePolicy<>(0,lElems), groomBlock<T>(dest, offset, bound.relative, keep, tolExp, (T)bound.tolerance));
+}
+
+template<typename T>
+void blockWriter<T>::pack(int ndim, const FS4D& source, const int vn, Kokkos::View<T*, Kokkos::MemoryUnmanaged>& dest, const size_t offset, const int ng,
+                          const vector<size_t>& extent, const bool average){
+  int ngk = ng;
+  int sk=0, dk=1, ek=1;
+  if (ndim==3){
+    sk = lStart[2];
+    dk = stride[2];
+    ek = extent[2];
+  }else{
+    ngk = 0;
+  }
+
+  policy_f3 pack_pol = policy_f3({0,0,0},{(int)extent[0],(int)extent[1],ek});
+  Kokkos::parallel_for(pack_pol, packBlock<T>(source, dest, vn, offset,
+        lStart[0], lStart[1], sk, stride[0], stride[1], dk, extent[0], extent[1], ng, ngk, average));
+}
+
 template class blockWriter<float>;
 template class blockWriter<double>;
@@ -27,6 +27,14 @@
 #include "kokkosTypes.hpp"
 #include "hdf5.h"
 #include <map>
+#include <future>
+#include <memory>
+
+// error bound for lossy output of a field, a tolerance of zero is lossless
+struct errorBound {
+  FSCAL tolerance = 0.0;
+  bool relative = false;
+};
 
 template <typename T>
 class blockWriter {
@@ -35,8 +43,14 @@ class blockWriter {
     blockWriter(struct inputConfig&,std::unique_ptr<class rk_func>&,std::string,std::string,bool,size_t,bool);
     blockWriter(struct inputConfig&,std::unique_ptr<class rk_func>&,std::string,std::string,bool,size_t,
                                   std::vector<size_t>,std::vector<size_t>,std::vector<size_t>,bool);
+    ~blockWriter();
     void write(struct inputConfig cf, std::unique_ptr<class rk_func>&f, int tdx, FSCAL time);
     size_t frq();
+    void combineFields(bool);
+    void appendSteps(size_t);
+    void compressLossy(errorBound, std::map<std::string,errorBound>, int);
+    void writeStatistics(std::shared_ptr<class runningStats>);
+    void carryStatistics(std::shared_ptr<class runningStats>);
 
   private:
       
@@ -54,7 +68,7 @@ class blockWriter {
     std::vector<size_t> stride;  // slice stride
     std::vector<FSCAL> iodx;
 
-    bool chunkable;
+    bool chunkable = false;
 
     size_t freq;    // block write frequency
 
@@ -70,13 +84,29 @@ class blockWriter {
 #endif
     int myColor;
 
-    std::vector<T> varData;
-    std::vector<T> gridData;
+    bool combined; // write all fields to a single dataset
+    size_t nFields;
+
+    int lease;     // staging buffer holding the packed block
+    T *packH;      // packed solution data in the staging buffer
+    T *gridPackH;  // packed grid data in the staging buffer
+    T *statsPackH; // packed statistics accumulators in the staging buffer
+    std::vector<std::string> varNames;
+    std::vector<std::string> varxNames;
+    std::vector<std::string> dgNames;
 
-    FS4DH gridH;
-    FS4DH varH;
-    FS4DH varxH;
-    std::map<std::string,FS4D> dgmapH;
+    std::shared_ptr<class runningStats> stats;                // statistics written instead of the solution
+    std::vector<std::shared_ptr<class runningStats>> carried; // accumulators written with the solution
+    std::vector<int> carriedSamples;
+
+    bool async;                        // write from the background I/O thread
+    std::shared_future<void> inflight; // previous asynchronous write
+#ifdef HAVE_MPI
+    MPI_Comm writeComm;   // communicator for file writes
+    MPI_Comm reportComm;  // communicator for write completion
+    std::shared_ptr<MPI_Comm> writeDup;  // duplicates for asynchronous writes,
+    std::shared_ptr<MPI_Comm> reportDup; // freed with the last copy of the view
+#endif
 
     bool slicePresent;
     int offsetDelta;
@@ -88,10 +118,26 @@ class blockWriter {
 
     bool appStep;
 
+    bool series;                     // append outputs to time series files
+    size_t seriesSpan;               // outputs per series file, 0 for one file
+    std::string seriesBase;          // series file currently written
+    std::vector<FSCAL> seriesTimes;  // time of each entry in that file
+
+    int deflateLevel;                          // shuffle and deflate level, 0 to disable
+    errorBound boundDefault;                   // error bound of fields not listed
+    std::map<std::string,errorBound> bounds;   // error bound of each listed field
+
+    void initAsync(struct inputConfig&);
+    void groom(const std::string&, Kokkos::View<T*, Kokkos::MemoryUnmanaged>&, const size_t);
+    std::string describeBounds();
+    void snapshot(struct inputConfig&, std::unique_ptr<class rk_func>&);
+    void writeFiles(struct inputConfig, int, FSCAL);
+    void writeSeriesFiles(struct inputConfig, int, FSCAL);
+
     void write_h5(hid_t, std::string, int, std::vector<size_t>, std::vector<size_t>, std::vector<size_t>, std::vector<T>&);
 
-    void dataPack(int, int, const std::vector<size_t>&, const std::vector<size_t>&, const std::vector<size_t>&,
-                            const std::vector<size_t>&, std::vector<T>&, const FS4DH&, const int, const bool);
+    void pack(int, const FS4D&, const int, Kokkos::View<T*, Kokkos::MemoryUnmanaged>&, const size_t, const int,
+                            const std::vector<size_t>&, const bool);
     
 #ifdef HAVE_MPI
     hid_t openHDF5ForWrite(MPI_Comm, MPI_Info, std::string);
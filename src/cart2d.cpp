@@ -61,7 +61,7 @@ cart2d_func::cart2d_func(struct inputConfig &cf_) : rk_func(cf_) {
     varNames.push_back("Debug");
   }
 
-  if (cf.noise) {
+  if (cf.noise || cf.rollbackNoise) {
     noise = FS2D_I("noise", cf.ngi, cf.ngj);         // Noise Indicator
     //varxNames.push_back("Noise");
   }
@@ -79,7 +79,7 @@ cart2d_func::cart2d_func(struct inputConfig &cf_) : rk_func(cf_) {
     varxNames.push_back("C_dvar_v");
   }
 
-  if (cf.noise){
+  if (cf.noise || cf.rollbackNoise){
     varxNames.push_back("Noise_I");
     varxNames.push_back("Noise_C");
     varxNames.push_back("Noise_D");
@@ -128,7 +128,7 @@ cart2d_func::cart2d_func(struct inputConfig &cf_) : rk_func(cf_) {
   if (cf.ceq) {
     timers["ceq"] = Timer::fiestaTimer("C-Equation");
   }
-  if (cf.noise) {
+  if (cf.noise || cf.rollbackNoise) {
     timers["noise"] = Timer::fiestaTimer("Noise Removal");
   }
 };
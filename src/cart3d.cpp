@@ -40,23 +40,18 @@
 #include "buoyancy.hpp"
 #include "viscosity.hpp"
 #include "diagnostics.hpp"
+#include "trace.hpp"
 
 cart3d_func::cart3d_func(struct inputConfig &cf_) : rk_func(cf_) {
-  size_t memEstimate = 3*cf.nvt+6;
-  if (cf.visc==1) memEstimate += 30;
-  if (cf.ceq==1) memEstimate += 11;
+  size_t cells = (size_t)cf.ngi*cf.ngj*cf.ngk;
 
-  memEstimate *= (cf.ngi*cf.ngj*cf.ngk);
-  memEstimate += 3*(cf.ni+cf.nj+cf.nk);
-  memEstimate *= 8;  // 8 bytes per FSCAL
-  FSCAL memEstimateMB = memEstimate/(1048576.0);
-  FSCAL memEstGlobalMB = 0.0;
-
-#ifdef HAVE_MPI
-  MPI_Allreduce(&memEstimateMB, &memEstGlobalMB, 1, MPI_DOUBLE, MPI_SUM, cf.comm);
-#endif
-
-  Log::message("Minimum device memory estimate: {:.2f}MiB",memEstGlobalMB);
+  // Temporaries are only live within one region, and are leased from a
+  // scratch arena sized for the largest of them
+  scratch.reserve({3*cells*sizeof(FSCAL)});                                  // flux
+  if (cf.visc) scratch.reserve({6*cells*sizeof(FSCAL)});                     // visc
+  if (cf.ceq) scratch.reserve({5*cells*sizeof(FSCAL), 27*cells*sizeof(FSCAL)}); // ceq
+  if (cf.noise) scratch.reserve({cells*sizeof(int)});                        // noise
+  scratch.allocate();
 
   var     = FS4D("var",       cf.ngi, cf.ngj, cf.ngk, cf.nvt); // Primary Vars
   tmp1    = FS4D( "tmp1",     cf.ngi, cf.ngj, cf.ngk, cf.nvt); // Temp Vars
@@ -70,26 +65,11 @@ cart3d_func::cart3d_func(struct inputConfig &cf_) : rk_func(cf_) {
   rho     = FS3D("rho",       cf.ngi, cf.ngj, cf.ngk);         // Total Density
   vel     = FS4D("vel",       cf.ngi, cf.ngj, cf.ngk,3);         // Total Density
 
-  fluxx   = FS3D( "fluxx",    cf.ngi, cf.ngj, cf.ngk);    // Advective Fluxes X
-  fluxy   = FS3D( "fluxy",    cf.ngi, cf.ngj, cf.ngk);    // Advective Fluxes Y
-  fluxz   = FS3D( "fluxz",    cf.ngi, cf.ngj, cf.ngk);    // Advective Fluxes Z
-
-  if (cf.visc == 1) {
-    //qx      = FS3D( "qx",       cf.ngi, cf.ngj, cf.ngk);         // Heat Flux X
-    //qy      = FS3D( "qy",       cf.ngi, cf.ngj, cf.ngk);         // Heat Flux Y
-    //qz      = FS3D( "qz",       cf.ngi, cf.ngj, cf.ngk);         // Heat Flux Z
-    //stressx = FS5D( "stressx",  cf.ngi, cf.ngj, cf.ngk, 3, 3); // stress tensor X
-    //stressy = FS5D( "stressy",  cf.ngi, cf.ngj, cf.ngk, 3, 3); // stress tensor Y
-    //stressz = FS5D( "stressz",  cf.ngi, cf.ngj, cf.ngk, 3, 3); // stress tensor Z
-    stress = FS4D( "stress",  cf.ngi, cf.ngj, cf.ngk, 6); // stress tensor Z
-  }
-  if (cf.ceq) {
-    gradRho = FS4D( "gradRho",  cf.ngi, cf.ngj, cf.ngk, 5);    // Density Gradien
-    cFlux   = FS4D("cFlux",     cf.ngi, cf.ngj, cf.ngk, 3);    // 
-    mFlux   = FS6D("mFlux", 3,3,cf.ngi, cf.ngj, cf.ngk, 3);    //
-  }
-  if (cf.noise) {
-    noise = FS3D_I("noise", cf.ngi, cf.ngj, cf.ngk);
+  // rectilinear grids keep their node coordinates for output and the cell
+  // widths for the kernels
+  if (cf.grid == 3) {
+    grid    = FS4D("coords",    cf.ni,  cf.nj,  cf.nk,  3);      // Grid Coords
+    rg      = rectGrid(cf);
   }
 
   if (cf.diagnostics) dg = Diagnostics(cf.ng,cf.ngi,cf.ngj,cf.ngk,cf.nvt,cf.stat_freq);
@@ -139,7 +119,7 @@ cart3d_func::cart3d_func(struct inputConfig &cf_) : rk_func(cf_) {
     if (cf.ceq) {
       timers["ceq"] = Timer::fiestaTimer("C-Equation");
     }
-    if (cf.noise) {
+    if (cf.noise || cf.rollbackNoise) {
       timers["noise"] = Timer::fiestaTimer("Noise Filter");
     }
     if (cf.buoyancy) {
@@ -171,6 +151,9 @@ cart3d_func::cart3d_func(struct inputConfig &cf_) : rk_func(cf_) {
   Kokkos::deep_copy(cd, hostcd); // copy congifuration array to device
 
   dxmag = cf.dx*cf.dx + cf.dy*cf.dy + cf.dz*cf.dz;
+#ifdef HAVE_MPI
+  ceqReq = MPI_REQUEST_NULL;
+#endif
 };
 
 void cart3d_func::preSim() {
@@ -187,14 +170,37 @@ void cart3d_func::preSim() {
 void cart3d_func::preStep() {
 }
 
-template<typename T>
-FSCAL fsMax(const struct inputConfig &cf, policy_f3 &pol, T func){
-    FSCAL localmax, max;
-    Kokkos::parallel_reduce(pol, func, Kokkos::Max<FSCAL>(localmax));
-    #ifdef HAVE_MPI
-      MPI_Allreduce(&localmax, &max, 1, MPI_DOUBLE, MPI_MAX, cf.comm);
-    #endif
-    return max;
+// Global maximum wave speed and C_hat magnitude for the C-equation update.
+// Both maxima are computed with a single reducer and a single allreduce.  With
+// ceq.lagged enabled the allreduce is nonblocking and the maxima from the
+// previous stage are returned instead, removing the global synchronization
+// from the critical path.
+void cart3d_func::ceqMaxima(policy_f3 &pol, FSCAL &maxS, FSCAL &maxCh){
+  FSCAL lmax[2];
+  Kokkos::parallel_reduce(pol, maxCeqFunctor(var,p,rho,cd,cf.nv+1), lmax);
+#ifdef HAVE_MPI
+  Trace::begin("MPI C-Equation Maxima");
+  if (cf.ceqLagged){
+    bool first = (ceqReq == MPI_REQUEST_NULL);
+    if (!first)
+      MPI_Wait(&ceqReq, MPI_STATUS_IGNORE);
+    ceqSend[0] = lmax[0];
+    ceqSend[1] = lmax[1];
+    if (first)
+      MPI_Allreduce(ceqSend, ceqRecv, 2, MPI_FSCAL, MPI_MAX, cf.comm);
+    maxS  = ceqRecv[0];
+    maxCh = ceqRecv[1];
+    MPI_Iallreduce(ceqSend, ceqRecv, 2, MPI_FSCAL, MPI_MAX, cf.comm, &ceqReq);
+  }else{
+    MPI_Allreduce(lmax, ceqRecv, 2, MPI_FSCAL, MPI_MAX, cf.comm);
+    maxS  = ceqRecv[0];
+    maxCh = ceqRecv[1];
+  }
+  Trace::end();
+#else
+  maxS  = lmax[0];
+  maxCh = lmax[1];
+#endif
 }
 
 inline
@@ -202,6 +208,8 @@ void cart3d_func::pushRegion(std::string name, bool saveDvar){
   if (cf.diagnostics){ 
     if (saveDvar) dg.start(cf.t,dvar);
     timers[name].reset();
+  }else{
+    Trace::begin(name);
   }
 }
 
@@ -214,6 +222,9 @@ void cart3d_func::popRegion(std::string name, bool saveDvar){
       Kokkos::fence();
       dg.stop(name,cf.t,dvar,dgmap);
     }
+  }else if (Trace::active()){
+    Kokkos::fence();
+    Trace::end();
   }
 }
 
@@ -240,15 +251,30 @@ void cart3d_func::compute() {
   Kokkos::parallel_for(ghost_pol, computeVelocity3D(var, rho, vel));
   popRegion("calcSecond",false);
 
+  // rectilinear grids divide the face fluxes by the widths of each cell
   pushRegion("flux",true);
+  {
+  scratchArena::region r(scratch);
+  FS3D fluxx = r.get<FS3D>(cf.ngi, cf.ngj, cf.ngk);
+  FS3D fluxy = r.get<FS3D>(cf.ngi, cf.ngj, cf.ngk);
+  FS3D fluxz = r.get<FS3D>(cf.ngi, cf.ngj, cf.ngk);
   for (int v = 0; v < cf.nv; ++v) {
-    Kokkos::parallel_for(tile_pol, calculateFluxesG(var, p, rho, vel, fluxx, fluxy, fluxz, cf.dx, cf.dy, cf.dz, v));
-    Kokkos::parallel_for(cell_pol, advect3D(dvar, varx, fluxx, fluxy, fluxz, v));
+    if (cf.grid == 3) {
+      Kokkos::parallel_for(tile_pol, calculateFluxesG(var, p, rho, vel, fluxx, fluxy, fluxz, 1.0, 1.0, 1.0, v));
+      Kokkos::parallel_for(cell_pol, advectRect3D(dvar, fluxx, fluxy, fluxz, rg, v));
+    } else {
+      Kokkos::parallel_for(tile_pol, calculateFluxesG(var, p, rho, vel, fluxx, fluxy, fluxz, cf.dx, cf.dy, cf.dz, v));
+      Kokkos::parallel_for(cell_pol, advect3D(dvar, varx, fluxx, fluxy, fluxz, v));
+    }
+  }
   }
   popRegion("flux",true);
 
   pushRegion("pressgrad",true);
-  Kokkos::parallel_for(cell_pol, applyPressureGradient3D(dvar, varx, p, cd));
+  if (cf.grid == 3)
+    Kokkos::parallel_for(cell_pol, applyRectPressureGradient3D(dvar, p, rg));
+  else
+    Kokkos::parallel_for(cell_pol, applyPressureGradient3D(dvar, varx, p, cd));
   popRegion("pressgrad",true);
 
   if (cf.buoyancy) {
@@ -259,15 +285,24 @@ void cart3d_func::compute() {
 
   if (cf.visc){
     pushRegion("visc",true);
+    scratchArena::region r(scratch);
+    FS4D stress = r.get<FS4D>(cf.ngi, cf.ngj, cf.ngk, 6);
     //Kokkos::parallel_for(weno_pol, calculateStressTensor3dv(var, rho, vel, stressx, stressy, stressz, cd));
     //Kokkos::parallel_for(weno_pol, calculateHeatFlux3dv(var, rho, T, qx, qy, qz, cd));
     //Kokkos::parallel_for(cell_pol, applyViscousTerm3dv(dvar, var, rho, vel, stressx, stressy, stressz, qx, qy, qz, cd));
-    Kokkos::parallel_for(weno_pol, calculateStressTensorx3dv(var, rho, vel, stress, cd));
-    Kokkos::parallel_for(cell_pol, applyViscousTermx3dv(dvar, var, rho, vel, stress, cd));
-    Kokkos::parallel_for(weno_pol, calculateStressTensory3dv(var, rho, vel, stress, cd));
-    Kokkos::parallel_for(cell_pol, applyViscousTermy3dv(dvar, var, rho, vel, stress, cd));
-    Kokkos::parallel_for(weno_pol, calculateStressTensorz3dv(var, rho, vel, stress, cd));
-    Kokkos::parallel_for(cell_pol, applyViscousTermz3dv(dvar, var, rho, vel, stress, cd));
+    if (cf.grid == 3) {
+      for (int dir = 0; dir < 3; ++dir) {
+        Kokkos::parallel_for(weno_pol, calculateRectStressTensor3dv(var, rho, vel, stress, rg, cd, dir));
+        Kokkos::parallel_for(cell_pol, applyRectViscousTerm3dv(dvar, vel, stress, rg, dir));
+      }
+    } else {
+      Kokkos::parallel_for(weno_pol, calculateStressTensorx3dv(var, rho, vel, stress, cd));
+      Kokkos::parallel_for(cell_pol, applyViscousTermx3dv(dvar, var, rho, vel, stress, cd));
+      Kokkos::parallel_for(weno_pol, calculateStressTensory3dv(var, rho, vel, stress, cd));
+      Kokkos::parallel_for(cell_pol, applyViscousTermy3dv(dvar, var, rho, vel, stress, cd));
+      Kokkos::parallel_for(weno_pol, calculateStressTensorz3dv(var, rho, vel, stress, cd));
+      Kokkos::parallel_for(cell_pol, applyViscousTermz3dv(dvar, var, rho, vel, stress, cd));
+    }
     popRegion("visc",true);
   }
 
@@ -275,19 +310,30 @@ void cart3d_func::compute() {
     pushRegion("ceq",true);
     FSCAL maxS,maxCh,alpha;
     /* FSCAL maxC; */
+    scratchArena::region r(scratch);
+    FS4D gradRho = r.get<FS4D>(cf.ngi, cf.ngj, cf.ngk, 5);
+    FS6D mFlux = r.get<FS6D>(3, 3, cf.ngi, cf.ngj, cf.ngk, 3);
 
-    Kokkos::parallel_for(cell_pol, calculateRhoGrad(var, vel, rho, gradRho, cf.dx, cf.dy, cf.dz));
+    if (cf.grid == 3)
+      Kokkos::parallel_for(cell_pol, calculateRectRhoGrad(var, vel, rho, gradRho, rg));
+    else
+      Kokkos::parallel_for(cell_pol, calculateRhoGrad(var, vel, rho, gradRho, cf.dx, cf.dy, cf.dz));
 
-    maxS  = fsMax(cf, cell_pol, maxWaveSpeed(var,p,rho,cd));
-    /* maxC  = fsMax(cf, cell_pol, maxGradFunctor(var, cf.nv+0)); */
-    maxCh = fsMax(cf, cell_pol, maxGradFunctor(var, cf.nv+1));
+    ceqMaxima(cell_pol, maxS, maxCh);
 
     alpha = (dxmag / (maxCh+1.0e-6)) * cf.alpha;
 
-    Kokkos::parallel_for(cell_pol, updateCeq(dvar, var, varx, gradRho, maxS, cd, cf.kap, cf.eps));
-    Kokkos::parallel_for(weno_pol, calculateCeqFaces(var, varx, rho, mFlux, alpha, cf.nv));
-    Kokkos::parallel_for(weno_pol, calculateCeqGrads(vel, mFlux, cf.dx, cf.dy, cf.dz));
-    Kokkos::parallel_for(cell_pol, applyCeq(dvar, varx, mFlux, cf.dx, cf.dy, cf.dz));
+    if (cf.grid == 3) {
+      Kokkos::parallel_for(cell_pol, updateRectCeq(dvar, var, gradRho, maxS, rg, cd, cf.kap, cf.eps));
+      Kokkos::parallel_for(weno_pol, calculateCeqFaces(var, varx, rho, mFlux, alpha, cf.nv));
+      Kokkos::parallel_for(weno_pol, calculateRectCeqGrads(vel, mFlux, rg));
+      Kokkos::parallel_for(cell_pol, applyRectCeq(dvar, mFlux, rg));
+    } else {
+      Kokkos::parallel_for(cell_pol, updateCeq(dvar, var, varx, gradRho, maxS, cd, cf.kap, cf.eps));
+      Kokkos::parallel_for(weno_pol, calculateCeqFaces(var, varx, rho, mFlux, alpha, cf.nv));
+      Kokkos::parallel_for(weno_pol, calculateCeqGrads(vel, mFlux, cf.dx, cf.dy, cf.dz));
+      Kokkos::parallel_for(cell_pol, applyCeq(dvar, varx, mFlux, cf.dx, cf.dy, cf.dz));
+    }
     popRegion("ceq",true);
   }
 
@@ -364,15 +410,21 @@ void cart3d_func::postStep() {
     }
 
     pushRegion("noise",true);
+    scratchArena::region r(scratch);
+    FS3D_I noise = r.get<FS3D_I>(cf.ngi, cf.ngj, cf.ngk);
     for (auto v : noise_variables) {
       Kokkos::parallel_for(noise_pol, detectNoise3D(var, varx, noise, cf.n_dh, coff, cd, v));
       for (int tau = 0; tau < cf.n_nt; ++tau) {
         Kokkos::parallel_for(cell_pol, removeNoise3D(dvar, var, varx, noise, cf.n_eta, cd, v));
       }
     }
-    pushRegion("noise",true);
+    popRegion("noise",true);
   } // end noise
 }
 
 void cart3d_func::postSim() {
+#ifdef HAVE_MPI
+  if (ceqReq != MPI_REQUEST_NULL)
+    MPI_Wait(&ceqReq, MPI_STATUS_IGNORE);
+#endif
 }
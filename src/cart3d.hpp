@@ -24,6 +24,8 @@
 #include "kokkosTypes.hpp"
 #include "input.hpp"
 #include "rkfunction.hpp"
+#include "rectilinear.hpp"
+#include "scratch.hpp"
 
 class cart3d_func : public rk_func {
 
@@ -36,6 +38,7 @@ public:
   void postSim();
   void pushRegion(std::string name, bool saveDvar);
   void popRegion(std::string name, bool saveDvar);
+  void ceqMaxima(policy_f3 &pol, FSCAL &maxS, FSCAL &maxCh);
 
   FS3D p;       // Pressure
   FS3D T;       // Temperature
@@ -44,19 +47,18 @@ public:
   FS3D qx;      // Heat Fluxes in X direction
   FS3D qy;      // Heat Fluxes in Y direction
   FS3D qz;      // Heat Fluxes in Z direction
-  FS3D fluxx;   // Weno Fluxes in X direction
-  FS3D fluxy;   // Weno Fluxes in Y direction
-  FS3D fluxz;   // Weno Fluxes in Z direction
-  FS4D stress; // Stress tensor on X faces
   FS5D stressx; // Stress tensor on X faces
   FS5D stressy; // Stress tensor on Y faces
   FS5D stressz; // Stress tensor on Z faces
-  FS4D gradRho; // Density Gradient array
-  FS4D cFlux;
-  FS6D mFlux;
-  FS3D_I noise;
   FS1D cd; // Device configuration array
+  rectGrid rg;  // Cell widths of rectilinear grids
+  scratchArena scratch; // Fluxes, stresses, gradients and noise flags, leased per region
   FSCAL dxmag;
+#ifdef HAVE_MPI
+  FSCAL ceqSend[2];        // Local C-equation maxima in flight
+  FSCAL ceqRecv[2];        // Global C-equation maxima
+  MPI_Request ceqReq;      // Pending lagged C-equation reduction
+#endif
 };
 
 #endif
@@ -21,6 +21,7 @@
 #ifndef CEQ3D_HPP
 #define CEQ3D_HPP
 #include <cstdio>
+#include "rectilinear.hpp"
 
 struct maxWaveSpeed {
   FS4D var;
@@ -92,6 +93,37 @@ struct maxGradFunctor {
   }
 };
 
+// Combined reduction of the maximum wave speed and the maximum magnitude of
+// variable n, so both C-equation coefficients need only one pass and one
+// global reduction.  r[0] = max wave speed, r[1] = max |var(n)|.
+struct maxCeqFunctor {
+  typedef FSCAL value_type[];
+  unsigned value_count;
+  maxWaveSpeed waveSpeed;
+  maxGradFunctor grad;
+
+  maxCeqFunctor(FS4D var_, FS3D p_, FS3D rho_, Kokkos::View<FSCAL *> cd_, int n_)
+      : value_count(2), waveSpeed(var_, p_, rho_, cd_), grad(var_, n_) {}
+
+  KOKKOS_INLINE_FUNCTION
+  void operator()(const int i, const int j, const int k, value_type lmax) const {
+    waveSpeed(i, j, k, lmax[0]);
+    grad(i, j, k, lmax[1]);
+  }
+
+  KOKKOS_INLINE_FUNCTION
+  void join(volatile value_type dst, const volatile value_type src) const {
+    for (int n = 0; n < 2; ++n)
+      if (src[n] > dst[n]) dst[n] = src[n];
+  }
+
+  KOKKOS_INLINE_FUNCTION
+  void init(value_type lmax) const {
+    for (int n = 0; n < 2; ++n)
+      lmax[n] = Kokkos::reduction_identity<FSCAL>::max();
+  }
+};
+
 struct calculateRhoGrad {
   FS4D var,vel;
   FS3D rho;
@@ -142,6 +174,12 @@ struct calculateRhoGrad {
 
   KOKKOS_INLINE_FUNCTION
   void operator()(const int i, const int j, const int k) const {
+    gradient(i,j,k,dx,dy,dz);
+  }
+
+  KOKKOS_INLINE_FUNCTION
+  void gradient(const int i, const int j, const int k,
+                const FSCAL dx, const FSCAL dy, const FSCAL dz) const {
     FSCAL dxr = derivRho(i,j,k,1,0,0,dx);
     FSCAL dyr = derivRho(i,j,k,0,1,0,dy);
     FSCAL dzr = derivRho(i,j,k,0,0,1,dz);
@@ -186,6 +224,20 @@ struct calculateRhoGrad {
   }
 };
 
+// density gradient and shock and contact detection on a rectilinear grid,
+// the central differences divided by the cell center spacing
+struct calculateRectRhoGrad : calculateRhoGrad {
+  rectGrid rg;
+
+  calculateRectRhoGrad(FS4D var_, FS4D vel_, FS3D rho_, FS4D gradRho_, rectGrid rg_)
+      : calculateRhoGrad(var_, vel_, rho_, gradRho_, 1.0, 1.0, 1.0), rg(rg_) {}
+
+  KOKKOS_INLINE_FUNCTION
+  void operator()(const int i, const int j, const int k) const {
+    gradient(i,j,k,rg.metric(0,i),rg.metric(1,j),rg.metric(2,k));
+  }
+};
+
 struct updateCeq {
   FS4D dvar;
   FS4D var;
@@ -223,6 +275,42 @@ struct updateCeq {
   }
 };
 
+struct updateRectCeq {
+  FS4D dvar;
+  FS4D var;
+  FS4D gradRho;
+  FSCAL maxS, kap, eps;
+  rectGrid rg;
+  Kokkos::View<FSCAL *> cd;
+
+  updateRectCeq(FS4D dvar_, FS4D var_, FS4D gradRho_, FSCAL maxS_, rectGrid rg_,
+                Kokkos::View<FSCAL *> cd_, FSCAL kap_, FSCAL eps_)
+      : dvar(dvar_), var(var_), gradRho(gradRho_), maxS(maxS_), kap(kap_), eps(eps_),
+        rg(rg_), cd(cd_) {}
+
+  KOKKOS_INLINE_FUNCTION
+  void operator()(const int i, const int j, const int k) const {
+    FSCAL dx = rg.width(0,i);
+    FSCAL dy = rg.width(1,j);
+    FSCAL dz = rg.width(2,k);
+
+    int nc = (int)cd(0) + 4;
+
+    FSCAL lap;
+
+    // size of this cell
+    FSCAL dxmag = sqrt(dx*dx + dy*dy + dz*dz);
+
+    for (int n = 0; n < 5; ++n) {
+      lap = (var(i-1,j,k,nc+n)-2*var(i,j,k,nc+n)+var(i+1,j,k,nc+n))/dx
+          + (var(i,j-1,k,nc+n)-2*var(i,j,k,nc+n)+var(i,j+1,k,nc+n))/dy
+          + (var(i,j,k-1,nc+n)-2*var(i,j,k,nc+n)+var(i,j,k+1,nc+n))/dz;
+
+      dvar(i,j,k,nc+n) = (maxS/(eps*dxmag))*(gradRho(i,j,k,n)-var(i,j,k,nc+n)) + kap*maxS*dxmag*lap;
+    }
+  }
+};
+
 struct calculateCeqFaces {
   FS4D var,varx;
   FS3D rho;
@@ -364,4 +452,70 @@ struct applyCeq {
     }
   }
 };
+
+// velocity gradients on the cell faces of a rectilinear grid, each divided by
+// the distance between the cell centers it spans
+struct calculateRectCeqGrads {
+  FS4D vel;
+  FS6D mFlux;
+  rectGrid rg;
+
+  calculateRectCeqGrads(FS4D vel_, FS6D mFlux_, rectGrid rg_)
+      : vel(vel_), mFlux(mFlux_), rg(rg_) {}
+
+  KOKKOS_INLINE_FUNCTION
+  void operator()(const int i, const int j, const int k) const {
+    int c[3] = {i, j, k};
+
+    for (int face=0; face<3; ++face){
+      int ih = (face == 0), jh = (face == 1), kh = (face == 2);
+      for (int dir=0; dir<3; ++dir){
+        if (dir == face){
+          FSCAL d = rg.face(dir,c[dir]);
+          for (int w = 0; w < 3; ++w)
+            mFlux(face,dir,i,j,k,w) *= (vel(i+ih,j+jh,k+kh,w) - vel(i,j,k,w)) / d;
+        }else{
+          int id = (dir == 0), jd = (dir == 1), kd = (dir == 2);
+          FSCAL d = 4.0*rg.span(dir,c[dir]);
+          for (int w = 0; w < 3; ++w)
+            mFlux(face,dir,i,j,k,w) *= ( (vel(i+id,j+jd,k+kd,w) + vel(i+ih+id,j+jh+jd,k+kh+kd,w))
+                                        -(vel(i-id,j-jd,k-kd,w) + vel(i+ih-id,j+jh-jd,k+kh-kd,w)) ) / d;
+        }
+      }
+    }
+  }
+};
+
+struct applyRectCeq {
+  FS4D dvar;
+  FS6D mFlux;
+  rectGrid rg;
+
+  applyRectCeq(FS4D dvar_, FS6D mFlux_, rectGrid rg_)
+      : dvar(dvar_), mFlux(mFlux_), rg(rg_) {}
+
+  KOKKOS_INLINE_FUNCTION
+  void operator()(const int i, const int j, const int k) const {
+    FSCAL diffu;
+    int ih, jh, kh;
+    FSCAL d[3];
+    d[0]=rg.width(0,i);
+    d[1]=rg.width(1,j);
+    d[2]=rg.width(2,k);
+
+    for (int w = 0; w < 3; ++w) {
+      diffu = 0.0;
+      for (int face=0; face<3; ++face){
+        ih = 0; jh = 0; kh = 0;
+        if (face == 0) ih = 1;
+        if (face == 1) jh = 1;
+        if (face == 2) kh = 1;
+        for (int dir=0; dir<3; ++dir){
+          diffu += (mFlux(face,dir,i,j,k,w)-mFlux(face,dir,i-ih,j-jh,k-kh,w))/d[face];
+        }
+      }
+      dvar(i,j,k,w) += diffu;
+    }
+  }
+};
 #endif
@@ -0,0 +1,397 @@
+/*
+  Copyright 2019-2021 The University of New Mexico
+
+  This file is part of FIESTA.
+  
+  FIESTA is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+  
+  FIESTA is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+  
+  You should have received a copy of the GNU Lesser General Public License
+  along with FIESTA.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "checkpoint.hpp"
+#include "input.hpp"
+#include "iothread.hpp"
+#include "staging.hpp"
+#include "log2.hpp"
+#include "timer.hpp"
+#include "fmt/core.h"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <regex>
+#ifdef HAVE_MPI
+#include "mpi.h"
+#endif
+
+#define FIESTA_CHECKPOINT_VERSION 1
+
+typedef Kokkos::View<FSCAL****, FS_LAYOUT, Kokkos::HostSpace, Kokkos::MemoryUnmanaged> FS4DU;
+
+// 64 bit FNV-1a over whole words, used to validate checkpoint files
+uint64_t checksum(const char *data, size_t n){
+  uint64_t h = 14695981039346656037ull;
+  size_t nw = n/sizeof(uint64_t);
+  uint64_t w;
+  for (size_t i=0; i<nw; ++i){
+    memcpy(&w, data+i*sizeof(uint64_t), sizeof(uint64_t));
+    h = (h ^ w) * 1099511628211ull;
+  }
+  for (size_t i=nw*sizeof(uint64_t); i<n; ++i)
+    h = (h ^ (unsigned char)data[i]) * 1099511628211ull;
+  return h;
+}
+
+#ifdef HAVE_MPI
+// Swap byte buffers of arbitrary size with a partner rank
+static void exchangeBytes(const char *send, size_t sendBytes, std::vector<char>& recv, int partner, MPI_Comm comm){
+  size_t recvBytes;
+  MPI_Sendrecv(&sendBytes, sizeof(size_t), MPI_BYTE, partner, 0,
+               &recvBytes, sizeof(size_t), MPI_BYTE, partner, 0, comm, MPI_STATUS_IGNORE);
+  recv.resize(recvBytes);
+
+  const size_t chunk = INT_MAX;
+  for (size_t off=0; off<std::max(sendBytes,recvBytes); off+=chunk){
+    int ns = (off < sendBytes) ? std::min(chunk, sendBytes-off) : 0;
+    int nr = (off < recvBytes) ? std::min(chunk, recvBytes-off) : 0;
+    MPI_Sendrecv(ns ? send+off : nullptr, ns, MPI_BYTE, partner, 1,
+                 nr ? recv.data()+off : nullptr, nr, MPI_BYTE, partner, 1, comm, MPI_STATUS_IGNORE);
+  }
+}
+#endif
+
+// Write a buffer to a temporary file and move it into place, so a checkpoint
+// interrupted part way through is never mistaken for a complete one.
+static void writeFile(std::string path, const char *data, size_t bytes){
+  std::string tmp = path + ".tmp";
+  std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+  out.write(data, bytes);
+  out.close();
+  if (out.fail()){
+    Log::warning("Could not write checkpoint '{}'",path);
+    std::filesystem::remove(tmp);
+    return;
+  }
+  std::filesystem::rename(tmp, path);
+}
+
+checkpointManager::checkpointManager(struct inputConfig &cf):
+  localPath(cf.checkpointPath),
+  drainPath(fmt::format("{}/checkpoint",cf.pathName)),
+  keep(cf.checkpointKeep),
+  drainFreq(cf.checkpointDrain),
+  partner(cf.checkpointPartner),
+  count(0) {
+
+  if (keep < 1) keep = 1;
+
+  // Partners are half the job apart so they are unlikely to share a node.
+  int half = cf.numProcs/2;
+  if (cf.rank < half)
+    partnerRank = cf.rank + half;
+  else if (cf.rank < 2*half)
+    partnerRank = cf.rank - half;
+  else
+    partnerRank = -1;
+  if (partnerRank < 0)
+    partner = false;
+
+  // every node needs its own local directory
+  std::error_code ec;
+  std::filesystem::create_directories(localPath, ec);
+  if (!std::filesystem::is_directory(localPath)){
+    Log::error("Could not create checkpoint directory '{}'.",localPath);
+    exit(EXIT_FAILURE);
+  }
+
+  // the drain directory is shared, so it is created once and every rank waits
+  // for it before its first drain
+  if (drainFreq > 0){
+    int ok = 1;
+    if (cf.rank == 0){
+      std::filesystem::create_directories(drainPath, ec);
+      ok = std::filesystem::is_directory(drainPath);
+    }
+#ifdef HAVE_MPI
+    MPI_Bcast(&ok, 1, MPI_INT, 0, cf.comm);
+#endif
+    if (!ok){
+      Log::warning("Could not create checkpoint drain directory '{}': {}.  Checkpoints will not be drained.",
+                   drainPath,ec.message());
+      drainFreq = 0;
+    }
+  }
+
+  // generations left by a previous run count towards the number kept
+  std::regex pattern(fmt::format("checkpoint-(\\d+)\\.{}",cf.rank));
+  for (auto const& entry : std::filesystem::directory_iterator(localPath)){
+    std::smatch m;
+    std::string name = entry.path().filename().string();
+    if (std::regex_match(name, m, pattern))
+      generations.push_back(std::stoi(m[1]));
+  }
+  std::sort(generations.begin(), generations.end());
+}
+
+// wait for any local write or drain still using the staging buffers
+checkpointManager::~checkpointManager(){
+  if (inflight.valid())
+    inflight.wait();
+}
+
+std::string checkpointManager::fileName(std::string dir, std::string kind, int t, int rank){
+  return fmt::format("{}/{}-{}.{}",dir,kind,t,rank);
+}
+
+checkpointManager::header checkpointManager::makeHeader(struct inputConfig &cf, std::unique_ptr<class rk_func>&f, int t, FSCAL time){
+  header hd;
+  memset(&hd, 0, sizeof(header));
+  memcpy(hd.magic, "FIESTACP", 8);
+  hd.version = FIESTA_CHECKPOINT_VERSION;
+  hd.t = t;
+  hd.time = time;
+  hd.rank = cf.rank;
+  hd.numProcs = cf.numProcs;
+  for (int d=0; d<4; ++d){
+    hd.varExt[d] = f->var.extent(d);
+    hd.gridExt[d] = f->grid.extent(d);
+  }
+  hd.bytes = (f->var.size() + f->grid.size())*sizeof(FSCAL);
+  return hd;
+}
+
+// Copy var and grid to a staging buffer laid out as the checkpoint file, a
+// header followed by the raw views, and hand the file writes to the I/O thread.
+void checkpointManager::write(struct inputConfig &cf, std::unique_ptr<class rk_func>&f, int t, FSCAL time){
+  // Backpressure: the previous checkpoint must be on disk before the partner
+  // copy is overwritten.
+  if (inflight.valid() && inflight.wait_for(std::chrono::seconds(0)) != std::future_status::ready){
+    Timer::fiestaTimer waitTimer = Timer::fiestaTimer();
+    inflight.wait();
+    Log::debug("[{}] Waited {:.2f}s for previous checkpoint",cf.t,waitTimer.check());
+  }
+
+  header hd = makeHeader(cf,f,t,time);
+  size_t total = sizeof(header) + hd.bytes;
+
+  int lease = cf.staging->acquire(total);
+  char *buf = cf.staging->host<char>(lease, total).data();
+  FSCAL *data = reinterpret_cast<FSCAL *>(buf + sizeof(header));
+
+  FS4DU varH(data, hd.varExt[0], hd.varExt[1], hd.varExt[2], hd.varExt[3]);
+  FS4DU gridH(data + f->var.size(), hd.gridExt[0], hd.gridExt[1], hd.gridExt[2], hd.gridExt[3]);
+  Kokkos::deep_copy(varH, f->var);
+  Kokkos::deep_copy(gridH, f->grid);
+  Kokkos::fence();
+
+  hd.checksum = checksum(buf + sizeof(header), hd.bytes);
+  memcpy(buf, &hd, sizeof(header));
+
+#ifdef HAVE_MPI
+  if (partner)
+    exchangeBytes(buf, total, partnerCopy, partnerRank, cf.comm);
+#endif
+
+  // choose generations to retire
+  std::vector<int> expired;
+  generations.erase(std::remove(generations.begin(), generations.end(), t), generations.end());
+  generations.push_back(t);
+  while (generations.size() > (size_t)keep){
+    expired.push_back(generations.front());
+    generations.erase(generations.begin());
+  }
+
+  ++count;
+  bool drain = drainFreq > 0 && count % drainFreq == 0;
+
+  Log::message("[{}] Writing checkpoint to '{}'",cf.t,localPath);
+
+  auto staging = cf.staging;
+  int rank = cf.rank;
+  inflight = ioThread::instance().push([this,staging,lease,buf,total,t,rank,drain,expired](){
+    Timer::fiestaTimer writeTimer = Timer::fiestaTimer();
+    std::string local = fileName(localPath,"checkpoint",t,rank);
+
+    writeFile(local, buf, total);
+    staging->release(lease);
+
+    if (partner)
+      writeFile(fileName(localPath,"partner",t,partnerRank), partnerCopy.data(), partnerCopy.size());
+
+    for (int e : expired){
+      std::filesystem::remove(fileName(localPath,"checkpoint",e,rank));
+      std::filesystem::remove(fileName(localPath,"partner",e,partnerRank));
+    }
+    Log::debugAll("Checkpoint {} written in {:.3f}s",t,writeTimer.check());
+
+    if (drain){
+      std::string target = fileName(drainPath,"checkpoint",t,rank);
+      std::error_code ec;
+      std::filesystem::copy_file(local, target+".tmp", std::filesystem::copy_options::overwrite_existing, ec);
+      if (ec){
+        Log::debugAll("Could not drain checkpoint {} to '{}': {}",t,drainPath,ec.message());
+      }else{
+        std::filesystem::rename(target+".tmp", target);
+        // keep as many drained generations as local ones
+        std::regex pattern(fmt::format("checkpoint-(\\d+)\\.{}",rank));
+        std::vector<int> drained;
+        for (auto const& entry : std::filesystem::directory_iterator(drainPath)){
+          std::smatch m;
+          std::string name = entry.path().filename().string();
+          if (std::regex_match(name, m, pattern))
+            drained.push_back(std::stoi(m[1]));
+        }
+        std::sort(drained.begin(), drained.end());
+        for (size_t i=0; i+keep<drained.size(); ++i)
+          std::filesystem::remove(fileName(drainPath,"checkpoint",drained[i],rank));
+        Log::debugAll("Checkpoint {} drained in {:.3f}s",t,writeTimer.check());
+      }
+    }
+  });
+}
+
+// Read a checkpoint header, and optionally the whole file.  Returns false if
+// the file is missing, truncated, from another version or fails its checksum.
+bool checkpointManager::readFile(std::string path, header& hd, std::vector<char> *buf){
+  std::ifstream in(path, std::ios::binary);
+  if (!in.read(reinterpret_cast<char *>(&hd), sizeof(header)))
+    return false;
+  if (memcmp(hd.magic, "FIESTACP", 8) != 0 || hd.version != FIESTA_CHECKPOINT_VERSION)
+    return false;
+  if (buf == nullptr)
+    return true;
+
+  buf->resize(sizeof(header) + hd.bytes);
+  memcpy(buf->data(), &hd, sizeof(header));
+  if (!in.read(buf->data() + sizeof(header), hd.bytes))
+    return false;
+  return checksum(buf->data() + sizeof(header), hd.bytes) == hd.checksum;
+}
+
+// Steps with a checkpoint of the given kind and owner in dir whose header
+// matches the current decomposition.
+std::set<int> checkpointManager::scan(struct inputConfig &cf, std::unique_ptr<class rk_func>&f, std::string dir, std::string kind, int owner){
+  std::set<int> steps;
+  if (owner < 0 || !std::filesystem::is_directory(dir))
+    return steps;
+
+  header ref = makeHeader(cf,f,0,0);
+  std::regex pattern(fmt::format("{}-(\\d+)\\.{}",kind,owner));
+  for (auto const& entry : std::filesystem::directory_iterator(dir)){
+    std::smatch m;
+    std::string name = entry.path().filename().string();
+    if (!std::regex_match(name, m, pattern))
+      continue;
+
+    header hd;
+    if (!readFile(entry.path().string(), hd, nullptr))
+      continue;
+    if (hd.rank != owner || hd.numProcs != cf.numProcs || hd.bytes != ref.bytes
+        || !std::equal(hd.varExt, hd.varExt+4, ref.varExt)
+        || !std::equal(hd.gridExt, hd.gridExt+4, ref.gridExt))
+      continue;
+    steps.insert(hd.t);
+  }
+  return steps;
+}
+
+// Load the newest checkpoint that every rank can restore, either from its own
+// local or drained files or from the copy held by its partner, provided it is
+// newer than minStep.  Returns false if there is none.
+bool checkpointManager::recover(struct inputConfig &cf, std::unique_ptr<class rk_func>&f, int minStep, int& t, FSCAL& time){
+  std::set<int> local = scan(cf,f,localPath,"checkpoint",cf.rank);
+  std::set<int> drained = scan(cf,f,drainPath,"checkpoint",cf.rank);
+  std::set<int> held = scan(cf,f,localPath,"partner",partnerRank);
+
+  std::set<int> avail(local);
+  avail.insert(drained.begin(), drained.end());
+
+#ifdef HAVE_MPI
+  // add the steps our partner holds for us
+  if (partnerRank >= 0){
+    std::vector<int> mine(held.begin(), held.end());
+    std::vector<char> theirs;
+    exchangeBytes(reinterpret_cast<char *>(mine.data()), mine.size()*sizeof(int), theirs, partnerRank, cf.comm);
+    int *steps = reinterpret_cast<int *>(theirs.data());
+    avail.insert(steps, steps + theirs.size()/sizeof(int));
+  }
+#endif
+
+  while (true){
+    // the newest common step cannot be newer than any rank's newest
+    int step = avail.empty() ? -1 : *avail.rbegin();
+#ifdef HAVE_MPI
+    MPI_Allreduce(MPI_IN_PLACE, &step, 1, MPI_INT, MPI_MIN, cf.comm);
+#endif
+    if (step < 0 || step <= minStep)
+      return false;
+
+    int ok = avail.count(step);
+#ifdef HAVE_MPI
+    MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_MIN, cf.comm);
+#endif
+    if (!ok){
+      avail.erase(avail.lower_bound(step), avail.end());
+      continue;
+    }
+
+    std::vector<char> buf;
+    header hd;
+    bool loaded = local.count(step) && readFile(fileName(localPath,"checkpoint",step,cf.rank), hd, &buf);
+    if (!loaded && drained.count(step))
+      loaded = readFile(fileName(drainPath,"checkpoint",step,cf.rank), hd, &buf);
+
+#ifdef HAVE_MPI
+    // ranks missing their own copy receive it from their partner
+    if (partnerRank >= 0){
+      int need = !loaded, partnerNeed;
+      MPI_Sendrecv(&need, 1, MPI_INT, partnerRank, 2, &partnerNeed, 1, MPI_INT, partnerRank, 2, cf.comm, MPI_STATUS_IGNORE);
+
+      std::vector<char> send, recv;
+      header phd;
+      if (partnerNeed && !(held.count(step) && readFile(fileName(localPath,"partner",step,partnerRank), phd, &send)))
+        send.clear();
+      exchangeBytes(send.data(), send.size(), recv, partnerRank, cf.comm);
+
+      if (need && recv.size() >= sizeof(header)){
+        memcpy(&hd, recv.data(), sizeof(header));
+        buf.swap(recv);
+        loaded = true;
+        Log::debugAll("Recovered checkpoint {} from partner rank {}",step,partnerRank);
+      }
+    }
+#endif
+
+    ok = loaded && hd.t == step && buf.size() == sizeof(header)+hd.bytes;
+#ifdef HAVE_MPI
+    MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_MIN, cf.comm);
+#endif
+    if (!ok){
+      // not every rank could restore this step, try an older one
+      Log::warning("Checkpoint {} is incomplete or damaged on some ranks.",step);
+      avail.erase(avail.lower_bound(step), avail.end());
+      continue;
+    }
+
+    FSCAL *data = reinterpret_cast<FSCAL *>(buf.data() + sizeof(header));
+    FS4DU varH(data, hd.varExt[0], hd.varExt[1], hd.varExt[2], hd.varExt[3]);
+    FS4DU gridH(data + f->var.size(), hd.gridExt[0], hd.gridExt[1], hd.gridExt[2], hd.gridExt[3]);
+    Kokkos::deep_copy(f->var, varH);
+    Kokkos::deep_copy(f->grid, gridH);
+    Kokkos::fence();
+
+    t = hd.t;
+    time = hd.time;
+    return true;
+  }
+}
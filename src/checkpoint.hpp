@@ -0,0 +1,77 @@
+/*
+  Copyright 2019-2021 The University of New Mexico
+
+  This file is part of FIESTA.
+  
+  FIESTA is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+  
+  FIESTA is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+  
+  You should have received a copy of the GNU Lesser General Public License
+  along with FIESTA.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "kokkosTypes.hpp"
+#include "rkfunction.hpp"
+#include <cstdint>
+#include <future>
+#include <set>
+#include <string>
+#include <vector>
+
+// Tiered checkpoints.  Each rank writes its own copy of var and grid to
+// node-local storage, optionally mirrors it to a partner rank's memory, and
+// drains the local files to the restart path from the I/O thread.  Local
+// checkpoints are tied to the decomposition; HDF5 restarts remain the portable
+// format.
+class checkpointManager {
+  public:
+    checkpointManager(struct inputConfig&);
+    ~checkpointManager();
+
+    void write(struct inputConfig&, std::unique_ptr<class rk_func>&, int, FSCAL);
+    bool recover(struct inputConfig&, std::unique_ptr<class rk_func>&, int, int&, FSCAL&);
+
+  private:
+    struct header {
+      char magic[8];
+      int version;
+      int t;
+      FSCAL time;
+      int rank, numProcs;
+      size_t varExt[4];
+      size_t gridExt[4];
+      size_t bytes;
+      uint64_t checksum;
+    };
+
+    std::string localPath;
+    std::string drainPath;
+    int keep;
+    int drainFreq;
+    bool partner;
+    int partnerRank;
+    size_t count;
+
+    std::vector<int> generations;        // steps kept in local storage
+    std::vector<char> partnerCopy;       // partner's latest checkpoint
+    std::shared_future<void> inflight;   // previous local write and drain
+
+    std::string fileName(std::string, std::string, int, int);
+    header makeHeader(struct inputConfig&, std::unique_ptr<class rk_func>&, int, FSCAL);
+    bool readFile(std::string, header&, std::vector<char>*);
+    std::set<int> scan(struct inputConfig&, std::unique_ptr<class rk_func>&, std::string, std::string, int);
+};
+
+uint64_t checksum(const char *, size_t);
+
+#endif
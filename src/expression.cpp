@@ -0,0 +1,714 @@
+/*
+  Copyright 2019-2021 The University of New Mexico
+
+  This file is part of FIESTA.
+  
+  FIESTA is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+  
+  FIESTA is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+  
+  You should have received a copy of the GNU Lesser General Public License
+  along with FIESTA.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "expression.hpp"
+#include "log2.hpp"
+#include "lua.hpp"
+#include "fmt/core.h"
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+
+// limits of the interpreter, checked when compiling
+#define EXPR_STACK 32
+#define EXPR_SLOTS 32
+#define EXPR_ARGS 8
+
+enum exprOp { exConst, exBool, exLoad, exStore, exAdd, exSub, exMul, exDiv, exIdiv, exMod, exPow,
+              exNeg, exLt, exLe, exGt, exGe, exEq, exNe, exNot, exAnd, exOr, exCall, exEnd };
+
+enum exprFn { fnSin, fnCos, fnTan, fnAsin, fnAcos, fnAtan, fnExp, fnLog, fnSqrt, fnAbs, fnFloor,
+              fnCeil, fnFmod, fnMin, fnMax, fnRad, fnDeg };
+
+// math library functions with their minimum and maximum number of arguments
+static const struct { const char* name; int fn; int min; int max; } exprFunctions[] = {
+  {"sin",fnSin,1,1}, {"cos",fnCos,1,1}, {"tan",fnTan,1,1}, {"asin",fnAsin,1,1}, {"acos",fnAcos,1,1},
+  {"atan",fnAtan,1,2}, {"exp",fnExp,1,1}, {"log",fnLog,1,2}, {"sqrt",fnSqrt,1,1}, {"abs",fnAbs,1,1},
+  {"floor",fnFloor,1,1}, {"ceil",fnCeil,1,1}, {"fmod",fnFmod,2,2}, {"min",fnMin,1,EXPR_ARGS},
+  {"max",fnMax,1,EXPR_ARGS}, {"rad",fnRad,1,1}, {"deg",fnDeg,1,1}
+};
+
+// types a value may have, Lua treats every number as true
+#define TY_NUM 1
+#define TY_TRUE 2
+#define TY_FALSE 4
+
+struct exprToken {
+  enum { number, name, op, end } type;
+  std::string text;
+  FSCAL value;
+  size_t pos;
+};
+
+// Recursive descent compiler following the Lua parser, so that operators
+// group and evaluate in the same order as in Lua.
+class exprCompiler {
+  public:
+    exprCompiler(std::string what_, std::string src_, std::map<std::string,int>& slots_,
+                 std::map<std::string,int>& slotTypes_, const std::map<std::string,FSCAL>& constants_,
+                 std::vector<int>& code_, std::vector<FSCAL>& pool_)
+      : what(what_), src(src_), slots(slots_), slotTypes(slotTypes_), constants(constants_),
+        code(code_), pool(pool_), pos(0), depth(0) {
+      tokenize();
+    }
+
+    // compile a definition, leaving nothing on the stack
+    std::string definition(){
+      if (peek().type == exprToken::name && peek().text == "local") next();
+      exprToken n = next();
+      if (n.type != exprToken::name || isReserved(n.text))
+        fail("expected a name to define",n.pos);
+      if (constants.count(n.text) || isFunction(n.text) || n.text == "pi" || n.text == "huge" ||
+          n.text == "math" || n.text == "C")
+        fail(fmt::format("'{}' is already defined",n.text),n.pos);
+      if (next().text != "=")
+        fail("expected '='",n.pos);
+      int type = subexpr(0);
+      finish();
+
+      if (!slots.count(n.text)){
+        if ((int)slots.size() >= EXPR_SLOTS)
+          fail(fmt::format("more than {} inputs and definitions",EXPR_SLOTS),n.pos);
+        int s = slots.size();
+        slots[n.text] = s;
+      }
+      slotTypes[n.text] = type;
+      code.push_back(exStore);
+      code.push_back(slots[n.text]);
+      pop(1);
+      return n.text;
+    }
+
+    // compile an output value, leaving it on the stack
+    void value(){
+      int type = subexpr(0);
+      finish();
+      if (type != TY_NUM)
+        fail("the value may be a boolean instead of a number",0);
+    }
+
+    std::set<int> loaded;  // slots read by the expression
+    int maxDepth = 0;
+
+  private:
+    std::string what, src;
+    std::map<std::string,int>& slots;
+    std::map<std::string,int>& slotTypes;
+    const std::map<std::string,FSCAL>& constants;
+    std::vector<int>& code;
+    std::vector<FSCAL>& pool;
+    std::vector<exprToken> tokens;
+    size_t pos;
+    int depth;
+
+    [[noreturn]] void fail(std::string msg, size_t at){
+      Log::error("Could not compile {}: {} at position {} of '{}'",what,msg,at+1,src);
+      exit(EXIT_FAILURE);
+    }
+
+    static bool isReserved(const std::string& s){
+      return s == "and" || s == "or" || s == "not" || s == "true" || s == "false" || s == "local";
+    }
+
+    static bool isFunction(const std::string& s){
+      for (auto& f : exprFunctions)
+        if (s == f.name) return true;
+      return false;
+    }
+
+    void tokenize(){
+      size_t i = 0;
+      while (i < src.size()){
+        char c = src[i];
+        if (isspace((unsigned char)c)){
+          ++i;
+        }else if (isdigit((unsigned char)c) || (c == '.' && i+1 < src.size() && isdigit((unsigned char)src[i+1]))){
+          size_t j = i;
+          while (j < src.size() && (isalnum((unsigned char)src[j]) || src[j] == '.' ||
+                 ((src[j] == '+' || src[j] == '-') && (src[j-1] == 'e' || src[j-1] == 'E'))))
+            ++j;
+          std::string num = src.substr(i,j-i);
+          char* stop;
+          FSCAL v = strtod(num.c_str(),&stop);
+          if (*stop != '\0' || num.find_first_of("xX") != std::string::npos)
+            fail(fmt::format("malformed number '{}'",num),i);
+          tokens.push_back({exprToken::number,num,v,i});
+          i = j;
+        }else if (isalpha((unsigned char)c) || c == '_'){
+          size_t j = i;
+          while (j < src.size() && (isalnum((unsigned char)src[j]) || src[j] == '_')) ++j;
+          std::string name = src.substr(i,j-i);
+          // math.name refers to the math library
+          if (name == "math" && j < src.size() && src[j] == '.'){
+            size_t k = ++j;
+            while (j < src.size() && (isalnum((unsigned char)src[j]) || src[j] == '_')) ++j;
+            std::string f = src.substr(k,j-k);
+            if (!isFunction(f) && f != "pi" && f != "huge")
+              fail(fmt::format("unsupported function 'math.{}'",f),i);
+            name = f;
+          }
+          tokens.push_back({exprToken::name,name,0.0,i});
+          i = j;
+        }else{
+          static const char* ops[] = {"//","<=",">=","==","~=","+","-","*","/","%","^","<",">","(",")",",","="};
+          bool found = false;
+          for (auto o : ops){
+            size_t n = strlen(o);
+            if (src.compare(i,n,o) == 0){
+              tokens.push_back({exprToken::op,o,0.0,i});
+              i += n;
+              found = true;
+              break;
+            }
+          }
+          if (!found)
+            fail(fmt::format("unexpected '{}'",c),i);
+        }
+      }
+      tokens.push_back({exprToken::end,"",0.0,src.size()});
+    }
+
+    const exprToken& peek(){ return tokens[pos]; }
+    exprToken next(){ return tokens[pos < tokens.size()-1 ? pos++ : pos]; }
+
+    void finish(){
+      if (peek().type != exprToken::end)
+        fail(fmt::format("unexpected '{}'",peek().text),peek().pos);
+    }
+
+    void push(){ maxDepth = std::max(maxDepth, ++depth); }
+    void pop(int n){ depth -= n; }
+
+    void numbers(int type, int at){
+      if (type != TY_NUM)
+        fail("arithmetic or comparison on a value that may be a boolean",at);
+    }
+
+    // binary operator priorities of the Lua parser
+    static bool binary(const exprToken& t, int& left, int& right){
+      if (t.type == exprToken::name){
+        if (t.text == "or"){ left = right = 1; return true; }
+        if (t.text == "and"){ left = right = 2; return true; }
+        return false;
+      }
+      if (t.type != exprToken::op) return false;
+      const std::string& o = t.text;
+      if (o == "<" || o == "<=" || o == ">" || o == ">=" || o == "==" || o == "~="){ left = right = 3; return true; }
+      if (o == "+" || o == "-"){ left = right = 10; return true; }
+      if (o == "*" || o == "/" || o == "//" || o == "%"){ left = right = 11; return true; }
+      if (o == "^"){ left = 14; right = 13; return true; }
+      return false;
+    }
+
+    int subexpr(int limit){
+      int type;
+      const exprToken& t = peek();
+      if ((t.type == exprToken::op && t.text == "-") || (t.type == exprToken::name && t.text == "not")){
+        exprToken u = next();
+        int operand = subexpr(12);
+        if (u.text == "-"){
+          numbers(operand,u.pos);
+          code.push_back(exNeg);
+          type = TY_NUM;
+        }else{
+          code.push_back(exNot);
+          type = TY_TRUE | TY_FALSE;
+        }
+      }else{
+        type = simple();
+      }
+
+      int left, right;
+      while (binary(peek(),left,right) && left > limit){
+        exprToken o = next();
+
+        if (o.text == "and" || o.text == "or"){
+          // jump over the right operand, keeping the left one, if it decides the result
+          code.push_back(o.text == "and" ? exAnd : exOr);
+          size_t jump = code.size();
+          code.push_back(0);
+          pop(1);
+          int r = subexpr(right);
+          code[jump] = code.size();
+          if (o.text == "and")
+            type = ((type & TY_FALSE) ? TY_FALSE : 0) | ((type & (TY_NUM|TY_TRUE)) ? r : 0);
+          else
+            type = (type & (TY_NUM|TY_TRUE)) | ((type & TY_FALSE) ? r : 0);
+          continue;
+        }
+
+        int r = subexpr(right);
+        pop(1);
+        if (o.text == "==" || o.text == "~="){
+          code.push_back(o.text == "==" ? exEq : exNe);
+          type = TY_TRUE | TY_FALSE;
+          continue;
+        }
+        numbers(type,o.pos);
+        numbers(r,o.pos);
+        if      (o.text == "+")  code.push_back(exAdd);
+        else if (o.text == "-")  code.push_back(exSub);
+        else if (o.text == "*")  code.push_back(exMul);
+        else if (o.text == "/")  code.push_back(exDiv);
+        else if (o.text == "//") code.push_back(exIdiv);
+        else if (o.text == "%")  code.push_back(exMod);
+        else if (o.text == "^")  code.push_back(exPow);
+        else if (o.text == "<")  code.push_back(exLt);
+        else if (o.text == "<=") code.push_back(exLe);
+        else if (o.text == ">")  code.push_back(exGt);
+        else                     code.push_back(exGe);
+        type = (o.text[0] == '<' || o.text[0] == '>') ? (TY_TRUE | TY_FALSE) : TY_NUM;
+      }
+      return type;
+    }
+
+    void constant(FSCAL v){
+      code.push_back(exConst);
+      code.push_back(pool.size());
+      pool.push_back(v);
+      push();
+    }
+
+    int simple(){
+      exprToken t = next();
+
+      if (t.type == exprToken::number){
+        constant(t.value);
+        return TY_NUM;
+      }
+
+      if (t.type == exprToken::op && t.text == "("){
+        int type = subexpr(0);
+        if (next().text != ")")
+          fail("expected ')'",t.pos);
+        return type;
+      }
+
+      if (t.type != exprToken::name || t.text == "and" || t.text == "or" || t.text == "local")
+        fail(t.type == exprToken::end ? "unexpected end" : fmt::format("unexpected '{}'",t.text),t.pos);
+
+      if (t.text == "true" || t.text == "false"){
+        code.push_back(exBool);
+        code.push_back(t.text == "true");
+        push();
+        return t.text == "true" ? TY_TRUE : TY_FALSE;
+      }
+
+      if (peek().type == exprToken::op && peek().text == "("){
+        next();
+        for (auto& f : exprFunctions){
+          if (t.text != f.name) continue;
+          int nargs = 0;
+          if (!(peek().type == exprToken::op && peek().text == ")")){
+            while (true){
+              numbers(subexpr(0),t.pos);
+              ++nargs;
+              if (!(peek().type == exprToken::op && peek().text == ",")) break;
+              next();
+            }
+          }
+          if (next().text != ")")
+            fail("expected ')'",t.pos);
+          if (nargs < f.min || nargs > f.max)
+            fail(fmt::format("wrong number of arguments to '{}'",f.name),t.pos);
+          code.push_back(exCall);
+          code.push_back(f.fn);
+          code.push_back(nargs);
+          pop(nargs);
+          push();
+          return TY_NUM;
+        }
+        fail(fmt::format("unknown function '{}'",t.text),t.pos);
+      }
+
+      if (slots.count(t.text)){
+        code.push_back(exLoad);
+        code.push_back(slots[t.text]);
+        loaded.insert(slots[t.text]);
+        push();
+        return slotTypes[t.text];
+      }
+      if (constants.count(t.text)){
+        constant(constants.at(t.text));
+        return TY_NUM;
+      }
+      if (t.text == "pi"){
+        constant(M_PI);
+        return TY_NUM;
+      }
+      if (t.text == "huge"){
+        constant(HUGE_VAL);
+        return TY_NUM;
+      }
+      fail(fmt::format("unknown name '{}'",t.text),t.pos);
+    }
+};
+
+expression::expression(std::string name_, std::vector<std::string> inputs_,
+                       std::map<std::string,FSCAL> constants_, std::vector<std::string> definitions_,
+                       std::vector<std::string> values_, bool validate_)
+  : name(name_), validate(validate_), inputs(inputs_), constants(constants_),
+    definitions(definitions_), values(values_) {
+
+  for (auto& c : constants){
+    bool reserved = c.first == "and" || c.first == "or" || c.first == "not" || c.first == "true" ||
+                    c.first == "false" || c.first == "local" || c.first == "pi" || c.first == "huge" ||
+                    c.first == "math" || c.first == "C";
+    for (auto& f : exprFunctions)
+      reserved = reserved || c.first == f.name;
+    for (auto& i : inputs)
+      reserved = reserved || c.first == i;
+    bool valid = !c.first.empty() && (isalpha((unsigned char)c.first[0]) || c.first[0] == '_');
+    for (auto ch : c.first)
+      valid = valid && (isalnum((unsigned char)ch) || ch == '_');
+    if (reserved || !valid){
+      Log::error("'{}' can not be used as a constant name in {}.",c.first,name);
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  std::map<std::string,int> slots, slotTypes;
+  for (size_t s=0; s<inputs.size(); ++s){
+    slots[inputs[s]] = s;
+    slotTypes[inputs[s]] = TY_NUM;
+  }
+
+  std::vector<int> hcode;
+  std::vector<int> hentry;
+  std::vector<FSCAL> pool;
+  depth = 0;
+  statementsUseV = false;
+
+  // definitions, in order
+  hentry.push_back(0);
+  for (size_t d=0; d<definitions.size(); ++d){
+    exprCompiler c(fmt::format("definition {} of {}",d+1,name),definitions[d],slots,slotTypes,constants,hcode,pool);
+    c.definition();
+    depth = std::max(depth,c.maxDepth);
+    // the output index is the last input
+    if (c.loaded.count(inputs.size()-1)) statementsUseV = true;
+  }
+  hcode.push_back(exEnd);
+
+  // one program for each output
+  for (size_t v=0; v<values.size(); ++v){
+    hentry.push_back(hcode.size());
+    exprCompiler c(fmt::format("value {} of {}",v+1,name),values[v],slots,slotTypes,constants,hcode,pool);
+    c.value();
+    depth = std::max(depth,c.maxDepth);
+    hcode.push_back(exEnd);
+  }
+
+  if (depth > EXPR_STACK){
+    Log::error("The expressions of {} need a stack of {} values, more than the limit of {}.",name,depth,EXPR_STACK);
+    exit(EXIT_FAILURE);
+  }
+  nslots = slots.size();
+
+  code = FS1D_I("expression code",hcode.size());
+  entry = FS1D_I("expression entry",hentry.size());
+  consts = FS1D("expression constants",std::max((size_t)1,pool.size()));
+  FS1DH_I code_h = Kokkos::create_mirror_view(code);
+  FS1DH_I entry_h = Kokkos::create_mirror_view(entry);
+  FS1DH consts_h = Kokkos::create_mirror_view(consts);
+  for (size_t i=0; i<hcode.size(); ++i) code_h(i) = hcode[i];
+  for (size_t i=0; i<hentry.size(); ++i) entry_h(i) = hentry[i];
+  for (size_t i=0; i<pool.size(); ++i) consts_h(i) = pool[i];
+  Kokkos::deep_copy(code,code_h);
+  Kokkos::deep_copy(entry,entry_h);
+  Kokkos::deep_copy(consts,consts_h);
+
+  Log::debug("Compiled {} expressions of {} to {} instructions",definitions.size()+values.size(),name,hcode.size());
+}
+
+// Bytecode interpreter.  Values carry a flag marking booleans, which are false
+// when zero.  Arithmetic follows the Lua number operations.
+struct exprProgram {
+  FS1D_I code;
+  FS1D_I entry;
+  FS1D consts;
+
+  KOKKOS_INLINE_FUNCTION
+  FSCAL call(const int fn, const int n, const FSCAL a[]) const {
+    switch (fn){
+      case fnSin:   return sin(a[0]);
+      case fnCos:   return cos(a[0]);
+      case fnTan:   return tan(a[0]);
+      case fnAsin:  return asin(a[0]);
+      case fnAcos:  return acos(a[0]);
+      case fnAtan:  return atan2(a[0], n > 1 ? a[1] : 1.0);
+      case fnExp:   return exp(a[0]);
+      case fnLog:
+        if (n == 1) return log(a[0]);
+        if (a[1] == 2.0) return log2(a[0]);
+        if (a[1] == 10.0) return log10(a[0]);
+        return log(a[0])/log(a[1]);
+      case fnSqrt:  return sqrt(a[0]);
+      case fnAbs:   return fabs(a[0]);
+      case fnFloor: return floor(a[0]);
+      case fnCeil:  return ceil(a[0]);
+      case fnFmod:  return fmod(a[0],a[1]);
+      case fnMin: {
+        FSCAL m = a[0];
+        for (int i=1; i<n; ++i) if (a[i] < m) m = a[i];
+        return m;
+      }
+      case fnMax: {
+        FSCAL m = a[0];
+        for (int i=1; i<n; ++i) if (m < a[i]) m = a[i];
+        return m;
+      }
+      case fnRad:   return a[0]*(M_PI/180.0);
+      default:      return a[0]*(180.0/M_PI);
+    }
+  }
+
+  // run the program at pc and return the value it leaves on the stack
+  KOKKOS_INLINE_FUNCTION
+  FSCAL run(int pc, FSCAL slot[], bool slotBool[]) const {
+    FSCAL s[EXPR_STACK+1];
+    bool b[EXPR_STACK+1];
+    int sp = 0;
+
+    while (true){
+      int op = code(pc++);
+      switch (op){
+        case exConst: ++sp; s[sp] = consts(code(pc++)); b[sp] = false; break;
+        case exBool:  ++sp; s[sp] = code(pc++); b[sp] = true; break;
+        case exLoad:  ++sp; s[sp] = slot[code(pc)]; b[sp] = slotBool[code(pc)]; ++pc; break;
+        case exStore: slot[code(pc)] = s[sp]; slotBool[code(pc)] = b[sp]; ++pc; --sp; break;
+        case exAdd:   --sp; s[sp] = s[sp] + s[sp+1]; break;
+        case exSub:   --sp; s[sp] = s[sp] - s[sp+1]; break;
+        case exMul:   --sp; s[sp] = s[sp] * s[sp+1]; break;
+        case exDiv:   --sp; s[sp] = s[sp] / s[sp+1]; break;
+        case exIdiv:  --sp; s[sp] = floor(s[sp] / s[sp+1]); break;
+        case exMod: {
+          --sp;
+          FSCAL m = fmod(s[sp], s[sp+1]);
+          if (m*s[sp+1] < 0) m += s[sp+1];   // as luai_nummod
+          s[sp] = m;
+          break;
+        }
+        case exPow:   --sp; s[sp] = pow(s[sp], s[sp+1]); break;   // as luai_numpow
+        case exNeg:   s[sp] = -s[sp]; break;
+        case exLt:    --sp; s[sp] = s[sp] <  s[sp+1]; b[sp] = true; break;
+        case exLe:    --sp; s[sp] = s[sp] <= s[sp+1]; b[sp] = true; break;
+        case exGt:    --sp; s[sp] = s[sp] >  s[sp+1]; b[sp] = true; break;
+        case exGe:    --sp; s[sp] = s[sp] >= s[sp+1]; b[sp] = true; break;
+        case exEq:    --sp; s[sp] = (b[sp] == b[sp+1] && s[sp] == s[sp+1]); b[sp] = true; break;
+        case exNe:    --sp; s[sp] = !(b[sp] == b[sp+1] && s[sp] == s[sp+1]); b[sp] = true; break;
+        case exNot:   s[sp] = (b[sp] && s[sp] == 0.0); b[sp] = true; break;
+        case exAnd:
+          if (b[sp] && s[sp] == 0.0) pc = code(pc);
+          else { --sp; ++pc; }
+          break;
+        case exOr:
+          if (!(b[sp] && s[sp] == 0.0)) pc = code(pc);
+          else { --sp; ++pc; }
+          break;
+        case exCall: {
+          int fn = code(pc++);
+          int n = code(pc++);
+          sp -= n-1;
+          s[sp] = call(fn, n, &s[sp]);
+          b[sp] = false;
+          break;
+        }
+        default:
+          return s[sp];
+      }
+    }
+  }
+
+  // evaluate output v, after the definitions have been run
+  KOKKOS_INLINE_FUNCTION
+  FSCAL value(const int v, FSCAL slot[], bool slotBool[]) const {
+    return run(entry(v+1), slot, slotBool);
+  }
+
+  KOKKOS_INLINE_FUNCTION
+  void define(FSCAL slot[], bool slotBool[]) const {
+    run(entry(0), slot, slotBool);
+  }
+};
+
+// evaluate initial conditions at the cell centers
+struct exprCells {
+  FS4D var;
+  FS4D grid;
+  exprProgram prog;
+  int ndim, nv, ng, ngk, nz;
+  bool cartesian, useV;
+  FSCAL dx, dy, dz;
+  int iStart, jStart, kStart;
+
+  exprCells(FS4D var_, FS4D grid_, exprProgram prog_, int ndim_, int nv_, int ng_, int ngk_, bool cartesian_,
+            bool useV_, FSCAL dx_, FSCAL dy_, FSCAL dz_, int iStart_, int jStart_, int kStart_)
+    : var(var_), grid(grid_), prog(prog_), ndim(ndim_), nv(nv_), ng(ng_), ngk(ngk_), cartesian(cartesian_),
+      useV(useV_), dx(dx_), dy(dy_), dz(dz_), iStart(iStart_), jStart(jStart_), kStart(kStart_) {
+    nz = (ndim == 3) ? 2 : 1;
+  }
+
+  KOKKOS_INLINE_FUNCTION
+  void operator()(const int i, const int j, const int k) const {
+    FSCAL slot[EXPR_SLOTS] = {0.0};
+    bool slotBool[EXPR_SLOTS] = {false};
+
+    if (cartesian){
+      slot[0] = dx*(i+iStart) + 0.5*dx;
+      slot[1] = dy*(j+jStart) + 0.5*dy;
+      if (ndim == 3)
+        slot[2] = dz*(k+kStart) + 0.5*dz;
+    }else{
+      // average cell nodes to compute cell center coordinate for non-uniform grids
+      for (int ix=0; ix<2; ++ix)
+        for (int iy=0; iy<2; ++iy)
+          for (int iz=0; iz<nz; ++iz)
+            for (int d=0; d<ndim; ++d)
+              slot[d] += grid(i+ix,j+iy,k+iz,d);
+      for (int d=0; d<ndim; ++d)
+        slot[d] /= 2*2*nz;
+    }
+
+    if (!useV) prog.define(slot,slotBool);
+    for (int v=0; v<nv; ++v){
+      slot[3] = v;
+      if (useV) prog.define(slot,slotBool);
+      var(i+ng,j+ng,k+ngk,v) = prog.value(v,slot,slotBool);
+    }
+  }
+};
+
+// evaluate grid coordinates at the global node indexes
+struct exprNodes {
+  FS4D grid;
+  exprProgram prog;
+  int ndim;
+  bool useV;
+  int iStart, jStart, kStart;
+
+  exprNodes(FS4D grid_, exprProgram prog_, int ndim_, bool useV_, int iStart_, int jStart_, int kStart_)
+    : grid(grid_), prog(prog_), ndim(ndim_), useV(useV_), iStart(iStart_), jStart(jStart_), kStart(kStart_) {}
+
+  KOKKOS_INLINE_FUNCTION
+  void operator()(const int i, const int j, const int k) const {
+    FSCAL slot[EXPR_SLOTS] = {0.0};
+    bool slotBool[EXPR_SLOTS] = {false};
+    slot[0] = iStart + i;
+    slot[1] = jStart + j;
+    slot[2] = kStart + k;
+
+    if (!useV) prog.define(slot,slotBool);
+    for (int v=0; v<ndim; ++v){
+      slot[3] = v;
+      if (useV) prog.define(slot,slotBool);
+      grid(i,j,k,v) = prog.value(v,slot,slotBool);
+    }
+  }
+};
+
+void expression::initialConditions(struct inputConfig& cf, FS4D& var, FS4D& grid){
+  exprProgram prog = {code, entry, consts};
+  int nck = (cf.ndim == 3) ? cf.nck : 1;
+  int ngk = (cf.ndim == 3) ? cf.ng : 0;
+  int kStart = (cf.ndim == 3) ? cf.subdomainOffset[2] : 0;
+
+  policy_f3 cells = policy_f3({0,0,0},{cf.nci,cf.ncj,nck});
+  Kokkos::parallel_for(cells, exprCells(var, grid, prog, cf.ndim, cf.nv, cf.ng, ngk, cf.grid == 0, statementsUseV,
+                                        cf.dx, cf.dy, cf.dz, cf.subdomainOffset[0], cf.subdomainOffset[1], kStart));
+  Kokkos::fence();
+}
+
+void expression::grid(struct inputConfig& cf, FS4D& grid){
+  exprProgram prog = {code, entry, consts};
+  policy_f3 nodes = policy_f3({0,0,0},{cf.ni,cf.nj,cf.nk});
+  Kokkos::parallel_for(nodes, exprNodes(grid, prog, cf.ndim, statementsUseV, cf.iStart, cf.jStart, cf.kStart));
+  Kokkos::fence();
+}
+
+// The Lua function equivalent to the expressions, taking the constants as its
+// argument and returning a function of the inputs
+std::string expression::luaSource(){
+  std::string src = "local C = ...\n";
+  std::string names, funcs;
+  for (auto& f : exprFunctions){
+    names += fmt::format("{}{}",names.empty() ? "" : ", ",f.name);
+    funcs += fmt::format("{}math.{}",funcs.empty() ? "" : ", ",f.name);
+  }
+  src += fmt::format("local {} = {}\n",names,funcs);
+  src += "local pi, huge = math.pi, math.huge\n";
+  for (auto& c : constants)
+    src += fmt::format("local {} = C[\"{}\"]\n",c.first,c.first);
+
+  std::string args;
+  for (auto& i : inputs)
+    args += fmt::format("{}{}",args.empty() ? "" : ", ",i);
+  src += fmt::format("return function({})\n",args);
+  for (auto& d : definitions)
+    src += fmt::format("  {}{}\n",d.compare(0,6,"local ") == 0 ? "" : "local ",d);
+  for (size_t v=0; v<values.size(); ++v)
+    src += fmt::format("  if {} == {} then return {} end\n",inputs.back(),v,values[v]);
+  src += "end\n";
+  return src;
+}
+
+size_t expression::compare(size_t n, const std::function<std::array<FSCAL,3>(size_t)>& point,
+                           const std::function<FSCAL(size_t,int)>& result){
+  lua_State *L = luaL_newstate();
+  luaL_openlibs(L);
+
+  std::string src = luaSource();
+  if (luaL_loadstring(L,src.c_str()) != LUA_OK){
+    Log::error("Could not load the Lua equivalent of {}: {}",name,lua_tostring(L,-1));
+    exit(EXIT_FAILURE);
+  }
+  lua_newtable(L);
+  for (auto& c : constants){
+    lua_pushnumber(L,c.second);
+    lua_setfield(L,-2,c.first.c_str());
+  }
+  if (lua_pcall(L,1,1,0) != LUA_OK){
+    Log::error("Could not run the Lua equivalent of {}: {}",name,lua_tostring(L,-1));
+    exit(EXIT_FAILURE);
+  }
+
+  size_t differ = 0;
+  for (size_t p=0; p<n; ++p){
+    auto x = point(p);
+    for (size_t v=0; v<values.size(); ++v){
+      lua_pushvalue(L,-1);
+      for (int d=0; d<3; ++d)
+        lua_pushnumber(L,x[d]);
+      lua_pushnumber(L,(FSCAL)v);
+      if (lua_pcall(L,4,1,0) != LUA_OK){
+        Log::error("Error running the Lua equivalent of {}: {}",name,lua_tostring(L,-1));
+        exit(EXIT_FAILURE);
+      }
+      FSCAL a = (FSCAL)lua_tonumber(L,-1);
+      FSCAL b = result(p,v);
+      lua_pop(L,1);
+      if (memcmp(&a,&b,sizeof(FSCAL)) != 0 && !(std::isnan(a) && std::isnan(b)))
+        ++differ;
+    }
+  }
+  lua_close(L);
+  return differ;
+}
@@ -0,0 +1,70 @@
+/*
+  Copyright 2019-2021 The University of New Mexico
+
+  This file is part of FIESTA.
+  
+  FIESTA is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+  
+  FIESTA is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+  
+  You should have received a copy of the GNU Lesser General Public License
+  along with FIESTA.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef EXPRESSION_H
+#define EXPRESSION_H
+
+#include "kokkosTypes.hpp"
+#include "input.hpp"
+#include <array>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+// Initial conditions or a grid given as expressions in the input file instead
+// of a Lua function.  The expressions are a subset of Lua: numbers, + - * / //
+// % ^, comparisons, and/or/not, the math functions and user constants.  A list
+// of definitions can name intermediate values.  Everything is compiled once to
+// a stack bytecode that is interpreted on the device, evaluating operations in
+// the same order and with the same math functions as Lua, so that the results
+// match the equivalent Lua function bit for bit.
+class expression {
+  public:
+    expression(std::string, std::vector<std::string>, std::map<std::string,FSCAL>,
+               std::vector<std::string>, std::vector<std::string>, bool);
+
+    void initialConditions(struct inputConfig&, FS4D&, FS4D&);
+    void grid(struct inputConfig&, FS4D&);
+
+    // count the points where the equivalent Lua function gives a different result
+    size_t compare(size_t, const std::function<std::array<FSCAL,3>(size_t)>&,
+                   const std::function<FSCAL(size_t,int)>&);
+
+    std::string luaSource();
+
+    std::string name;
+    bool validate;
+
+  private:
+    std::vector<std::string> inputs;
+    std::map<std::string,FSCAL> constants;
+    std::vector<std::string> definitions;
+    std::vector<std::string> values;
+
+    int nslots;          // inputs and defined values
+    int depth;           // deepest stack of any program
+    bool statementsUseV; // definitions depend on the output index
+
+    FS1D_I code;         // opcodes and operands of every program
+    FS1D_I entry;        // start of the definitions and of each output
+    FS1D consts;         // constant pool
+};
+
+#endif
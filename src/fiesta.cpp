@@ -28,6 +28,8 @@
 #include "rkfunction.hpp"
 #include "status.hpp"
 #include <set>
+#include <algorithm>
+#include <cstdio>
 #include "log.hpp"
 #include "block.hpp"
 //#include <csignal>
@@ -45,6 +47,11 @@
 #endif
 #include "signal.hpp"
 #include "rk.hpp"
+#include "staging.hpp"
+#include "checkpoint.hpp"
+#include "iothread.hpp"
+#include "memory.hpp"
+#include "trace.hpp"
 
 using namespace std;
 
@@ -57,7 +64,18 @@ struct inputConfig Fiesta::initialize(struct inputConfig &cf, int argc, char **a
   // Initialize MPI and get temporary rank.
   int temp_rank = 0;
 #ifdef HAVE_MPI
-  MPI_Init(NULL, NULL);
+  // Asynchronous writes issue MPI calls from the I/O thread and need
+  // MPI_THREAD_MULTIPLE.  Otherwise only the main thread calls MPI, so the
+  // input is checked for hdf5.async before choosing the thread level.
+  bool asyncRequested;
+  {
+    luaReader L(cArgs.fileName,"fiesta");
+    L.get({"hdf5","async"},asyncRequested,false);
+    L.close();
+  }
+  int threadRequired = asyncRequested ? MPI_THREAD_MULTIPLE : MPI_THREAD_FUNNELED;
+  int threadSupport;
+  MPI_Init_thread(NULL, NULL, threadRequired, &threadSupport);
   MPI_Comm_rank(MPI_COMM_WORLD, &temp_rank);
 #endif
 
@@ -75,10 +93,22 @@ struct inputConfig Fiesta::initialize(struct inputConfig &cf, int argc, char **a
 #endif
   Kokkos::initialize(kokkosArgs);
 
+  // the allocation callbacks replace those of any other Kokkos tool, so they
+  // are only installed on request
+  if (cArgs.memory || cArgs.dryRun)
+    Memory::track();
+
   // Execute lua script and get input parameters
   Log::message("Executing Lua Input Script: '{}'",cArgs.fileName);
   executeConfiguration(cf,cArgs);
 
+#ifdef HAVE_MPI
+  if (cf.asyncIO && threadSupport < MPI_THREAD_MULTIPLE){
+    Log::warning("MPI library does not support MPI_THREAD_MULTIPLE.  Disabling asynchronous writes.");
+    cf.asyncIO = false;
+  }
+#endif
+
 #ifdef HAVE_MPI
   // perform domain decomposition
   Log::message("Initializing MPI Setup");
@@ -88,6 +118,8 @@ struct inputConfig Fiesta::initialize(struct inputConfig &cf, int argc, char **a
   Log::message("Printing Configuration");
   printConfig(cf);
 
+  Trace::configure(cf);
+
   // create signal handler
   class fiestaSignalHandler *signalHandler = 0;
   signalHandler = signalHandler->getInstance(cf);
@@ -96,6 +128,25 @@ struct inputConfig Fiesta::initialize(struct inputConfig &cf, int argc, char **a
   return cf;
 }
 
+// Write the grid and initial conditions to a restart format cache file.  The
+// file is written under a temporary name and renamed once complete, so other
+// runs never read a partial cache.
+static void writeInitialCache(struct inputConfig &cf, std::unique_ptr<class rk_func>&f, std::string cacheName){
+  std::filesystem::path cachePath{cacheName};
+  std::string partial = cachePath.stem().string() + "-partial";
+  std::string dir = cachePath.parent_path().string();
+  {
+    blockWriter<FSCAL> cache(cf, f, partial, dir, false, 1, false);
+    cache.write(cf, f, cf.tstart, cf.time);
+  }
+
+  if (cf.rank == 0){
+    std::filesystem::rename(fmt::format("{}/{}.h5",dir,partial), cacheName);
+    std::filesystem::remove(fmt::format("{}/{}.xmf",dir,partial));
+  }
+  Log::message("Cached grid and initial conditions in '{}'",cacheName);
+}
+
 //
 // Initialize the simulation and load initial data
 //
@@ -134,8 +185,32 @@ void Fiesta::initializeSimulation(Simulation &sim){
   //sim.cf.w = std::make_shared<hdfWriter>(sim.cf,f);
 
 
-  // If not restarting, generate initial conditions and grid
-  if (sim.cf.restart == 0) {
+  sim.cf.staging = std::make_shared<ioStaging>();
+  if (sim.cf.checkpoint_freq > 0 && !sim.cf.dryRun){
+    sim.cf.ckpt = std::make_shared<checkpointManager>(sim.cf);
+    sim.f->timers["ckptWrite"] = Timer::fiestaTimer("Checkpoint Write Time");
+  }
+  if (sim.cf.rollback_freq > 0){
+    sim.rollback = std::make_unique<rollbackRing>(sim.cf,sim.f);
+    sim.f->timers["health"] = Timer::fiestaTimer("Health Check Time");
+  }
+
+  // If not restarting, generate initial conditions and grid, or read them
+  // from the cache left by an earlier run of the same problem
+  std::string cacheName = (sim.cf.restart == 0 && !sim.cf.dryRun) ? initialCacheName(sim.cf, sim.f->varNames) : "";
+  if (!cacheName.empty()){
+    sim.cf.loadTimer.start();
+    sim.cf.initCacheHit = readInitialCache(sim.cf, sim.f, cacheName);
+    sim.cf.loadTimer.stop();
+    if (sim.cf.initCacheHit)
+      Log::message("Read grid and initial conditions from cache '{}' in: {}",cacheName,sim.cf.loadTimer.get());
+    else
+      sim.cf.loadTimer.reset();
+  }
+
+  if (sim.cf.dryRun) {
+    Log::message("Dry run, skipping grid and initial conditions");
+  }else if (sim.cf.restart == 0 && !sim.cf.initCacheHit) {
     // Generate Grid Coordinates
     Log::message("Generating grid");
     sim.cf.gridTimer.start();
@@ -150,6 +225,12 @@ void Fiesta::initializeSimulation(Simulation &sim){
     sim.cf.loadTimer.stop();
     Log::message("Initial conditions generated in: {}",sim.cf.loadTimer.get());
 
+    if (!cacheName.empty()){
+      sim.cf.writeTimer.start();
+      writeInitialCache(sim.cf, sim.f, cacheName);
+      sim.cf.writeTimer.stop();
+    }
+
     // sim.cf.writeTimer.start();
     // // Write initial solution file
     // if (sim.cf.write_freq > 0) {
@@ -165,7 +246,7 @@ void Fiesta::initializeSimulation(Simulation &sim){
     //   sim.f->timers["resWrite"].accumulate();
     // }
     // sim.cf.writeTimer.stop();
-  }else{ // If Restarting, Load Restart File
+  }else if (sim.cf.restart){ // If Restarting, Load Restart File
     sim.cf.writeTimer.start();
     Log::message("Loading restart file:");
     sim.cf.loadTimer.reset();
@@ -174,7 +255,7 @@ void Fiesta::initializeSimulation(Simulation &sim){
     Log::message("Loaded restart data in: {}",sim.cf.loadTimer.get());
   }
 
-  if (sim.cf.rank==0){
+  if (sim.cf.rank==0 && !sim.cf.dryRun){
     if (!std::filesystem::exists(sim.cf.pathName)){
       Log::message("Creating directory: '{}'",sim.cf.pathName);
       std::filesystem::create_directories(sim.cf.pathName);
@@ -184,9 +265,22 @@ void Fiesta::initializeSimulation(Simulation &sim){
   sim.restartview = std::make_unique<blockWriter<FSCAL>>(sim.cf, sim.f, sim.cf.autoRestartName, sim.cf.pathName, false, sim.cf.restart_freq,!sim.cf.autoRestart);
 
   luaReader L(sim.cf.inputFname,"fiesta");
-  L.getIOBlock(sim.cf,sim.f,sim.cf.ndim,sim.ioviews);
+  L.getIOBlock(sim.cf,sim.f,sim.cf.ndim,sim.ioviews,sim.stats);
+  L.getProbes(sim.cf,sim.f,sim.probes);
   L.close();
 
+  if (!sim.probes.empty())
+    sim.f->timers["probes"] = Timer::fiestaTimer("Probe Sample Time");
+
+  // statistics accumulators are carried in restart files
+  if (!sim.stats.empty()){
+    sim.f->timers["stats"] = Timer::fiestaTimer("Statistics Update Time");
+    for (auto& s : sim.stats)
+      sim.restartview->carryStatistics(s);
+    if (sim.cf.restart && !sim.cf.dryRun)
+      readStatistics(sim.cf, sim.f, sim.stats);
+  }
+
 }
 
 // Write solutions, restarts and status checks
@@ -204,10 +298,41 @@ void Fiesta::checkIO(Simulation &sim, size_t t){
     if (t % sim.cf.stat_freq == 0) {
       sim.f->timers["statCheck"].reset();
       statusCheck(sim.cf.colorFlag, sim.cf, sim.f, sim.cf.time, sim.cf.totalTimer, sim.cf.simTimer);
+      if (sim.cf.statTimers)
+        reportTimerBalance(sim.cf, sim.f);
       sim.f->timers["statCheck"].accumulate();
     }
   }
 
+  // Accumulate statistics
+  for (auto& s : sim.stats){
+    if (t > (size_t)sim.cf.tstart && t % s->sample == 0) {
+      sim.f->timers["stats"].reset();
+      s->update(sim.cf,sim.f);
+      Kokkos::fence();
+      sim.f->timers["stats"].accumulate();
+    }
+  }
+
+  // Store a rollback snapshot once this step's statistics are sampled, so a
+  // rollback to this step keeps the sample.  checkHealth has found the
+  // solution healthy on snapshot steps.
+  if (sim.rollback && t % sim.cf.snapshot_freq == 0){
+    sim.f->timers["health"].reset();
+    sim.rollback->snapshot(sim.cf,sim.f,sim.stats);
+    sim.f->timers["health"].accumulate();
+  }
+
+  // Sample probes
+  for (auto& p : sim.probes){
+    if (t % p->frequency == 0) {
+      sim.f->timers["probes"].reset();
+      p->sample(sim.cf,sim.f,t,sim.cf.time);
+      Kokkos::fence();
+      sim.f->timers["probes"].accumulate();
+    }
+  }
+
   // Write solution file if necessary
   if (sim.cf.write_freq > 0) {
     if (t % sim.cf.write_freq == 0) {
@@ -225,38 +350,31 @@ void Fiesta::checkIO(Simulation &sim, size_t t){
     }
   }
 
-#ifdef HAVE_LIBYOGRT
-  // Check Time-Remaining and Flag Restart
-  if (sim.cf.rank==0){
-    if(yogrt_remaining() < sim.cf.restartTimeRemaining){
-      sim.cf.restartFlag = 1;
-      sim.cf.exitFlag = 1;
-      Log::error("Time remaining is less than {}s:  Writing restart and exiting after timestep {}.",sim.cf.restartTimeRemaining,sim.cf.t);
-    }
-  }
-#endif
-
-  #ifdef HAVE_MPI
-  {
-  int glblRestartFlag=0;
-  int glblExitFlag=0;
-  MPI_Allreduce(&sim.cf.restartFlag,&glblRestartFlag,1,MPI_INT,MPI_MAX,sim.cf.comm);
-  sim.cf.restartFlag=glblRestartFlag;
-  MPI_Allreduce(&sim.cf.exitFlag,&glblExitFlag,1,MPI_INT,MPI_MAX,sim.cf.comm);
-  sim.cf.exitFlag=glblExitFlag;
-  }
-  #endif
+  // Complete the signal consensus before leaving the time loop
+  if (sim.cf.exitFlag || t == (size_t)sim.cf.tend)
+    finishSignals(sim.cf);
 
   // Write restart file if necessary
   if (sim.cf.restartFlag==1){
     sim.f->timers["resWrite"].reset();
     //sim.cf.w->writeRestart(sim.cf, f, t, time);
     sim.restartview->write(sim.cf,sim.f,t,sim.cf.time);
+    for (auto& p : sim.probes)
+      p->flush();
     Kokkos::fence();
     sim.f->timers["resWrite"].accumulate();
     sim.cf.restartFlag=0;
   }
 
+  // Write node-local checkpoint if necessary
+  if (sim.cf.checkpoint_freq > 0 && t > (size_t)sim.cf.tstart) {
+    if (t % sim.cf.checkpoint_freq == 0) {
+      sim.f->timers["ckptWrite"].reset();
+      sim.cf.ckpt->write(sim.cf,sim.f,t,sim.cf.time);
+      sim.f->timers["ckptWrite"].accumulate();
+    }
+  }
+
   // Write solution blocks
   for (auto& block : sim.ioviews){
     if(block.frq() > 0){
@@ -271,20 +389,73 @@ void Fiesta::checkIO(Simulation &sim, size_t t){
       sim.cf.ioThisStep = true;
     }
   }
+
+  // Statistics of varx fields need them computed at the end of this step
+  for (auto& s : sim.stats)
+    if (s->needVarx && (t+1) % s->sample == 0)
+      sim.cf.ioThisStep = true;
+  for (auto& p : sim.probes)
+    if (p->needVarx && (t+1) % p->frequency == 0)
+      sim.cf.ioThisStep = true;
+}
+
+// Check the solution and restore the newest in-memory snapshot if it is not
+// healthy.  Snapshot steps are always checked, and the snapshot is stored by
+// checkIO.  Returns true if the solution was rolled back, in which case cf.t
+// holds the step to resume from.
+bool Fiesta::checkHealth(Simulation &sim, size_t t){
+  if (!sim.rollback) return false;
+
+  bool check = t % sim.cf.rollback_freq == 0;
+  bool snap = t % sim.cf.snapshot_freq == 0;
+  if (!check && !snap) return false;
+
+  sim.f->timers["health"].reset();
+  bool rolled = false;
+  if (!sim.rollback->healthy(sim.cf,sim.f)){
+    sim.rollback->restore(sim.cf,sim.f,sim.stats);
+    for (auto& p : sim.probes)
+      p->rewind(sim.cf.t);
+    rolled = true;
+  }
+  sim.f->timers["health"].accumulate();
+  return rolled;
 }
 
+// Reach consensus on signal flags across all ranks.  Flags raised locally are
+// posted with a nonblocking allreduce that is completed on the next call, so a
+// signal takes effect one step after it is received without a global
+// synchronization every step.
 void Fiesta::collectSignals(struct inputConfig &cf){
-#ifdef HAVE_MPI
-  int glblRestartFlag=0;
-  int glblExitFlag=0;
+  int localFlags = fiestaSignalHandler::takeFlags();
 
-  MPI_Allreduce(&cf.restartFlag,&glblRestartFlag,1,MPI_INT,MPI_MAX,cf.comm);
-  cf.restartFlag=glblRestartFlag;
+#ifdef HAVE_LIBYOGRT
+  // Check Time-Remaining and Flag Restart
+  if (cf.rank==0){
+    if(yogrt_remaining() < cf.restartTimeRemaining){
+      localFlags |= FIESTA_SIGNAL_RESTART | FIESTA_SIGNAL_EXIT;
+      Log::error("Time remaining is less than {}s:  Writing restart and exiting.",cf.restartTimeRemaining);
+    }
+  }
+#endif
 
-  MPI_Allreduce(&cf.exitFlag,&glblExitFlag,1,MPI_INT,MPI_MAX,cf.comm);
-  cf.exitFlag=glblExitFlag;
+#ifdef HAVE_MPI
+  int flags = 0;
+  if (cf.signalReq != MPI_REQUEST_NULL){
+    MPI_Wait(&cf.signalReq,MPI_STATUS_IGNORE);
+    flags = cf.signalRecv;
+  }
+  cf.signalSend = localFlags;
+  MPI_Iallreduce(&cf.signalSend,&cf.signalRecv,1,MPI_INT,MPI_BOR,cf.comm,&cf.signalReq);
+#else
+  int flags = localFlags;
 #endif
 
+  if (flags & FIESTA_SIGNAL_RESTART)
+    cf.restartFlag = 1;
+  if (flags & FIESTA_SIGNAL_EXIT)
+    cf.exitFlag = 1;
+
   if (cf.restartFlag && cf.exitFlag)
       Log::warning("Recieved SIGURG:  Writing restart and exiting after timestep {}.",cf.t);
   else if (cf.restartFlag)
@@ -293,6 +464,155 @@ void Fiesta::collectSignals(struct inputConfig &cf){
       Log::error("Recieved SIGTERM:  Exiting after timestep {}.",cf.t);
 }
 
+// Complete any outstanding signal consensus before leaving the time loop.
+// A restart requested on the final step is still honored.
+void Fiesta::finishSignals(struct inputConfig &cf){
+#ifdef HAVE_MPI
+  if (cf.signalReq != MPI_REQUEST_NULL){
+    MPI_Wait(&cf.signalReq,MPI_STATUS_IGNORE);
+    if (cf.signalRecv & FIESTA_SIGNAL_RESTART)
+      cf.restartFlag = 1;
+  }
+#endif
+}
+
+// A timer over all ranks
+struct timerStats {
+  std::string key;
+  std::string description;
+  double min, mean, max;
+  int worst;  // rank with the longest time
+};
+
+// Gather the run and module timers from every rank to rank 0.  Every rank
+// creates the same timers from the configuration, which is checked before
+// they are reduced by position; if they differ, rank 0's own times are
+// returned and ranks is set to 1.  The run timers are read as they stand while
+// the simulation is running.
+static std::vector<timerStats> gatherTimers(struct inputConfig &cf, std::unique_ptr<class rk_func>&f, bool running, int &ranks){
+  std::vector<timerStats> stats;
+  stats.push_back({"total","Total Execution Time",0,0,0,0});
+  stats.push_back({"startup","Total Startup Time",0,0,0,0});
+  stats.push_back({"simulation","Total Simulation Time",0,0,0,0});
+  for (auto& tmr : f->timers)
+    stats.push_back({tmr.first,tmr.second.describe(),0,0,0,0});
+
+  std::vector<double> local;
+  local.push_back(running ? cf.totalTimer.check() : cf.totalTimer.get());
+  local.push_back(cf.initTimer.get());
+  local.push_back(running ? cf.simTimer.check() : cf.simTimer.get());
+  for (auto& tmr : f->timers)
+    local.push_back(tmr.second.get());
+
+  size_t n = local.size();
+  std::vector<double> tmin(local), tmax(local), tsum(local);
+  std::vector<int> worst(n,cf.rank);
+  ranks = cf.numProcs;
+#ifdef HAVE_MPI
+  std::string keys;
+  for (auto& st : stats)
+    keys += st.key + "|";
+  unsigned long hash = std::hash<std::string>{}(keys), hmin, hmax;
+  MPI_Allreduce(&hash, &hmin, 1, MPI_UNSIGNED_LONG, MPI_MIN, cf.comm);
+  MPI_Allreduce(&hash, &hmax, 1, MPI_UNSIGNED_LONG, MPI_MAX, cf.comm);
+  if (hmin != hmax){
+    Log::warning("Ranks have different timers, timer statistics are only reported for rank 0");
+    ranks = 1;
+  }else{
+    struct rankTime { double v; int r; };
+    std::vector<rankTime> lmax(n), gmax(n);
+    for (size_t i = 0; i < n; ++i)
+      lmax[i] = {local[i], cf.rank};
+    MPI_Reduce(local.data(), tmin.data(), n, MPI_DOUBLE, MPI_MIN, 0, cf.comm);
+    MPI_Reduce(local.data(), tsum.data(), n, MPI_DOUBLE, MPI_SUM, 0, cf.comm);
+    MPI_Reduce(lmax.data(), gmax.data(), n, MPI_DOUBLE_INT, MPI_MAXLOC, 0, cf.comm);
+    for (size_t i = 0; i < n; ++i){
+      tmax[i] = gmax[i].v;
+      worst[i] = gmax[i].r;
+    }
+  }
+#endif
+
+  for (size_t i = 0; i < n; ++i){
+    stats[i].min = tmin[i];
+    stats[i].mean = tsum[i]/ranks;
+    stats[i].max = tmax[i];
+    stats[i].worst = worst[i];
+  }
+  return stats;
+}
+
+// ratio of the slowest rank to the mean
+static double imbalance(const timerStats &st){
+  return (st.mean > 0.0) ? st.max/st.mean : 1.0;
+}
+
+// Print the spread of each timer over the ranks, slowest first
+static void printTimerBalance(struct inputConfig &cf, std::vector<timerStats> stats){
+  using fmt::format;
+  ansiColors c(cf.colorFlag);
+
+  std::stable_sort(stats.begin()+3, stats.end(), [](const timerStats &a, const timerStats &b){
+      return a.max > b.max; });
+
+  string headFormat = format("{: >8}{}{{: <32}}{{: >12}}{{: >12}}{{: >12}}{{: >10}}{{: >8}}{}\n","",c(green),c(reset));
+  string rowFormat = format("{: >8}{{: <32}}{{:12.3e}}{{:12.3e}}{{:12.3e}}{{:10.2f}}{{: >8}}\n","");
+  cout << format(headFormat,format("Timers Over {} Ranks",cf.numProcs),"Min","Mean","Max","Max/Mean","Rank");
+  for (auto& st : stats)
+    cout << format(rowFormat,st.description,st.min,st.mean,st.max,imbalance(st),st.worst);
+  cout << std::flush;
+}
+
+static std::string jsonString(std::string s){
+  std::string e = "\"";
+  for (char ch : s){
+    if (ch == '"' || ch == '\\') e += '\\';
+    e += ch;
+  }
+  return e + "\"";
+}
+
+// Write the timer statistics as JSON and CSV for post-processing
+static void writeTimers(struct inputConfig &cf, std::vector<timerStats> &stats, int ranks){
+  std::string base = format("{}/{}",cf.pathName,cf.timerFile);
+
+  FILE *json = fopen((base + ".json").c_str(), "w");
+  FILE *csv = fopen((base + ".csv").c_str(), "w");
+  if (!json || !csv){
+    Log::warning("Could not write timer files '{}.json' and '{}.csv'",base,base);
+    if (json) fclose(json);
+    if (csv) fclose(csv);
+    return;
+  }
+
+  // ranks is 1 when the timers could not be combined and are rank 0's own
+  fmt::print(json,"{{\n  \"title\": {},\n  \"ranks\": {},\n  \"steps\": {},\n  \"timers\": [\n",
+             jsonString(cf.title),ranks,cf.t-cf.tstart);
+  fmt::print(csv,"key,description,min,mean,max,imbalance,worst_rank\n");
+  for (size_t i = 0; i < stats.size(); ++i){
+    const timerStats &st = stats[i];
+    fmt::print(json,"    {{\"key\": {}, \"description\": {}, \"min\": {:.6e}, \"mean\": {:.6e}, \"max\": {:.6e}, \"imbalance\": {:.4f}, \"worst_rank\": {}}}{}\n",
+               jsonString(st.key),jsonString(st.description),st.min,st.mean,st.max,imbalance(st),st.worst,
+               (i+1 < stats.size()) ? "," : "");
+    fmt::print(csv,"{},\"{}\",{:.6e},{:.6e},{:.6e},{:.4f},{}\n",
+               st.key,st.description,st.min,st.mean,st.max,imbalance(st),st.worst);
+  }
+  fmt::print(json,"  ]\n}}\n");
+  fclose(json);
+  fclose(csv);
+  Log::message("Wrote timer statistics to '{}.json' and '{}.csv'",base,base);
+}
+
+// Report the spread of the timers over the ranks
+void Fiesta::reportTimerBalance(struct inputConfig &cf, std::unique_ptr<class rk_func>&f){
+  int ranks;
+  std::vector<timerStats> stats = gatherTimers(cf,f,true,ranks);
+  if (cf.rank == 0 && ranks > 1){
+    Log::message("[{}] Reporting Timer Balance",cf.t);
+    printTimerBalance(cf,stats);
+  }
+}
+
 void Fiesta::reportTimers(struct inputConfig &cf, std::unique_ptr<class rk_func>&f){
   Log::message("Reporting Timers:");
   // Sort computer timers
@@ -317,6 +637,8 @@ void Fiesta::reportTimers(struct inputConfig &cf, std::unique_ptr<class rk_func>
     cout << format(timerFormat,c(green),"Total Startup Time",cf.initTimer.get());
     if (cf.restart==1)
       cout << format(timerFormat,c(reset),"Restart Read",cf.loadTimer.get());
+    else if (cf.initCacheHit)
+      cout << format(timerFormat,c(reset),"Initial Condition Cache Read",cf.loadTimer.get());
     else{
       cout << format(timerFormat,c(reset),"Initial Condition Generation",cf.loadTimer.get());
       cout << format(timerFormat,c(reset),"Grid Generation",cf.gridTimer.get());
@@ -328,6 +650,24 @@ void Fiesta::reportTimers(struct inputConfig &cf, std::unique_ptr<class rk_func>
     for (auto tmr : stmr)
       cout << format(timerFormat,c(reset),tmr.second.describe(),tmr.second.get());
   }
+
+  int ranks;
+  std::vector<timerStats> stats = gatherTimers(cf,f,false,ranks);
+  if (cf.rank == 0){
+    if (ranks > 1){
+      cout << "\n";
+      printTimerBalance(cf,stats);
+    }
+    if (!cf.timerFile.empty() && !cf.dryRun)
+      writeTimers(cf,stats,ranks);
+  }
+}
+
+// Outstanding asynchronous writes reference the simulation's buffers
+Fiesta::Simulation::~Simulation(){
+  for (auto& p : probes)
+    p->flush();
+  ioThread::instance().drain();
 }
 
 void Fiesta::step(Simulation &sim, size_t t){
@@ -26,15 +26,22 @@
 #include <iostream>
 #include <vector>
 #include "block.hpp"
+#include "rollback.hpp"
+#include "stats.hpp"
+#include "probes.hpp"
 #include <memory>
 
 #define FIESTA_RESTART_VERSION 2
 
 namespace Fiesta {
     struct Simulation {
+      ~Simulation();
       std::unique_ptr<class rk_func> f;
       std::unique_ptr<blockWriter<FSCAL>> restartview;
       std::vector<blockWriter<float>> ioviews;
+      std::unique_ptr<rollbackRing> rollback;
+      std::vector<std::shared_ptr<runningStats>> stats;
+      std::vector<std::shared_ptr<probeGroup>> probes;
       fsconf cf;
     };
 
@@ -42,10 +49,13 @@ namespace Fiesta {
     void initializeSimulation(struct inputConfig&, std::unique_ptr<class rk_func>&);
     void initializeSimulation(Simulation &sim);
     void reportTimers(struct inputConfig&, std::unique_ptr<class rk_func>&);
+    void reportTimerBalance(struct inputConfig&, std::unique_ptr<class rk_func>&);
     void checkIO(Simulation &sim, size_t t);
+    bool checkHealth(Simulation &sim, size_t t);
     //void finalize(struct inputConfig &);
     void step(Simulation &sim, size_t t);
     void collectSignals(struct inputConfig &cf);
+    void finishSignals(struct inputConfig &cf);
     void finalize();
     int fiestaTest(int,int);
 
@@ -42,7 +42,7 @@ gen2d_func::gen2d_func(struct inputConfig &cf_) : rk_func(cf_) {
     varNames.push_back("Density " + cf.speciesName[v]);
   assert(varNames.size() == cf.nvt);
 
-  if (cf.noise == 1) {
+  if (cf.noise || cf.rollbackNoise) {
     noise = FS2D_I("noise", cf.ngi, cf.ngj); // Noise indicator array
   }
 
@@ -88,7 +88,7 @@ gen2d_func::gen2d_func(struct inputConfig &cf_) : rk_func(cf_) {
   timers["halo"] = Timer::fiestaTimer("Halo Exchanges");
   timers["bc"] = Timer::fiestaTimer("Boundary Conditions");
   timers["calcMetrics"] = Timer::fiestaTimer("Metric Calculations");
-  if (cf.noise == 1) {
+  if (cf.noise || cf.rollbackNoise) {
     timers["noise"] = Timer::fiestaTimer("Noise Removal");
   }
 
@@ -136,7 +136,8 @@ void gen2d_func::preStep() {
 void gen2d_func::postStep() {
 
   if (( (cf.write_freq >0) && (cf.t % cf.write_freq == 0) )||
-      ( (cf.stat_freq  >0) && (cf.t % cf.stat_freq  == 0) )){
+      ( (cf.stat_freq  >0) && (cf.t % cf.stat_freq  == 0) )||
+      cf.ioThisStep){
 
       timers["calcSecond"].reset();
       Kokkos::parallel_for(ghostPol, calculateRhoPT2D(var, p, rho, T, cd));
@@ -115,7 +115,8 @@ void gen3d_func::postStep() {
 
   // Copy secondary variables to extra variables array
   if (( (cf.write_freq >0) && (cf.t % cf.write_freq == 0) )||
-      ( (cf.stat_freq  >0) && (cf.t % cf.stat_freq  == 0) )){
+      ( (cf.stat_freq  >0) && (cf.t % cf.stat_freq  == 0) )||
+      cf.ioThisStep){
 
       timers["calcSecond"].reset();
       Kokkos::parallel_for(ghost_pol, calculateRhoPT3D(var, p, rho, T, cd));
@@ -336,6 +337,7 @@ void gen3d_func::preSim() {
 void gen3d_func::postSim() {}
 
 void gen3d_func::compute() {
+  applyBCs(cf,this);
   // create range policies
   policy_f3 ghost_pol = policy_f3({0, 0, 0}, {cf.ngi, cf.ngj, cf.ngk});
   policy_f3 cell_pol = policy_f3(
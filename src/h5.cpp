@@ -29,17 +29,145 @@
 #include "debug.hpp"
 #include "kokkosTypes.hpp"
 
-// open and hdf5 file for writing
+h5Tuning& h5Settings(){
+  static h5Tuning settings;
+  return settings;
+}
+
+// describe the settings that differ from the defaults, for write rate logs
+std::string h5Tuning::summary(){
+  std::vector<std::string> items;
+  if (alignment > 0)
+    items.push_back(fmt::format("align {}",alignment));
+  if (collectiveMetadata)
+    items.push_back("collective metadata");
+  if (metadataCache > 0)
+    items.push_back(fmt::format("cache {:.0f} MiB",metadataCache/1048576.0));
+  if (!collectiveTransfer)
+    items.push_back("independent");
+  if (!chunk.empty()){
+    std::string shape;
+    for (auto c : chunk)
+      shape += fmt::format("x{}",c);
+    items.push_back(fmt::format("chunk {}",shape.substr(1)));
+  }
+  for (auto const& [key, value] : hints)
+    items.push_back(fmt::format("{}={}",key,value));
+
+  std::string tag;
+  for (auto const& item : items)
+    tag += fmt::format(", {}",item);
+  return tag.empty() ? tag : tag.substr(2);
+}
+
 template <typename T>
 h5Writer<T>::h5Writer(){}
 
+// file access properties with the configured tuning
+#ifdef HAVE_MPI
+template <typename T>
+hid_t h5Writer<T>::accessList(MPI_Comm comm, MPI_Info info){
+  h5Tuning& tune = h5Settings();
+  hid_t pid = H5Pcreate(H5P_FILE_ACCESS);
+
+  if (tune.hints.empty()){
+    H5Pset_fapl_mpio(pid, comm, info);
+  }else{
+    MPI_Info hinted;
+    if (info == MPI_INFO_NULL)
+      MPI_Info_create(&hinted);
+    else
+      MPI_Info_dup(info, &hinted);
+    for (auto const& [key, value] : tune.hints)
+      MPI_Info_set(hinted, key.c_str(), value.c_str());
+    H5Pset_fapl_mpio(pid, comm, hinted);
+    MPI_Info_free(&hinted);
+  }
+
+#ifdef H5_HAVE_PARALLEL
+  if (tune.collectiveMetadata){
+    H5Pset_all_coll_metadata_ops(pid, true);
+    H5Pset_coll_metadata_write(pid, true);
+  }
+#endif
+#else
+template <typename T>
+hid_t h5Writer<T>::accessList(){
+  h5Tuning& tune = h5Settings();
+  hid_t pid = H5Pcreate(H5P_FILE_ACCESS);
+#endif
+
+  if (tune.alignment > 0)
+    H5Pset_alignment(pid, tune.alignThreshold, tune.alignment);
+
+  if (tune.metadataCache > 0){
+    H5AC_cache_config_t mdc;
+    mdc.version = H5AC__CURR_CACHE_CONFIG_VERSION;
+    H5Pget_mdc_config(pid, &mdc);
+    mdc.set_initial_size = true;
+    mdc.initial_size = tune.metadataCache;
+    mdc.max_size = std::max(mdc.max_size, tune.metadataCache);
+    mdc.min_size = std::min(mdc.min_size, tune.metadataCache);
+    H5Pset_mdc_config(pid, &mdc);
+  }
+
+  return pid;
+}
+
+// dataset transfer properties, collective unless configured otherwise
+template <typename T>
+hid_t h5Writer<T>::transferList(){
+  hid_t plist_id = H5Pcreate(H5P_DATASET_XFER);
+#ifdef HAVE_MPI
+  H5Pset_dxpl_mpio(plist_id, h5Settings().collectiveTransfer ? H5FD_MPIO_COLLECTIVE : H5FD_MPIO_INDEPENDENT);
+#endif
+  return plist_id;
+}
+
+// Chunk dimensions for a dataset, in "c" order.  The configured chunk shape is
+// used when there is one, so chunks do not depend on the decomposition,
+// otherwise each rank's block is one chunk.
+template <typename T>
+std::vector<hsize_t> h5Writer<T>::chunkDims(std::vector<hsize_t> gdims, std::vector<hsize_t> ldims){
+  std::vector<size_t>& shape = h5Settings().chunk;
+  if (shape.empty())
+    return ldims;
+
+  int ndim = gdims.size();
+  std::vector<hsize_t> cdims(ndim);
+  for (int d=0; d<ndim; ++d){
+    hsize_t c = (d < (int)shape.size()) ? shape[d] : gdims[ndim-1-d];
+    cdims[ndim-1-d] = std::max((hsize_t)1, std::min(c, gdims[ndim-1-d]));
+  }
+  return cdims;
+}
+
+// Chunk dimensions covering a whole dataset, halved along the largest
+// dimension until a chunk is at most 64 MiB.  All ranks get the same chunks.
+template <typename T>
+std::vector<hsize_t> h5Writer<T>::boundedChunk(std::vector<hsize_t> gdims){
+  std::vector<hsize_t> cdims(gdims);
+  size_t bytes = sizeof(T);
+  for (auto d : cdims) bytes *= d;
+  while (bytes > 67108864){
+    auto big = std::max_element(cdims.begin(), cdims.end());
+    bytes = bytes / *big * ((*big+1)/2);
+    *big = (*big+1)/2;
+  }
+  return cdims;
+}
+
+template <typename T>
+void h5Writer<T>::deflate(int level){
+  deflateLevel = level;
+}
+
 #ifdef HAVE_MPI
 template <typename T>
 void h5Writer<T>::open(MPI_Comm comm, MPI_Info info, std::string fname){
   hid_t pid;
 
-  pid = H5Pcreate(H5P_FILE_ACCESS);
-  H5Pset_fapl_mpio(pid, comm, info);
+  pid = accessList(comm, info);
   file_id = H5Fcreate(fname.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, pid);
   H5Pclose(pid);
   MPI_Barrier(comm);
@@ -49,16 +177,51 @@ template <typename T>
 void h5Writer<T>::open(std::string fname){
   hid_t pid;
 
-  pid = H5Pcreate(H5P_FILE_ACCESS);
+  pid = accessList();
   file_id = H5Fcreate(fname.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, pid);
   H5Pclose(pid);
 }
 #endif
 
+#ifdef HAVE_MPI
+// open an hdf5 file for collective reads through MPI-IO
+template <typename T>
+void h5Writer<T>::openRead(MPI_Comm comm, MPI_Info info, std::string fname){
+  hid_t pid;
+
+  pid = accessList(comm, info);
+  filename = fname;
+  file_id = H5Fopen(fname.c_str(), H5F_ACC_RDONLY, pid);
+  H5Pclose(pid);
+}
+
+// open an existing hdf5 file to add to it
+template <typename T>
+void h5Writer<T>::openAppend(MPI_Comm comm, MPI_Info info, std::string fname){
+  hid_t pid;
+
+  pid = accessList(comm, info);
+  filename = fname;
+  file_id = H5Fopen(fname.c_str(), H5F_ACC_RDWR, pid);
+  H5Pclose(pid);
+}
+#else
 template <typename T>
 void h5Writer<T>::openRead(std::string fname){
-  file_id = H5Fopen(fname.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+  hid_t pid = accessList();
+  filename = fname;
+  file_id = H5Fopen(fname.c_str(), H5F_ACC_RDONLY, pid);
+  H5Pclose(pid);
+}
+
+template <typename T>
+void h5Writer<T>::openAppend(std::string fname){
+  hid_t pid = accessList();
+  filename = fname;
+  file_id = H5Fopen(fname.c_str(), H5F_ACC_RDWR, pid);
+  H5Pclose(pid);
 }
+#endif
 
 // close an hdf5 file
 template <typename T>
@@ -70,10 +233,9 @@ void h5Writer<T>::close(){
 template <typename T>
 void h5Writer<T>::write(std::string dname, int ndim,
   std::vector<size_t> in_dims_global, std::vector<size_t> in_dims_local, std::vector<size_t> in_offset,
-  std::vector<T>& data,
+  T* data,
   bool chunkable,
   bool compress){
-  
 
   std::vector<hsize_t> gdims(ndim,0);
   std::vector<hsize_t> ldims(ndim,0);
@@ -84,6 +246,44 @@ void h5Writer<T>::write(std::string dname, int ndim,
   std::reverse_copy(in_dims_local.begin(),in_dims_local.end(),ldims.begin());
   std::reverse_copy(in_offset.begin(),in_offset.end(),offset.begin());
 
+  writeDataset(dname, gdims, ldims, offset, chunkDims(gdims,ldims), data, chunkable, compress);
+}
+
+// write nfields variables as a single dataset with the field index slowest.
+// data holds the local block of each field back to back.
+template <typename T>
+void h5Writer<T>::writeFields(std::string dname, int ndim, size_t nfields,
+  std::vector<size_t> in_dims_global, std::vector<size_t> in_dims_local, std::vector<size_t> in_offset,
+  T* data,
+  bool chunkable,
+  bool compress){
+
+  std::vector<hsize_t> gdims(ndim+1,nfields);
+  std::vector<hsize_t> ldims(ndim+1,nfields);
+  std::vector<hsize_t> offset(ndim+1,0);
+
+  // reverse order of array indexes to "c"
+  std::reverse_copy(in_dims_global.begin(),in_dims_global.end(),gdims.begin()+1);
+  std::reverse_copy(in_dims_local.begin(),in_dims_local.end(),ldims.begin()+1);
+  std::reverse_copy(in_offset.begin(),in_offset.end(),offset.begin()+1);
+
+  // one field per chunk
+  std::vector<hsize_t> cdims = chunkDims(std::vector<hsize_t>(gdims.begin()+1,gdims.end()),
+                                         std::vector<hsize_t>(ldims.begin()+1,ldims.end()));
+  cdims.insert(cdims.begin(), 1);
+
+  writeDataset(dname, gdims, ldims, offset, cdims, data, chunkable, compress);
+}
+
+template <typename T>
+void h5Writer<T>::writeDataset(std::string dname,
+  std::vector<hsize_t> gdims, std::vector<hsize_t> ldims, std::vector<hsize_t> offset, std::vector<hsize_t> cdims,
+  T* data,
+  bool chunkable,
+  bool compress){
+
+  int rank = gdims.size();
+
   // identifiers
   hid_t filespace, memspace, dset_id, plist_id, dtype_id, dcpl_id;
   unsigned szip_options_mask, szip_pixels_per_block;
@@ -93,10 +293,19 @@ void h5Writer<T>::write(std::string dname, int ndim,
   if (std::is_same<T,float>::value) dtype_id = H5T_NATIVE_FLOAT;
   if (std::is_same<T,int>::value) dtype_id = H5T_NATIVE_INT;
 
+  // filters need chunks, so without per-rank chunks use chunks shared by all ranks
+  if (deflateLevel > 0 && !chunkable){
+    cdims = boundedChunk(gdims);
+    chunkable = true;
+  }
+
   if (chunkable){
     dcpl_id = H5Pcreate(H5P_DATASET_CREATE);
-    H5Pset_chunk(dcpl_id,ndim,ldims.data());
-    if(compress){
+    H5Pset_chunk(dcpl_id,rank,cdims.data());
+    if (deflateLevel > 0){
+      H5Pset_shuffle(dcpl_id);
+      H5Pset_deflate(dcpl_id, deflateLevel);
+    }else if(compress){
       szip_options_mask=H5_SZIP_NN_OPTION_MASK;
       szip_pixels_per_block=32;
       H5Pset_szip (dcpl_id, szip_options_mask, szip_pixels_per_block);
@@ -106,8 +315,8 @@ void h5Writer<T>::write(std::string dname, int ndim,
   }
 
   // create global filespace and local memoryspace
-  filespace = H5Screate_simple(ndim, gdims.data(), NULL);
-  memspace  = H5Screate_simple(ndim, ldims.data(), NULL);
+  filespace = H5Screate_simple(rank, gdims.data(), NULL);
+  memspace  = H5Screate_simple(rank, ldims.data(), NULL);
 
   // create dataset
   dset_id = H5Dcreate(group_id, dname.c_str(), dtype_id, filespace,
@@ -121,16 +330,14 @@ void h5Writer<T>::write(std::string dname, int ndim,
   //status = H5Sselect_hyperslab(filespace, H5S_SELECT_SET, offset, NULL, dims_local, NULL);
 
   // create property list for collective dataset write
-  plist_id = H5Pcreate(H5P_DATASET_XFER);
-#ifdef HAVE_MPI
-  H5Pset_dxpl_mpio(plist_id, H5FD_MPIO_COLLECTIVE);
-#endif
+  plist_id = transferList();
 
   // write data
-  H5Dwrite(dset_id, dtype_id, memspace, filespace, plist_id, data.data());
+  H5Dwrite(dset_id, dtype_id, memspace, filespace, plist_id, data);
   //status = H5Dwrite(dset_id, dtype_id, memspace, filespace, plist_id, data);
 
   // close sets, spaces and lists
+  if (chunkable) H5Pclose(dcpl_id);
   H5Dclose(dset_id);
   H5Sclose(filespace);
   H5Sclose(memspace);
@@ -199,6 +406,14 @@ void h5Writer<float>::writeAttribute(std::string name, std::string data){
 
 template <typename T>
 void h5Writer<T>::read(std::string path, int ndim, std::vector<size_t> in_dims_global, std::vector<size_t> in_dims_local, std::vector<size_t> in_offset, T* data){
+  readFields(std::vector<std::string>{path}, ndim, in_dims_global, in_dims_local, in_offset, data);
+}
+
+// Read this rank's block of several datasets of the same shape.  The blocks
+// are stored back to back in data with i fastest.  Reads are collective, and
+// are issued as a single H5Dread_multi where the library supports it.
+template <typename T>
+void h5Writer<T>::readFields(std::vector<std::string> paths, int ndim, std::vector<size_t> in_dims_global, std::vector<size_t> in_dims_local, std::vector<size_t> in_offset, T* data){
   std::vector<hsize_t> gdims(ndim,0);
   std::vector<hsize_t> ldims(ndim,0);
   std::vector<hsize_t> offset(ndim,0);
@@ -210,35 +425,61 @@ void h5Writer<T>::read(std::string path, int ndim, std::vector<size_t> in_dims_g
 
   //Log::debugAll("{} {} {}",gdims,ldims,offset);
 
+  size_t nfields = paths.size();
+  size_t nelems = 1;
+  for (auto d : ldims) nelems *= d;
+
   // identifiers
-  hid_t dset_id, filespace, memspace, dtype_id;
+  std::vector<hid_t> dset_id(nfields), filespace(nfields), memspace(nfields), dtype_id(nfields);
+  std::vector<void *> buf(nfields);
+  hid_t plist_id;
   //herr_t status;
 
-  // get hd5 datatype
-  if (std::is_same<T,FSCAL>::value) dtype_id = H5T_NATIVE_DOUBLE;
-  if (std::is_same<T,float>::value) dtype_id = H5T_NATIVE_FLOAT;
-  if (std::is_same<T,int>::value) dtype_id = H5T_NATIVE_INT;
+  for (size_t f=0; f<nfields; ++f){
+    // get hd5 datatype
+    if (std::is_same<T,FSCAL>::value) dtype_id[f] = H5T_NATIVE_DOUBLE;
+    if (std::is_same<T,float>::value) dtype_id[f] = H5T_NATIVE_FLOAT;
+    if (std::is_same<T,int>::value) dtype_id[f] = H5T_NATIVE_INT;
+
+    // open dataset
+    dset_id[f] = H5Dopen(file_id,paths[f].c_str(),H5P_DEFAULT);
+    if (dset_id[f] < 0){
+      Log::error("Could not find '{}' in '{}'.",paths[f],filename);
+      exit(EXIT_FAILURE);
+    }
 
-  // open dataset
-  dset_id = H5Dopen(file_id,path.c_str(),H5P_DEFAULT);
+    // get filespace
+    filespace[f] = H5Dget_space(dset_id[f]);    /* Get filespace handle first. */
 
-  // get filespace
-  filespace = H5Dget_space(dset_id);    /* Get filespace handle first. */
+    // check dimensions
+    checkDataDimensions(filespace[f], ndim, gdims);
 
-  // check dimensions
-  checkDataDimensions(filespace, ndim, gdims);
+    // specify memory space for this mpi rank
+    memspace[f] =  H5Screate_simple(ndim, ldims.data(), NULL);
+
+    // select this rank's hyperslab
+    H5Sselect_hyperslab(filespace[f], H5S_SELECT_SET, offset.data(), NULL, ldims.data(), NULL);
+    buf[f] = data + nelems*f;
+  }
 
-  // specify memory space for this mpi rank
-  memspace =  H5Screate_simple(ndim, ldims.data(), NULL);
+  // create property list for collective dataset read
+  plist_id = transferList();
 
-  // create hyperslab and read data
-  H5Sselect_hyperslab(filespace, H5S_SELECT_SET, offset.data(), NULL, ldims.data(), NULL);
-  H5Dread(dset_id, dtype_id, memspace, filespace, H5P_DEFAULT, data);
+  // read data
+#if H5_VERSION_GE(1,14,0)
+  H5Dread_multi(nfields, dset_id.data(), dtype_id.data(), memspace.data(), filespace.data(), plist_id, buf.data());
+#else
+  for (size_t f=0; f<nfields; ++f)
+    H5Dread(dset_id[f], dtype_id[f], memspace[f], filespace[f], plist_id, buf[f]);
+#endif
 
   // close identifiers
-  H5Sclose(memspace);
-  H5Sclose(filespace);
-  H5Dclose(dset_id);
+  H5Pclose(plist_id);
+  for (size_t f=0; f<nfields; ++f){
+    H5Sclose(memspace[f]);
+    H5Sclose(filespace[f]);
+    H5Dclose(dset_id[f]);
+  }
 }
 
 template <typename T>
@@ -299,11 +540,21 @@ void h5Writer<double>::readAttribute(std::string name, std::string& data){
   H5Gclose(gpid);
 }
 
-
+// Check for an attribute in the Properties group
+template <typename T>
+bool h5Writer<T>::hasAttribute(std::string name){
+  hid_t gpid = H5Gopen(file_id,"Properties",H5P_DEFAULT);
+  htri_t found = H5Aexists(gpid,name.c_str());
+  H5Gclose(gpid);
+  return found > 0;
+}
 
 template <typename T>
 void h5Writer<T>::openGroup(std::string name){
-  group_id = H5Gcreate(file_id, name.c_str(), H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+  if (H5Lexists(file_id, name.c_str(), H5P_DEFAULT) > 0)
+    group_id = H5Gopen(file_id, name.c_str(), H5P_DEFAULT);
+  else
+    group_id = H5Gcreate(file_id, name.c_str(), H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
 }
 
 template <typename T>
@@ -311,6 +562,288 @@ void h5Writer<T>::closeGroup(){
   H5Gclose(group_id);
 }
 
+// Create an empty series with cols columns and no limit on rows.  Chunks hold
+// whole rows and are kept to about a megabyte.
+template <typename T>
+void h5Writer<T>::createSeries(std::string path, size_t cols, size_t chunkRows){
+  hid_t filespace, dset_id, dcpl_id, dtype_id;
+
+  if (std::is_same<T,FSCAL>::value) dtype_id = H5T_NATIVE_DOUBLE;
+  if (std::is_same<T,float>::value) dtype_id = H5T_NATIVE_FLOAT;
+  if (std::is_same<T,int>::value) dtype_id = H5T_NATIVE_INT;
+
+  chunkRows = std::max((size_t)1, std::min(chunkRows, (size_t)1048576/(cols*sizeof(T))));
+
+  hsize_t dims[2] = {0, cols};
+  hsize_t maxdims[2] = {H5S_UNLIMITED, cols};
+  hsize_t cdims[2] = {chunkRows, cols};
+
+  filespace = H5Screate_simple(2, dims, maxdims);
+  dcpl_id = H5Pcreate(H5P_DATASET_CREATE);
+  H5Pset_chunk(dcpl_id, 2, cdims);
+  dset_id = H5Dcreate(file_id, path.c_str(), dtype_id, filespace, H5P_DEFAULT, dcpl_id, H5P_DEFAULT);
+
+  H5Dclose(dset_id);
+  H5Pclose(dcpl_id);
+  H5Sclose(filespace);
+}
+
+// Extend a series by rows and write this rank's columns of the new rows.
+// Collective, so ranks without data call it with cols=0.
+template <typename T>
+void h5Writer<T>::appendSeries(std::string path, size_t rows, size_t colOffset, size_t cols, T* data){
+  hid_t filespace, memspace, dset_id, plist_id, dtype_id;
+
+  if (std::is_same<T,FSCAL>::value) dtype_id = H5T_NATIVE_DOUBLE;
+  if (std::is_same<T,float>::value) dtype_id = H5T_NATIVE_FLOAT;
+  if (std::is_same<T,int>::value) dtype_id = H5T_NATIVE_INT;
+
+  dset_id = H5Dopen(file_id, path.c_str(), H5P_DEFAULT);
+
+  hsize_t dims[2];
+  filespace = H5Dget_space(dset_id);
+  H5Sget_simple_extent_dims(filespace, dims, NULL);
+  H5Sclose(filespace);
+
+  hsize_t start[2] = {dims[0], colOffset};
+  hsize_t count[2] = {rows, cols};
+  dims[0] += rows;
+  H5Dset_extent(dset_id, dims);
+
+  filespace = H5Dget_space(dset_id);
+  memspace = H5Screate_simple(2, count, NULL);
+  if (rows*cols > 0){
+    H5Sselect_hyperslab(filespace, H5S_SELECT_SET, start, NULL, count, NULL);
+  }else{
+    H5Sselect_none(filespace);
+    H5Sselect_none(memspace);
+  }
+
+  plist_id = transferList();
+
+  H5Dwrite(dset_id, dtype_id, memspace, filespace, plist_id, data);
+
+  H5Pclose(plist_id);
+  H5Sclose(memspace);
+  H5Sclose(filespace);
+  H5Dclose(dset_id);
+}
+
+template <typename T>
+std::vector<size_t> h5Writer<T>::seriesDims(std::string path){
+  hid_t dset_id = H5Dopen(file_id, path.c_str(), H5P_DEFAULT);
+  hid_t filespace = H5Dget_space(dset_id);
+  hsize_t dims[2];
+  H5Sget_simple_extent_dims(filespace, dims, NULL);
+  H5Sclose(filespace);
+  H5Dclose(dset_id);
+  return {dims[0], dims[1]};
+}
+
+template <typename T>
+bool h5Writer<T>::hasDataset(std::string path){
+  return H5Lexists(file_id, path.c_str(), H5P_DEFAULT) > 0;
+}
+
+// read a whole series on every rank
+template <typename T>
+void h5Writer<T>::readSeries(std::string path, T* data){
+  hid_t dset_id, dtype_id;
+
+  if (std::is_same<T,FSCAL>::value) dtype_id = H5T_NATIVE_DOUBLE;
+  if (std::is_same<T,float>::value) dtype_id = H5T_NATIVE_FLOAT;
+  if (std::is_same<T,int>::value) dtype_id = H5T_NATIVE_INT;
+
+  dset_id = H5Dopen(file_id, path.c_str(), H5P_DEFAULT);
+  H5Dread(dset_id, dtype_id, H5S_ALL, H5S_ALL, H5P_DEFAULT, data);
+  H5Dclose(dset_id);
+}
+
+// drop rows from the end of a series
+template <typename T>
+void h5Writer<T>::resizeSeries(std::string path, size_t rows){
+  hid_t dset_id = H5Dopen(file_id, path.c_str(), H5P_DEFAULT);
+  hid_t filespace = H5Dget_space(dset_id);
+  hsize_t dims[2];
+  H5Sget_simple_extent_dims(filespace, dims, NULL);
+  H5Sclose(filespace);
+  dims[0] = rows;
+  H5Dset_extent(dset_id, dims);
+  H5Dclose(dset_id);
+}
+
+// Write one entry of a time series dataset.  The dataset is created on first
+// use and resized to index+1 entries, so writing an earlier index discards the
+// entries after it.
+template <typename T>
+void h5Writer<T>::writeEntry(std::string dname, size_t index, int ndim,
+  std::vector<size_t> in_dims_global, std::vector<size_t> in_dims_local, std::vector<size_t> in_offset,
+  T* data,
+  bool chunkable,
+  bool compress){
+
+  std::vector<hsize_t> gdims(ndim,0);
+  std::vector<hsize_t> ldims(ndim,0);
+  std::vector<hsize_t> offset(ndim,0);
+
+  // reverse order of array indexes to "c"
+  std::reverse_copy(in_dims_global.begin(),in_dims_global.end(),gdims.begin());
+  std::reverse_copy(in_dims_local.begin(),in_dims_local.end(),ldims.begin());
+  std::reverse_copy(in_offset.begin(),in_offset.end(),offset.begin());
+
+  writeEntryDataset(dname, index, gdims, ldims, offset, chunkDims(gdims,ldims), data, chunkable, compress);
+}
+
+template <typename T>
+void h5Writer<T>::writeEntryFields(std::string dname, size_t index, int ndim, size_t nfields,
+  std::vector<size_t> in_dims_global, std::vector<size_t> in_dims_local, std::vector<size_t> in_offset,
+  T* data,
+  bool chunkable,
+  bool compress){
+
+  std::vector<hsize_t> gdims(ndim+1,nfields);
+  std::vector<hsize_t> ldims(ndim+1,nfields);
+  std::vector<hsize_t> offset(ndim+1,0);
+
+  // reverse order of array indexes to "c"
+  std::reverse_copy(in_dims_global.begin(),in_dims_global.end(),gdims.begin()+1);
+  std::reverse_copy(in_dims_local.begin(),in_dims_local.end(),ldims.begin()+1);
+  std::reverse_copy(in_offset.begin(),in_offset.end(),offset.begin()+1);
+
+  // one field per chunk
+  std::vector<hsize_t> cdims = chunkDims(std::vector<hsize_t>(gdims.begin()+1,gdims.end()),
+                                         std::vector<hsize_t>(ldims.begin()+1,ldims.end()));
+  cdims.insert(cdims.begin(), 1);
+
+  writeEntryDataset(dname, index, gdims, ldims, offset, cdims, data, chunkable, compress);
+}
+
+template <typename T>
+void h5Writer<T>::writeEntryDataset(std::string dname, size_t index,
+  std::vector<hsize_t> gdims, std::vector<hsize_t> ldims, std::vector<hsize_t> offset, std::vector<hsize_t> cdims,
+  T* data,
+  bool chunkable,
+  bool compress){
+
+  hid_t filespace, memspace, dset_id, plist_id, dtype_id, dcpl_id;
+
+  if (std::is_same<T,FSCAL>::value) dtype_id = H5T_NATIVE_DOUBLE;
+  if (std::is_same<T,float>::value) dtype_id = H5T_NATIVE_FLOAT;
+  if (std::is_same<T,int>::value) dtype_id = H5T_NATIVE_INT;
+
+  // entries are always chunked, one entry per chunk.  Without per-rank chunks
+  // the whole entry is split until chunks are at most 64 MiB.
+  if (!chunkable)
+    cdims = boundedChunk(gdims);
+
+  gdims.insert(gdims.begin(), index+1);
+  ldims.insert(ldims.begin(), 1);
+  offset.insert(offset.begin(), index);
+  cdims.insert(cdims.begin(), 1);
+  std::vector<hsize_t> maxdims(gdims);
+  maxdims[0] = H5S_UNLIMITED;
+  int rank = gdims.size();
+
+  if (H5Lexists(group_id, dname.c_str(), H5P_DEFAULT) > 0){
+    dset_id = H5Dopen(group_id, dname.c_str(), H5P_DEFAULT);
+    H5Dset_extent(dset_id, gdims.data());
+  }else{
+    dcpl_id = H5Pcreate(H5P_DATASET_CREATE);
+    H5Pset_chunk(dcpl_id, rank, cdims.data());
+    if (deflateLevel > 0){
+      H5Pset_shuffle(dcpl_id);
+      H5Pset_deflate(dcpl_id, deflateLevel);
+    }else if (compress){
+      H5Pset_szip(dcpl_id, H5_SZIP_NN_OPTION_MASK, 32);
+    }
+    filespace = H5Screate_simple(rank, gdims.data(), maxdims.data());
+    dset_id = H5Dcreate(group_id, dname.c_str(), dtype_id, filespace, H5P_DEFAULT, dcpl_id, H5P_DEFAULT);
+    H5Sclose(filespace);
+    H5Pclose(dcpl_id);
+  }
+
+  filespace = H5Dget_space(dset_id);
+  H5Sselect_hyperslab(filespace, H5S_SELECT_SET, offset.data(), NULL, ldims.data(), NULL);
+  memspace = H5Screate_simple(rank, ldims.data(), NULL);
+
+  plist_id = transferList();
+
+  H5Dwrite(dset_id, dtype_id, memspace, filespace, plist_id, data);
+
+  H5Pclose(plist_id);
+  H5Sclose(memspace);
+  H5Sclose(filespace);
+  H5Dclose(dset_id);
+}
+
+// Write one value per entry, such as the time of each output.  Collective,
+// with the value taken from the rank passing root=true.
+template<typename T>
+template<typename S>
+void h5Writer<T>::writeEntryValue(std::string dname, size_t index, S value, bool root){
+  hid_t filespace, memspace, dset_id, plist_id, dtype_id, dcpl_id;
+
+  if (std::is_same<S,FSCAL>::value) dtype_id = H5T_NATIVE_DOUBLE;
+  if (std::is_same<S,float>::value) dtype_id = H5T_NATIVE_FLOAT;
+  if (std::is_same<S,int>::value) dtype_id = H5T_NATIVE_INT;
+
+  hsize_t dims[1] = {index+1};
+  hsize_t maxdims[1] = {H5S_UNLIMITED};
+  hsize_t cdims[1] = {256};
+  hsize_t start[1] = {index};
+  hsize_t count[1] = {1};
+
+  if (H5Lexists(group_id, dname.c_str(), H5P_DEFAULT) > 0){
+    dset_id = H5Dopen(group_id, dname.c_str(), H5P_DEFAULT);
+    H5Dset_extent(dset_id, dims);
+  }else{
+    dcpl_id = H5Pcreate(H5P_DATASET_CREATE);
+    H5Pset_chunk(dcpl_id, 1, cdims);
+    filespace = H5Screate_simple(1, dims, maxdims);
+    dset_id = H5Dcreate(group_id, dname.c_str(), dtype_id, filespace, H5P_DEFAULT, dcpl_id, H5P_DEFAULT);
+    H5Sclose(filespace);
+    H5Pclose(dcpl_id);
+  }
+
+  filespace = H5Dget_space(dset_id);
+  memspace = H5Screate_simple(1, count, NULL);
+  if (root){
+    H5Sselect_hyperslab(filespace, H5S_SELECT_SET, start, NULL, count, NULL);
+  }else{
+    H5Sselect_none(filespace);
+    H5Sselect_none(memspace);
+  }
+
+  plist_id = transferList();
+
+  H5Dwrite(dset_id, dtype_id, memspace, filespace, plist_id, &value);
+
+  H5Pclose(plist_id);
+  H5Sclose(memspace);
+  H5Sclose(filespace);
+  H5Dclose(dset_id);
+}
+
+template<typename T>
+template<typename S>
+std::vector<S> h5Writer<T>::readEntryValues(std::string dname){
+  hid_t filespace, dset_id, dtype_id;
+
+  if (std::is_same<S,FSCAL>::value) dtype_id = H5T_NATIVE_DOUBLE;
+  if (std::is_same<S,float>::value) dtype_id = H5T_NATIVE_FLOAT;
+  if (std::is_same<S,int>::value) dtype_id = H5T_NATIVE_INT;
+
+  dset_id = H5Dopen(file_id, dname.c_str(), H5P_DEFAULT);
+  filespace = H5Dget_space(dset_id);
+  std::vector<S> values(H5Sget_simple_extent_npoints(filespace));
+  if (!values.empty())
+    H5Dread(dset_id, dtype_id, H5S_ALL, H5S_ALL, H5P_DEFAULT, values.data());
+  H5Sclose(filespace);
+  H5Dclose(dset_id);
+
+  return values;
+}
+
 template <typename T>
 void h5Writer<T>::checkDataDimensions(hid_t filespace, int ndim, std::vector<hsize_t> dims){
   int rank;
@@ -347,6 +880,16 @@ template void h5Writer<double>::writeAttribute<int>(std::string,int);
 template void h5Writer<double>::writeAttribute<FSCAL>(std::string,FSCAL);
 //template void h5Writer<FSCAL>::writeAttribute<std::string>(std::string,std::string);
 
+template void h5Writer<float>::writeEntryValue<int>(std::string,size_t,int,bool);
+template void h5Writer<float>::writeEntryValue<FSCAL>(std::string,size_t,FSCAL,bool);
+template void h5Writer<double>::writeEntryValue<int>(std::string,size_t,int,bool);
+template void h5Writer<double>::writeEntryValue<FSCAL>(std::string,size_t,FSCAL,bool);
+
+template std::vector<int> h5Writer<float>::readEntryValues<int>(std::string);
+template std::vector<FSCAL> h5Writer<float>::readEntryValues<FSCAL>(std::string);
+template std::vector<int> h5Writer<double>::readEntryValues<int>(std::string);
+template std::vector<FSCAL> h5Writer<double>::readEntryValues<FSCAL>(std::string);
+
 template void h5Writer<float>::readAttribute<int>(std::string,int&);
 template void h5Writer<float>::readAttribute<FSCAL>(std::string,FSCAL&);
 //template void h5Writer<float>::readAttribute<std::string>(std::string,std::string&);
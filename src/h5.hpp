@@ -18,12 +18,29 @@
 */
 
 #include <string>
+#include <utility>
 #include <vector>
 #include "hdf5.h"
 #ifdef HAVE_MPI
 #include "mpi.h"
 #endif
 
+// File system tuning applied to every file opened by h5Writer.  It is set
+// once from the fiesta.hdf5 table.
+struct h5Tuning {
+  hsize_t alignment = 0;            // align objects to this many bytes, 0 to disable
+  hsize_t alignThreshold = 65536;   // smallest object that is aligned
+  bool collectiveMetadata = false;  // collective metadata reads and writes
+  size_t metadataCache = 0;         // initial metadata cache size in bytes, 0 for the default
+  bool collectiveTransfer = true;   // collective or independent dataset transfers
+  std::vector<size_t> chunk;        // chunk shape in cells, empty to chunk by the local block
+  std::vector<std::pair<std::string,std::string>> hints;  // MPI-IO hints
+
+  std::string summary();
+};
+
+h5Tuning& h5Settings();
+
 template<typename T>
 class h5Writer {
 
@@ -34,24 +51,64 @@ class h5Writer {
 #else
     void open(std::string fname);
 #endif
+#ifdef HAVE_MPI
+    void openRead(MPI_Comm comm, MPI_Info info, std::string fname);
+    void openAppend(MPI_Comm comm, MPI_Info info, std::string fname);
+#else
     void openRead(std::string fname);
+    void openAppend(std::string fname);
+#endif
 
     void close();
 
-    void write(std::string, int, std::vector<size_t>, std::vector<size_t>, std::vector<size_t>, std::vector<T>&, bool, bool);
+    // shuffle and deflate datasets created from now on, 0 to disable
+    void deflate(int level);
+
+    void write(std::string, int, std::vector<size_t>, std::vector<size_t>, std::vector<size_t>, T*, bool, bool);
+    void writeFields(std::string, int, size_t, std::vector<size_t>, std::vector<size_t>, std::vector<size_t>, T*, bool, bool);
 
     template<typename S>
     void writeAttribute(std::string, S data);
 
     void read(std::string path, int ndim, std::vector<size_t>, std::vector<size_t>, std::vector<size_t>, T*);
+    void readFields(std::vector<std::string> paths, int ndim, std::vector<size_t>, std::vector<size_t>, std::vector<size_t>, T*);
 
     template<typename S>
     void readAttribute(std::string, S& data);
+    bool hasAttribute(std::string);
 
     void openGroup(std::string name);
     void closeGroup();
 
+    // two dimensional datasets that grow by rows
+    void createSeries(std::string path, size_t cols, size_t chunkRows);
+    void appendSeries(std::string path, size_t rows, size_t colOffset, size_t cols, T* data);
+    std::vector<size_t> seriesDims(std::string path);
+    bool hasDataset(std::string path);
+
+    // datasets whose slowest dimension is the output entry of a time series
+    void writeEntry(std::string, size_t, int, std::vector<size_t>, std::vector<size_t>, std::vector<size_t>, T*, bool, bool);
+    void writeEntryFields(std::string, size_t, int, size_t, std::vector<size_t>, std::vector<size_t>, std::vector<size_t>, T*, bool, bool);
+
+    template<typename S>
+    void writeEntryValue(std::string, size_t, S, bool);
+    template<typename S>
+    std::vector<S> readEntryValues(std::string);
+    void readSeries(std::string path, T* data);
+    void resizeSeries(std::string path, size_t rows);
+
   private:
+#ifdef HAVE_MPI
+    hid_t accessList(MPI_Comm, MPI_Info);
+#else
+    hid_t accessList();
+#endif
+    hid_t transferList();
+    std::vector<hsize_t> chunkDims(std::vector<hsize_t>, std::vector<hsize_t>);
+    std::vector<hsize_t> boundedChunk(std::vector<hsize_t>);
+
+    void writeDataset(std::string, std::vector<hsize_t>, std::vector<hsize_t>, std::vector<hsize_t>, std::vector<hsize_t>, T*, bool, bool);
+    void writeEntryDataset(std::string, size_t, std::vector<hsize_t>, std::vector<hsize_t>, std::vector<hsize_t>, std::vector<hsize_t>, T*, bool, bool);
     void checkDataDimensions(hid_t, int ndim, std::vector<hsize_t>);
     std::string filename;
 #ifdef HAVE_MPI
@@ -59,4 +116,5 @@ class h5Writer {
 #endif
     hid_t file_id;
     hid_t group_id;
+    int deflateLevel = 0;
 };
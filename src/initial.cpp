@@ -0,0 +1,349 @@
+/*
+  Copyright 2019-2021 The University of New Mexico
+
+  This file is part of FIESTA.
+  
+  FIESTA is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+  
+  FIESTA is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+  
+  You should have received a copy of the GNU Lesser General Public License
+  along with FIESTA.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "initial.hpp"
+#include "log2.hpp"
+#include <cmath>
+
+// Region geometry and states in the form used by the kernels
+struct icModel {
+  FS2D states;
+  FS2D geometry;
+  FS2D_I shapes;
+  FS2D modes;
+  int nregions;
+  int ndim;
+  int ns;
+
+  // signed distance from the edge of region r, negative inside
+  KOKKOS_INLINE_FUNCTION
+  FSCAL distance(const int r, const FSCAL x[3]) const {
+    int shape = shapes(r,0);
+
+    if (shape == icSphere){
+      FSCAL rr = 0.0;
+      for (int d=0; d<ndim; ++d)
+        rr += (x[d]-geometry(r,d))*(x[d]-geometry(r,d));
+      return sqrt(rr) - geometry(r,6);
+    }
+
+    if (shape == icBox){
+      FSCAL outside = 0.0;
+      FSCAL inside = -1.0e300;
+      for (int d=0; d<ndim; ++d){
+        FSCAL q = fabs(x[d]-0.5*(geometry(r,d)+geometry(r,3+d))) - 0.5*(geometry(r,3+d)-geometry(r,d));
+        if (q > 0.0) outside += q*q;
+        if (q > inside) inside = q;
+      }
+      return sqrt(outside) + (inside < 0.0 ? inside : 0.0);
+    }
+
+    // half space on the side the normal points to, with its plane displaced
+    // along the normal by the interface modes
+    FSCAL h = 0.0;
+    for (int d=0; d<ndim; ++d)
+      h += geometry(r,3+d)*(x[d]-geometry(r,d));
+
+    FSCAL disp = 0.0;
+    for (int m=shapes(r,1); m<shapes(r,1)+shapes(r,2); ++m){
+      if (modes(m,0) > 0.0){
+        FSCAL rn = 0.0;
+        for (int d=0; d<ndim; ++d)
+          rn += (x[d]-modes(m,2+d))*geometry(r,3+d);
+        FSCAL rr = 0.0;
+        for (int d=0; d<ndim; ++d){
+          FSCAL rt = x[d]-modes(m,2+d)-rn*geometry(r,3+d);
+          rr += rt*rt;
+        }
+        disp += modes(m,1)*exp(-rr/(modes(m,5)*modes(m,5)));
+      }else{
+        FSCAL phase = modes(m,5);
+        for (int d=0; d<ndim; ++d)
+          phase += modes(m,2+d)*x[d];
+        disp += modes(m,1)*cos(phase);
+      }
+    }
+    return disp - h;
+  }
+
+  // weight of region r over the regions before it
+  KOKKOS_INLINE_FUNCTION
+  FSCAL weight(const int r, const FSCAL x[3]) const {
+    FSCAL d = distance(r,x);
+    FSCAL w = geometry(r,7);
+    if (w > 0.0)
+      return 0.5*(1.0 - tanh(d/w));
+    return (d < 0.0) ? 1.0 : 0.0;
+  }
+
+  // composed total density
+  KOKKOS_INLINE_FUNCTION
+  FSCAL density(const FSCAL x[3]) const {
+    FSCAL rho = 0.0;
+    for (int s=0; s<ns; ++s)
+      rho += states(0,ndim+1+s);
+    for (int r=0; r<nregions; ++r){
+      FSCAL w = weight(r,x);
+      if (w > 0.0){
+        FSCAL rhor = 0.0;
+        for (int s=0; s<ns; ++s)
+          rhor += states(r+1,ndim+1+s);
+        rho = (1.0-w)*rho + w*rhor;
+      }
+    }
+    return rho;
+  }
+};
+
+// Compose the primitive state of each cell in var: velocity, pressure and
+// species densities
+struct icCompose {
+  FS4D var;
+  FS4D grid;
+  icModel model;
+  int nv, ng, ngk, nz;
+  bool cartesian;
+  FSCAL dx, dy, dz;
+  int iStart, jStart, kStart;
+
+  icCompose(FS4D var_, FS4D grid_, icModel model_, int nv_, int ng_, int ngk_, bool cartesian_,
+            FSCAL dx_, FSCAL dy_, FSCAL dz_, int iStart_, int jStart_, int kStart_)
+    : var(var_), grid(grid_), model(model_), nv(nv_), ng(ng_), ngk(ngk_), cartesian(cartesian_),
+      dx(dx_), dy(dy_), dz(dz_), iStart(iStart_), jStart(jStart_), kStart(kStart_) {
+    nz = (model.ndim == 3) ? 2 : 1;
+  }
+
+  KOKKOS_INLINE_FUNCTION
+  void operator()(const int i, const int j, const int k) const {
+    FSCAL x[3] = {0.0, 0.0, 0.0};
+
+    if (cartesian){
+      x[0] = dx*(i+iStart) + 0.5*dx;
+      x[1] = dy*(j+jStart) + 0.5*dy;
+      if (model.ndim == 3)
+        x[2] = dz*(k+kStart) + 0.5*dz;
+    }else{
+      // average cell nodes to compute cell center coordinate for non-uniform grids
+      for (int ix=0; ix<2; ++ix)
+        for (int iy=0; iy<2; ++iy)
+          for (int iz=0; iz<nz; ++iz)
+            for (int d=0; d<model.ndim; ++d)
+              x[d] += grid(i+ix,j+iy,k+iz,d);
+      for (int d=0; d<model.ndim; ++d)
+        x[d] /= 2*2*nz;
+    }
+
+    for (int v=0; v<nv; ++v)
+      var(i+ng,j+ng,k+ngk,v) = model.states(0,v);
+
+    for (int r=0; r<model.nregions; ++r){
+      FSCAL w = model.weight(r,x);
+      if (w > 0.0)
+        for (int v=0; v<nv; ++v)
+          var(i+ng,j+ng,k+ngk,v) = (1.0-w)*var(i+ng,j+ng,k+ngk,v) + w*model.states(r+1,v);
+    }
+  }
+};
+
+// Integrate the pressure of each column of cells down from the top of the
+// domain, with the trapezoid rule between cell centers.  Every rank integrates
+// its columns from the top of the global domain, so no communication is needed.
+struct icHydrostatic {
+  FS4D var;
+  icModel model;
+  int ng, ngk;
+  FSCAL dx, dy, dz;
+  int iStart, jStart, kStart, ncj, glbl_ncj;
+  FSCAL p0, g;
+
+  icHydrostatic(FS4D var_, icModel model_, int ng_, int ngk_, FSCAL dx_, FSCAL dy_, FSCAL dz_,
+                int iStart_, int jStart_, int kStart_, int ncj_, int glbl_ncj_, FSCAL p0_, FSCAL g_)
+    : var(var_), model(model_), ng(ng_), ngk(ngk_), dx(dx_), dy(dy_), dz(dz_), iStart(iStart_), jStart(jStart_),
+      kStart(kStart_), ncj(ncj_), glbl_ncj(glbl_ncj_), p0(p0_), g(g_) {}
+
+  KOKKOS_INLINE_FUNCTION
+  void operator()(const int i, const int k) const {
+    FSCAL x[3] = {dx*(i+iStart) + 0.5*dx, dy*(glbl_ncj-0.5), 0.0};
+    if (model.ndim == 3)
+      x[2] = dz*(k+kStart) + 0.5*dz;
+
+    FSCAL rho = model.density(x);
+    FSCAL p = p0 + g*rho*0.5*dy;
+
+    for (int jg=glbl_ncj-1; jg>=jStart; --jg){
+      if (jg < glbl_ncj-1){
+        x[1] = dy*jg + 0.5*dy;
+        FSCAL rhoNext = model.density(x);
+        p += g*0.5*(rho+rhoNext)*dy;
+        rho = rhoNext;
+      }
+      if (jg < jStart+ncj)
+        var(i+ng,jg-jStart+ng,k+ngk,model.ndim) = p;
+    }
+  }
+};
+
+// Convert the primitive state in var to momentum and total energy
+struct icConserved {
+  FS4D var;
+  FS1D species;
+  int ndim, ns, ng, ngk;
+
+  icConserved(FS4D var_, FS1D species_, int ndim_, int ns_, int ng_, int ngk_)
+    : var(var_), species(species_), ndim(ndim_), ns(ns_), ng(ng_), ngk(ngk_) {}
+
+  KOKKOS_INLINE_FUNCTION
+  void operator()(const int i, const int j, const int k) const {
+    FSCAL rho = 0.0;
+    for (int s=0; s<ns; ++s)
+      rho += var(i+ng,j+ng,k+ngk,ndim+1+s);
+
+    // mixture ratio of specific heats by mass fraction weights
+    FSCAL Cp = 0.0;
+    FSCAL Cv = 0.0;
+    for (int s=0; s<ns; ++s){
+      FSCAL gammas = species(2*s);
+      FSCAL Rs = species(2*s+1);
+      Cp += (var(i+ng,j+ng,k+ngk,ndim+1+s)/rho)*(gammas*Rs/(gammas-1));
+      Cv += (var(i+ng,j+ng,k+ngk,ndim+1+s)/rho)*(Rs/(gammas-1));
+    }
+    FSCAL gamma = Cp/Cv;
+
+    FSCAL ke = 0.0;
+    for (int d=0; d<ndim; ++d){
+      FSCAL u = var(i+ng,j+ng,k+ngk,d);
+      ke += 0.5*rho*u*u;
+      var(i+ng,j+ng,k+ngk,d) = rho*u;
+    }
+    var(i+ng,j+ng,k+ngk,ndim) = var(i+ng,j+ng,k+ngk,ndim)/(gamma-1) + ke;
+  }
+};
+
+initialConditions::initialConditions(struct inputConfig& cf, icState background, std::vector<icRegion> regions,
+                                     bool hydrostatic_, FSCAL topPressure_, FSCAL accel_)
+  : nregions(regions.size()), hydrostatic(hydrostatic_), topPressure(topPressure_), accel(accel_) {
+
+  if (hydrostatic && cf.grid != 0){
+    Log::error("Hydrostatic initial conditions require a cartesian grid.");
+    exit(EXIT_FAILURE);
+  }
+
+  size_t nmodes = 0;
+  for (auto const& r : regions)
+    nmodes += r.modes.size();
+
+  states = FS2D("icStates", nregions+1, cf.nv);
+  geometry = FS2D("icGeometry", std::max(nregions,1), 8);
+  shapes = FS2D_I("icShapes", std::max(nregions,1), 3);
+  modes = FS2D("icModes", std::max(nmodes,(size_t)1), 6);
+  species = FS1D("icSpecies", 2*cf.ns);
+
+  auto statesH = Kokkos::create_mirror_view(states);
+  auto geometryH = Kokkos::create_mirror_view(geometry);
+  auto shapesH = Kokkos::create_mirror_view(shapes);
+  auto modesH = Kokkos::create_mirror_view(modes);
+  auto speciesH = Kokkos::create_mirror_view(species);
+
+  for (int s=0; s<cf.ns; ++s){
+    speciesH(2*s) = cf.gamma[s];
+    speciesH(2*s+1) = cf.R/cf.M[s];
+  }
+
+  // store each state in var order, with temperatures converted to pressures
+  auto setState = [&](int n, icState& st){
+    FSCAL rhoR = 0.0;
+    for (int s=0; s<cf.ns; ++s){
+      statesH(n,cf.ndim+1+s) = st.density[s];
+      rhoR += st.density[s]*cf.R/cf.M[s];
+    }
+    for (int d=0; d<cf.ndim; ++d)
+      statesH(n,d) = st.velocity[d];
+    statesH(n,cf.ndim) = st.hasTemperature ? rhoR*st.temperature : st.pressure;
+  };
+
+  setState(0,background);
+
+  size_t m = 0;
+  for (int r=0; r<nregions; ++r){
+    icRegion& reg = regions[r];
+    setState(r+1,reg.state);
+
+    if (reg.shape == icHalfspace){
+      FSCAL norm = 0.0;
+      for (int d=0; d<cf.ndim; ++d)
+        norm += reg.b[d]*reg.b[d];
+      norm = sqrt(norm);
+      if (norm == 0.0){
+        Log::error("Initial condition region {} needs a nonzero normal.",r+1);
+        exit(EXIT_FAILURE);
+      }
+      for (int d=0; d<cf.ndim; ++d)
+        reg.b[d] /= norm;
+    }
+
+    for (int d=0; d<3; ++d){
+      geometryH(r,d) = reg.a[d];
+      geometryH(r,3+d) = reg.b[d];
+    }
+    geometryH(r,6) = reg.radius;
+    geometryH(r,7) = reg.width;
+
+    shapesH(r,0) = reg.shape;
+    shapesH(r,1) = m;
+    shapesH(r,2) = reg.modes.size();
+    for (auto const& mode : reg.modes){
+      modesH(m,0) = mode.gaussian ? 1.0 : 0.0;
+      modesH(m,1) = mode.amplitude;
+      for (int d=0; d<3; ++d)
+        modesH(m,2+d) = mode.v[d];
+      modesH(m,5) = mode.s;
+      ++m;
+    }
+  }
+
+  Kokkos::deep_copy(states,statesH);
+  Kokkos::deep_copy(geometry,geometryH);
+  Kokkos::deep_copy(shapes,shapesH);
+  Kokkos::deep_copy(modes,modesH);
+  Kokkos::deep_copy(species,speciesH);
+}
+
+void initialConditions::apply(struct inputConfig& cf, FS4D& var, FS4D& grid){
+  icModel model = {states, geometry, shapes, modes, nregions, cf.ndim, cf.ns};
+
+  int nck = (cf.ndim == 3) ? cf.nck : 1;
+  int ngk = (cf.ndim == 3) ? cf.ng : 0;
+  int iStart = cf.subdomainOffset[0];
+  int jStart = cf.subdomainOffset[1];
+  int kStart = (cf.ndim == 3) ? cf.subdomainOffset[2] : 0;
+
+  policy_f3 cells = policy_f3({0,0,0},{cf.nci,cf.ncj,nck});
+
+  Kokkos::parallel_for(cells, icCompose(var, grid, model, cf.nv, cf.ng, ngk, cf.grid == 0,
+                                        cf.dx, cf.dy, cf.dz, iStart, jStart, kStart));
+
+  if (hydrostatic){
+    policy_f columns = policy_f({0,0},{cf.nci,nck});
+    Kokkos::parallel_for(columns, icHydrostatic(var, model, cf.ng, ngk, cf.dx, cf.dy, cf.dz,
+                                                iStart, jStart, kStart, cf.ncj, cf.glbl_ncj, topPressure, accel));
+  }
+
+  Kokkos::parallel_for(cells, icConserved(var, species, cf.ndim, cf.ns, cf.ng, ngk));
+  Kokkos::fence();
+}
@@ -0,0 +1,83 @@
+/*
+  Copyright 2019-2021 The University of New Mexico
+
+  This file is part of FIESTA.
+  
+  FIESTA is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+  
+  FIESTA is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+  
+  You should have received a copy of the GNU Lesser General Public License
+  along with FIESTA.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef INITIAL_H
+#define INITIAL_H
+
+#include "kokkosTypes.hpp"
+#include "input.hpp"
+#include <array>
+#include <vector>
+
+// primitive state of a region, species densities, velocity, and a pressure or
+// a temperature
+struct icState {
+  std::vector<FSCAL> density;
+  std::array<FSCAL,3> velocity = {0.0, 0.0, 0.0};
+  FSCAL pressure = 0.0;
+  FSCAL temperature = 0.0;
+  bool hasTemperature = false;
+};
+
+// displacement of a planar interface, a cosine with a wavevector and phase or
+// a gaussian bump with a center and width
+struct icMode {
+  bool gaussian = false;
+  FSCAL amplitude = 0.0;
+  std::array<FSCAL,3> v = {0.0, 0.0, 0.0};
+  FSCAL s = 0.0;
+};
+
+enum icShape { icSphere, icBox, icHalfspace };
+
+// a region painted over the regions before it, blended across its edge
+struct icRegion {
+  icShape shape = icSphere;
+  std::array<FSCAL,3> a = {0.0, 0.0, 0.0};  // center, lower corner or origin
+  std::array<FSCAL,3> b = {0.0, 0.0, 0.0};  // upper corner or normal
+  FSCAL radius = 0.0;
+  FSCAL width = 0.0;                         // blending width, 0 for a sharp edge
+  std::vector<icMode> modes;
+  icState state;
+};
+
+// Initial conditions built from a background state and a list of regions, and
+// evaluated on the device.  Regions are composed in order, each blended over
+// the ones before it with a tanh profile across its edge.  The pressure can
+// instead be integrated down from the top of the domain to hydrostatic
+// balance with the composed density.
+class initialConditions {
+  public:
+    initialConditions(struct inputConfig&, icState, std::vector<icRegion>, bool, FSCAL, FSCAL);
+    void apply(struct inputConfig&, FS4D&, FS4D&);
+
+  private:
+    int nregions;
+    bool hydrostatic;
+    FSCAL topPressure;   // pressure at the top of the domain
+    FSCAL accel;         // gravitational acceleration in -y
+
+    FS2D states;         // primitive state of the background and each region, in var order
+    FS2D geometry;       // region center, corners or plane, radius and width
+    FS2D_I shapes;       // region shape, first mode and number of modes
+    FS2D modes;          // interface modes
+    FS1D species;        // gamma and gas constant of each species
+};
+
+#endif
@@ -32,7 +32,19 @@
 #include "unistd.h"
 #include "log2.hpp"
 #include "bc.hpp"
+#include "h5.hpp"
+#include "initial.hpp"
+#include "expression.hpp"
+#include "terrain.hpp"
+#include "rectilinear.hpp"
+#include "fiesta.hpp"
 #include <filesystem>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <fstream>
+#include <set>
 
 struct commandArgs getCommandlineOptions(int argc, char **argv){
   // create command argumet structure
@@ -47,12 +59,16 @@ struct commandArgs getCommandlineOptions(int argc, char **argv){
   cArgs.numThreads = 1;
   cArgs.verbosity = 3;
   cArgs.diagnostics = false;
+  cArgs.dryRun = false;
+  cArgs.memory = false;
 
   // create options
   static struct option long_options[] = {
       {"version", no_argument, NULL, 'V'},
       {"verbosity", optional_argument, NULL, 'v'},
       {"diagnostics", optional_argument, NULL, 'd'},
+      {"dry-run", no_argument, NULL, 'D'},
+      {"memory", no_argument, NULL, 'M'},
       {"color", optional_argument, NULL, 'c'},
       {"gpus-per-node", optional_argument, NULL, 'n'},
       {"num-threads", optional_argument, NULL, 'n'},
@@ -93,6 +109,12 @@ struct commandArgs getCommandlineOptions(int argc, char **argv){
     case 'd':
       cArgs.diagnostics = true;
       break;
+    case 'D':
+      cArgs.dryRun = true;
+      break;
+    case 'M':
+      cArgs.memory = true;
+      break;
     }
   }
 
@@ -132,6 +154,8 @@ void executeConfiguration(struct inputConfig &cf, struct commandArgs cargs){
   cf.timeFormat = cargs.timeFormat;
   cf.verbosity = cargs.verbosity;
   cf.diagnostics = cargs.diagnostics;
+  cf.dryRun = cargs.dryRun;
+  cf.memoryReport = cargs.memory || cargs.dryRun;
 
   luaReader L(cargs.fileName,"fiesta");
 
@@ -173,6 +197,17 @@ void executeConfiguration(struct inputConfig &cf, struct commandArgs cargs){
   L.get({"write_frequency"},   cf.write_freq,  0);
   //L.get({"restart_frequency"}, cf.restart_freq,0);
   L.get({"status","frequency"},    cf.stat_freq,   0);
+  L.get({"status","timers"},       cf.statTimers,  false);
+  L.get({"timers","file"},         cf.timerFile,   std::string("timers"));
+
+  L.get({"trace","steps"},  cf.traceSteps, 0);
+  L.get({"trace","start"},  cf.traceStart, -1);
+  L.get({"trace","events"}, cf.traceEvents, 65536);
+  L.get({"trace","name"},   cf.traceName, std::string("trace"));
+  if (cf.traceSteps > 0 && cf.traceEvents < 1){
+    Log::error("fiesta.trace.events must be positive.");
+    exit(EXIT_FAILURE);
+  }
 
   L.get({"terrain","name"}, cf.terrainName, std::string("terrain.h5"));
 
@@ -197,22 +232,83 @@ void executeConfiguration(struct inputConfig &cf, struct commandArgs cargs){
     L.get({"restart","frequency"}, cf.restart_freq,0);
   }
 
+  L.get({"checkpoint","frequency"}, cf.checkpoint_freq, 0);
+  L.get({"checkpoint","path"}, cf.checkpointPath, std::string("/tmp/fiesta"));
+  L.get({"checkpoint","keep"}, cf.checkpointKeep, 2);
+  L.get({"checkpoint","drain"}, cf.checkpointDrain, 1);
+  L.get({"checkpoint","partner"}, cf.checkpointPartner, false);
+
   std::string scheme, grid, mpi;
   L.get({"mpi","type"}, mpi, std::string("host"));
   L.get({"hdf5","chunk"}, cf.chunkable, false);
   L.get({"hdf5","compress"}, cf.compressible, false);
+  L.get({"hdf5","async"}, cf.asyncIO, false);
+  L.get({"hdf5","layout"}, cf.h5Layout, std::string("fields"));
+
+  if (cf.h5Layout != "fields" && cf.h5Layout != "combined"){
+    Log::error("Unknown HDF5 layout '{}'.  Expected 'fields' or 'combined'.",cf.h5Layout);
+    exit(EXIT_FAILURE);
+  }
+
+  // file system tuning
+  h5Tuning& h5t = h5Settings();
+  int alignment, alignThreshold, metadataCache;
+  std::string transfer;
+  L.get({"hdf5","alignment"}, alignment, 0);
+  L.get({"hdf5","alignment_threshold"}, alignThreshold, 65536);
+  L.get({"hdf5","collective_metadata"}, h5t.collectiveMetadata, false);
+  L.get({"hdf5","metadata_cache"}, metadataCache, 0);
+  L.get({"hdf5","transfer"}, transfer, std::string("collective"));
+  L.get({"hdf5","chunk_shape"}, h5t.chunk, cf.ndim, std::vector<size_t>());
+  h5t.alignment = std::max(alignment,0);
+  h5t.alignThreshold = std::max(alignThreshold,0);
+  h5t.metadataCache = std::max(metadataCache,0);
+
+  if (transfer != "collective" && transfer != "independent"){
+    Log::error("Unknown HDF5 transfer '{}'.  Expected 'collective' or 'independent'.",transfer);
+    exit(EXIT_FAILURE);
+  }
+  h5t.collectiveTransfer = (transfer == "collective");
+
+  for (auto c : h5t.chunk){
+    if (c < 1){
+      Log::error("HDF5 chunk_shape must be positive.");
+      exit(EXIT_FAILURE);
+    }
+  }
+  if (!h5t.chunk.empty()) cf.chunkable = true;
+
+  // MPI-IO hints
+  for (auto hint : {"cb_nodes","cb_buffer_size","striping_factor","striping_unit"}){
+    int value;
+    L.get({"hdf5",hint}, value, 0);
+    if (value > 0)
+      h5t.hints.push_back({hint,std::to_string(value)});
+  }
 
   if (!cf.chunkable && cf.compressible){
     cf.compressible = false;
     Log::warning("HDF5 Compression requires chunking.  Disabling.");
   }
 
+  L.get({"initialization","threads"}, cf.initThreads, 0);
+  L.get({"initialization","tile"}, cf.initTile, 4096);
+  if (cf.initTile < 1){
+    Log::error("initialization.tile must be positive.");
+    exit(EXIT_FAILURE);
+  }
+  L.get({"initialization","cache"}, cf.initCache, false);
+  cf.initCacheHit = false;
+
   L.get({"advection_scheme"}, scheme, std::string("weno5"));
   L.get({"grid","type"},   grid, std::string("cartesian"));
 
   //vector<FSCAL> dx;
   //L.getArray("dx",dx,cf.ndim);
-  L.get({"grid","dx"},cf.dxvec,cf.ndim);
+  if (grid.compare("rectilinear") == 0)
+    L.get({"grid","dx"},cf.dxvec,cf.ndim,vector<FSCAL>(cf.ndim,1.0));
+  else
+    L.get({"grid","dx"},cf.dxvec,cf.ndim);
 
   vector<size_t> ni;
   //L.getArray("ni",ni,cf.ndim);
@@ -265,10 +361,26 @@ void executeConfiguration(struct inputConfig &cf, struct commandArgs cargs){
     L.get({"ceq","beta"},cf.beta);
     L.get({"ceq","betae"},cf.betae);
     L.get({"ceq","st"},cf.st,0);
+    L.get({"ceq","lagged"},cf.ceqLagged,false);
+  }
+
+  L.get({"rollback","frequency"},cf.rollback_freq,0);
+  L.get({"rollback","snapshot_frequency"},cf.snapshot_freq,10*cf.rollback_freq);
+  L.get({"rollback","snapshots"},cf.snapshots,2);
+  L.get({"rollback","max"},cf.maxRollbacks,10);
+  L.get({"rollback","dt_factor"},cf.rollbackDtFactor,1.0);
+  L.get({"rollback","noise"},cf.rollbackNoise,false);
+  if (cf.rollback_freq > 0 && (cf.snapshot_freq <= 0 || cf.snapshots < 1)){
+    Log::error("Rollback requires a positive snapshot frequency and at least one snapshot.");
+    exit(EXIT_FAILURE);
+  }
+  if (cf.rollbackNoise && cf.ndim == 3 && grid.compare("cartesian") != 0 && grid.compare("rectilinear") != 0){
+    Log::warning("Noise filter is not available on 3D generalized grids.  Rollback will not enable it.");
+    cf.rollbackNoise = false;
   }
 
   L.get({"noise","enabled"},cf.noise,false);
-  if(cf.noise){
+  if(cf.noise || cf.rollbackNoise){
     L.get({"noise","dh"},cf.n_dh);
     L.get({"noise","eta"},cf.n_eta);
     L.get({"noise","coff"},cf.n_coff);
@@ -291,7 +403,41 @@ void executeConfiguration(struct inputConfig &cf, struct commandArgs cargs){
     if (cf.ndim == 3)
       cf.dz=cf.dxvec[2];
   }
-  if (grid.compare("terrain") == 0) {
+  if (grid.compare("rectilinear") == 0) {
+    if (cf.ndim != 3){
+      Log::error("Rectilinear grids require ndim=3.");
+      exit(EXIT_FAILURE);
+    }
+    cf.grid = 3;
+
+    // node coordinates along each axis, uniform with spacing grid.dx where
+    // no list is given.  The smallest width is used as the cell size.
+    std::string axes[3] = {"x","y","z"};
+    size_t nc[3] = {(size_t)cf.glbl_nci, (size_t)cf.glbl_ncj, (size_t)cf.glbl_nck};
+    FSCAL *h[3] = {&cf.dx, &cf.dy, &cf.dz};
+    cf.axisNodes.resize(3);
+    for (int a=0; a<3; ++a){
+      vector<FSCAL> nodes = L.getNumberList({"grid",axes[a]});
+      if (nodes.empty()){
+        for (size_t n=0; n<=nc[a]; ++n)
+          nodes.push_back(cf.dxvec[a]*n);
+      }else if (nodes.size() != nc[a]+1){
+        Log::error("grid.{} needs {} node coordinates, found {}.",axes[a],nc[a]+1,nodes.size());
+        exit(EXIT_FAILURE);
+      }
+      *h[a] = nodes[1]-nodes[0];
+      for (size_t n=0; n<nc[a]; ++n){
+        if (nodes[n+1] <= nodes[n]){
+          Log::error("grid.{} node coordinates must be increasing.",axes[a]);
+          exit(EXIT_FAILURE);
+        }
+        *h[a] = std::min(*h[a], nodes[n+1]-nodes[n]);
+      }
+      cf.axisNodes[a] = nodes;
+    }
+  }
+  cf.terrainFollowing = (grid.compare("terrain-following") == 0);
+  if (grid.compare("terrain") == 0 || cf.terrainFollowing) {
     if (cf.ndim == 3){
       cf.grid = 2;
       cf.dx=1.0;
@@ -300,6 +446,7 @@ void executeConfiguration(struct inputConfig &cf, struct commandArgs cargs){
       L.get({"tdx"},cf.tdx);
       L.get({"tdy"},cf.tdy);
       L.get({"h"},cf.h);
+      L.get({"terrain","stretch"},cf.tstretch,0.0);
     } else {
       printf("ndim must be equal to 3 for terrain");
       exit(EXIT_FAILURE);
@@ -415,6 +562,11 @@ void executeConfiguration(struct inputConfig &cf, struct commandArgs cargs){
   // initialize signal flags to inactive
   cf.restartFlag=0;
   cf.exitFlag=0;
+#ifdef HAVE_MPI
+  cf.signalSend=0;
+  cf.signalRecv=0;
+  cf.signalReq=MPI_REQUEST_NULL;
+#endif
 
   cf.xmp = 0;
   cf.ymp = 0;
@@ -442,75 +594,165 @@ void executeConfiguration(struct inputConfig &cf, struct commandArgs cargs){
   cf.ioThisStep = false;
 }
 
+// Host threads for Lua evaluation.  By default the cores of a node are shared
+// by the ranks running on it.
+static int luaThreads(struct inputConfig& cf){
+  if (cf.initThreads > 0) return cf.initThreads;
+
+  int local = 1;
+#ifdef HAVE_MPI
+  MPI_Comm node;
+  MPI_Comm_split_type(cf.comm, MPI_COMM_TYPE_SHARED, cf.rank, MPI_INFO_NULL, &node);
+  MPI_Comm_size(node, &local);
+  MPI_Comm_free(&node);
+#endif
+  return std::max(1, (int)std::thread::hardware_concurrency()/local);
+}
+
+// Evaluate the Lua function fname at n points for nout outputs.  Points are
+// handed out in tiles to several host threads, each with its own Lua state.  If
+// the input file defines fname_batch, it is called once per tile with arrays of
+// the point coordinates and returns an array for each output.  Otherwise fname
+// is called for every point and output.
+static void evaluateLua(struct inputConfig& cf, std::string fname, size_t n, int nout,
+                        const std::function<std::array<FSCAL,3>(size_t)>& point,
+                        const std::function<void(size_t,int,FSCAL)>& store){
+  size_t tile = cf.initTile;
+  size_t ntiles = (n+tile-1)/tile;
+  int nthreads = std::max((size_t)1, std::min((size_t)luaThreads(cf), ntiles));
+  std::atomic<size_t> next(0);
+  std::atomic<bool> batched(false);
+
+  auto worker = [&](){
+    luaReader L(cf.inputFname,"fiesta");
+    bool batch = L.hasFunction(fname+"_batch");
+    batched = batch;
+    std::vector<std::vector<FSCAL>> args(3), out;
+
+    for (size_t t = next++; t < ntiles; t = next++){
+      size_t first = t*tile;
+      size_t last = std::min(first+tile, n);
+      if (batch){
+        for (auto& a : args) a.clear();
+        for (size_t p=first; p<last; ++p){
+          auto x = point(p);
+          for (int d=0; d<3; ++d) args[d].push_back(x[d]);
+        }
+        L.callBatch(fname+"_batch", args, nout, out);
+        for (int v=0; v<nout; ++v)
+          for (size_t p=first; p<last; ++p)
+            store(p, v, out[v][p-first]);
+      }else{
+        for (size_t p=first; p<last; ++p){
+          auto x = point(p);
+          for (int v=0; v<nout; ++v)
+            store(p, v, L.call(fname,4,x[0],x[1],x[2],(FSCAL)v));
+        }
+      }
+    }
+    L.close();
+  };
+
+  std::vector<std::thread> threads;
+  for (int t=1; t<nthreads; ++t)
+    threads.emplace_back(worker);
+  worker();
+  for (auto& t : threads)
+    t.join();
+
+  Log::message("Evaluated '{}' at {} points on {} threads{}",fname,n,nthreads,batched ? " in batches" : "");
+}
+
+// Compare expressions evaluated on the device with the equivalent Lua function
+static void validateExpression(class expression& ex, size_t n,
+                               const std::function<std::array<FSCAL,3>(size_t)>& point,
+                               const std::function<FSCAL(size_t,int)>& result){
+  size_t differ = ex.compare(n, point, result);
+  if (differ == 0)
+    Log::message("Validated '{}' expressions against Lua at {} points",ex.name,n);
+  else
+    Log::warning("'{}' expressions differ from Lua in {} values at {} points",ex.name,differ,n);
+}
+
 int loadInitialConditions(struct inputConfig cf, FS4D &deviceV, FS4D &deviceG) {
-  FSCAL x,y,z;
+  // declarative initial conditions are evaluated on the device
+  luaReader L(cf.inputFname,"fiesta");
+  auto ic = L.getInitialConditions(cf);
+  std::unique_ptr<class expression> ex;
+  if (!ic)
+    ex = L.getExpression("initial_conditions",{"x","y","z","v"},cf.nv);
+  L.close();
+  if (ic){
+    ic->apply(cf, deviceV, deviceG);
+    Log::message("Evaluated initial condition regions on the device");
+    return 0;
+  }
+
+  // expressions are compiled and evaluated on the device
+  if (ex){
+    ex->initialConditions(cf, deviceV, deviceG);
+    Log::message("Evaluated 'initial_conditions' expressions on the device");
+    if (!ex->validate)
+      return 0;
+  }
+
   FS4DH hostV = Kokkos::create_mirror_view(deviceV);
   FS4DH hostG = Kokkos::create_mirror_view(deviceG);
   if(cf.grid!=0){
     Kokkos::deep_copy(hostG,deviceG);
   }
 
-  luaReader L(cf.inputFname,"fiesta");
-
-  for (int v = 0; v < cf.nv; ++v) {
-    if (cf.ndim == 3) {
-      for (int k = cf.ng; k < cf.nck + cf.ng; ++k) {
-        for (int j = cf.ng; j < cf.ncj + cf.ng; ++j) {
-          for (int i = cf.ng; i < cf.nci + cf.ng; ++i) {
-            if(cf.grid==0){
-              // compute cell center coordintes for uniform grids
-              x=cf.dx*(i-cf.ng+cf.subdomainOffset[0]) + 0.5*cf.dx;
-              y=cf.dy*(j-cf.ng+cf.subdomainOffset[1]) + 0.5*cf.dy;
-              z=cf.dz*(k-cf.ng+cf.subdomainOffset[2]) + 0.5*cf.dz;
-            }else{
-              // average cell nodes to compute cell center coordinate for non-uniform grids
-              x = 0;
-              y = 0;
-              z = 0;
-              for (int ix=0; ix<2; ++ix){
-                for (int iy=0; iy<2; ++iy){
-                  for (int iz=0; iz<2; ++iz){
-                    x += hostG(i+ix-cf.ng,j+iy-cf.ng,k+iz-cf.ng,0);
-                    y += hostG(i+ix-cf.ng,j+iy-cf.ng,k+iz-cf.ng,1);
-                    z += hostG(i+ix-cf.ng,j+iy-cf.ng,k+iz-cf.ng,2);
-                  }
-                }
-              }
-              x = x/8.0;
-              y = y/8.0;
-              z = z/8.0;
-            }
-            hostV(i, j, k, v) = L.call("initial_conditions",4,x,y,z,(FSCAL)v);
-          }
-        }
-      }
-    } else {
-      for (int j = cf.ng; j < cf.ncj + cf.ng; ++j) {
-        for (int i = cf.ng; i < cf.nci + cf.ng; ++i) {
-            if(cf.grid==0){
-              // compute cell center coordintes for uniform grids
-              x=cf.dx*(i-cf.ng+cf.subdomainOffset[0]) + 0.5*cf.dx;
-              y=cf.dy*(j-cf.ng+cf.subdomainOffset[1]) + 0.5*cf.dy;
-            }else{
-              // average cell nodes to compute cell center coordinate for non-uniform grids
-              x = 0;
-              y = 0;
-              for (int ix=0; ix<2; ++ix){
-                for (int iy=0; iy<2; ++iy){
-                  x += hostG(i+ix-cf.ng,j+iy-cf.ng,0,0);
-                  y += hostG(i+ix-cf.ng,j+iy-cf.ng,0,1);
-                }
-              }
-              x = x/4.0;
-              y = y/4.0;
-            }
-            hostV(i, j, 0, v) = L.call("initial_conditions",4,x,y,0.0,(FSCAL)v);
-        }
-      }
+  int nck = (cf.ndim == 3) ? cf.nck : 1;
+  int ngk = (cf.ndim == 3) ? cf.ng : 0;
+  size_t ncells = (size_t)cf.nci*cf.ncj*nck;
+
+  // cell center coordinates of the i fastest cell index
+  auto center = [&](size_t p){
+    int i = p % cf.nci;
+    int j = (p / cf.nci) % cf.ncj;
+    int k = p / ((size_t)cf.nci*cf.ncj);
+    std::array<FSCAL,3> x = {0.0, 0.0, 0.0};
+
+    if(cf.grid==0){
+      // compute cell center coordintes for uniform grids
+      x[0]=cf.dx*(i+cf.subdomainOffset[0]) + 0.5*cf.dx;
+      x[1]=cf.dy*(j+cf.subdomainOffset[1]) + 0.5*cf.dy;
+      if (cf.ndim == 3)
+        x[2]=cf.dz*(k+cf.subdomainOffset[2]) + 0.5*cf.dz;
+    }else{
+      // average cell nodes to compute cell center coordinate for non-uniform grids
+      int nz = (cf.ndim == 3) ? 2 : 1;
+      for (int ix=0; ix<2; ++ix)
+        for (int iy=0; iy<2; ++iy)
+          for (int iz=0; iz<nz; ++iz)
+            for (int d=0; d<cf.ndim; ++d)
+              x[d] += hostG(i+ix,j+iy,k+iz,d);
+      for (int d=0; d<cf.ndim; ++d)
+        x[d] /= 2*2*nz;
     }
+    return x;
+  };
+
+  auto store = [&](size_t p, int v, FSCAL value){
+    int i = p % cf.nci;
+    int j = (p / cf.nci) % cf.ncj;
+    int k = p / ((size_t)cf.nci*cf.ncj);
+    hostV(i+cf.ng, j+cf.ng, k+ngk, v) = value;
+  };
+
+  if (ex){
+    Kokkos::deep_copy(hostV, deviceV);
+    auto result = [&](size_t p, int v){
+      int i = p % cf.nci;
+      int j = (p / cf.nci) % cf.ncj;
+      int k = p / ((size_t)cf.nci*cf.ncj);
+      return hostV(i+cf.ng, j+cf.ng, k+ngk, v);
+    };
+    validateExpression(*ex, ncells, center, result);
+    return 0;
   }
 
-  L.close();
+  evaluateLua(cf, "initial_conditions", ncells, cf.nv, center, store);
 
   Kokkos::deep_copy(deviceV, hostV);
 
@@ -530,28 +772,91 @@ int loadGrid(struct inputConfig cf, FS4D &deviceV) {
   FS4DH hostV = Kokkos::create_mirror_view(deviceV);
 
   if (cf.grid == 1) {
-
     luaReader L(cf.inputFname,"fiesta");
+    auto ex = L.getExpression("initialize_grid",{"i","j","k","v"},cf.ndim);
+    L.close();
+    if (ex){
+      ex->grid(cf, deviceV);
+      Log::message("Evaluated 'initialize_grid' expressions on the device");
+      if (!ex->validate)
+        return 0;
+    }
 
-    int ii,jj,kk;
-    for (int v = 0; v < cf.ndim; ++v) {
-      for (int k = 0; k < cf.nk; ++k) {
-        for (int j = 0; j < cf.nj; ++j) {
-          for (int i = 0; i < cf.ni; ++i) {
-            ii = cf.iStart + i;
-            jj = cf.jStart + j;
-            kk = cf.kStart + k;
-            hostV(i, j, k, v) = L.call("initialize_grid",4,(FSCAL)ii,(FSCAL)jj,(FSCAL)kk,(FSCAL)v);
-          }
-        }
-      }
+    size_t nnodes = (size_t)cf.ni*cf.nj*cf.nk;
+
+    // global node indexes of the i fastest node index
+    auto node = [&](size_t p){
+      std::array<FSCAL,3> x;
+      x[0] = cf.iStart + p % cf.ni;
+      x[1] = cf.jStart + (p / cf.ni) % cf.nj;
+      x[2] = cf.kStart + p / ((size_t)cf.ni*cf.nj);
+      return x;
+    };
+
+    auto store = [&](size_t p, int v, FSCAL value){
+      hostV(p % cf.ni, (p / cf.ni) % cf.nj, p / ((size_t)cf.ni*cf.nj), v) = value;
+    };
+
+    if (ex){
+      Kokkos::deep_copy(hostV, deviceV);
+      auto result = [&](size_t p, int v){
+        return hostV(p % cf.ni, (p / cf.ni) % cf.nj, p / ((size_t)cf.ni*cf.nj), v);
+      };
+      validateExpression(*ex, nnodes, node, result);
+      return 0;
     }
-    L.close();
+
+    evaluateLua(cf, "initialize_grid", nnodes, cf.ndim, node, store);
     Kokkos::deep_copy(deviceV, hostV);
   } else if (cf.grid == 2) {
-    cf.w->readTerrain(cf,deviceV);
+    terrainGrid(cf).nodes(cf, deviceV);
+  } else if (cf.grid == 3) {
+    rectGrid(cf).nodes(cf, deviceV);
   }
 
 
   return 0;
 }
+
+// Name of the file caching the grid and initial conditions.  It is a hash of
+// the input file globals they can depend on, the conserved variables and the
+// build, or nothing if caching is disabled.  Solver, output and decomposition
+// settings are left out, so runs that only change those share the cache.  The
+// cache holds the global fields, read back by hyperslab on any decomposition.
+std::string initialCacheName(struct inputConfig &cf, const std::vector<std::string> &varNames){
+  if (!cf.initCache)
+    return "";
+
+  std::set<std::string> skip = {
+    "fiesta.title", "fiesta.metadata", "fiesta.time", "fiesta.ioviews", "fiesta.probes", "fiesta.hdf5",
+    "fiesta.status", "fiesta.timers", "fiesta.trace", "fiesta.progress", "fiesta.restart", "fiesta.checkpoint", "fiesta.rollback",
+    "fiesta.write_frequency", "fiesta.restart_frequency", "fiesta.mpi", "fiesta.advection_scheme",
+    "fiesta.viscosity", "fiesta.ceq", "fiesta.noise", "fiesta.bc", "fiesta.initialization.threads",
+    "fiesta.initialization.tile", "fiesta.initialization.cache", "fiesta.initialization.cache_ignore"
+  };
+
+  luaReader L(cf.inputFname,"fiesta");
+  for (auto& name : L.getStringList({"initialization","cache_ignore"}))
+    skip.insert(name);
+  std::string key = L.fingerprint(skip);
+  L.close();
+
+  key += format("|{}|{}|{}|{}",FIESTA_VERSION,FIESTA_OPTIONS,FIESTA_RESTART_VERSION,sizeof(FSCAL));
+  for (auto& name : varNames)
+    key += "|" + name;
+
+  // the terrain is read from its own file
+  if (cf.grid == 2){
+    std::ifstream terrain(cf.terrainName, std::ios::binary);
+    key.append(std::istreambuf_iterator<char>(terrain), std::istreambuf_iterator<char>());
+  }
+
+  // 64 bit FNV-1a hash
+  uint64_t hash = 14695981039346656037ULL;
+  for (unsigned char c : key){
+    hash ^= c;
+    hash *= 1099511628211ULL;
+  }
+
+  return format("{}/ic-{:016x}.h5",cf.pathName,hash);
+}
@@ -32,6 +32,7 @@
 #include "mpi.h"
 #endif
 #include <string>
+#include <csignal>
 #include "timer.hpp"
 //#include "rkfunction.hpp"
 #include <map>
@@ -67,6 +68,8 @@ struct inputConfig {
 
   std::shared_ptr<class Writer> w;
   std::shared_ptr<class mpiHaloExchange> m;
+  std::shared_ptr<class ioStaging> staging;
+  std::shared_ptr<class checkpointManager> ckpt;
   //std::shared_ptr<class mpiBuffers> m;
   std::shared_ptr<class Logger> log;
   //std::vector<blockWriter<float> > ioblocks;
@@ -86,6 +89,8 @@ struct inputConfig {
   std::vector<FSCAL> M;
   std::vector<FSCAL> mu;
   bool diagnostics;
+  bool dryRun;       // stop once the simulation is allocated
+  bool memoryReport; // track view allocations and report memory usage
 
   FSCAL R;
   int scheme;
@@ -118,24 +123,44 @@ struct inputConfig {
   std::string restartName;
   bool restartReset;
   int restartTimeRemaining;
+  std::string checkpointPath;
+  int checkpointKeep;
+  int checkpointDrain;
+  bool checkpointPartner;
   std::string pathName;
   int tstart, tend;
   bool tinterval;
   bool chunkable;
   bool compressible;
+  bool asyncIO;
+  int initThreads;   // host threads evaluating Lua initial conditions, 0 for the node's share
+  int initTile;      // cells per batch of Lua evaluations
+  bool initCache;    // cache the grid and initial conditions under the restart path
+  bool initCacheHit; // the grid and initial conditions were read from the cache
+  std::string h5Layout;
   FSCAL time;
   int st;
   bool ceq,noise;
+  bool rollbackNoise;
+  int snapshots, maxRollbacks;
+  FSCAL rollbackDtFactor;
+  bool ceqLagged;
   FSCAL kap, eps, alpha, beta, betae;
   BCType bcL, bcR, bcB, bcT, bcH, bcF;
   FSCAL n_dh, n_coff, n_eta;
   int n_nt,n_mode;
   int t;
   int grid;
-  FSCAL h, tdx, tdy;
+  FSCAL h, tdx, tdy, tstretch;
+  bool terrainFollowing;
+  std::vector<std::vector<FSCAL>> axisNodes; // node coordinates along each axis of rectilinear grids
   int verbosity;
   int restartFlag;
   int exitFlag;
+#ifdef HAVE_MPI
+  int signalSend, signalRecv;
+  MPI_Request signalReq;
+#endif
   bool ioThisStep;
 
   std::vector<size_t> globalGridDims;
@@ -144,7 +169,16 @@ struct inputConfig {
   std::vector<size_t> localCellDims;
   std::vector<size_t> subdomainOffset;
 
-  int out_freq, stat_freq, write_freq, restart_freq;
+  int out_freq, stat_freq, write_freq, restart_freq, checkpoint_freq;
+  int rollback_freq, snapshot_freq;
+
+  bool statTimers;        // report timer imbalance with each status check
+  std::string timerFile;  // name of the timing files written at exit, empty for none
+
+  int traceStart;         // first traced step, -1 for the first step of the run
+  int traceSteps;         // number of traced steps, 0 to disable tracing
+  int traceEvents;        // events kept in each rank's trace ring
+  std::string traceName;  // name of the trace file
 };
 
 struct commandArgs {
@@ -155,6 +189,8 @@ struct commandArgs {
   int numThreads;
   int numDevices;
   bool diagnostics;
+  bool dryRun;
+  bool memory;
   std::string fileName;
 };
 
@@ -163,5 +199,6 @@ void executeConfiguration(struct inputConfig &, struct commandArgs cargs);
 
 int loadInitialConditions(struct inputConfig cf,  FS4D &v, FS4D &g);
 int loadGrid(struct inputConfig cf, FS4D &v);
+std::string initialCacheName(struct inputConfig &cf, const std::vector<std::string> &varNames);
 
 #endif // FIESTA_INPUT_HPP
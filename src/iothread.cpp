@@ -0,0 +1,92 @@
+/*
+  Copyright 2019-2021 The University of New Mexico
+
+  This file is part of FIESTA.
+  
+  FIESTA is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+  
+  FIESTA is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+  
+  You should have received a copy of the GNU Lesser General Public License
+  along with FIESTA.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "iothread.hpp"
+#include "trace.hpp"
+
+ioThread& ioThread::instance(){
+  static ioThread io;
+  return io;
+}
+
+ioThread::ioThread() : inflight(0), done(false) {}
+
+ioThread::~ioThread(){
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    done = true;
+  }
+  cv.notify_all();
+  if (worker.joinable())
+    worker.join();
+}
+
+// Queue a job for the worker.  The returned future completes once the job has
+// run and its captured state has been released.
+std::shared_future<void> ioThread::push(std::function<void()> job){
+  std::promise<void> done;
+  std::shared_future<void> future = done.get_future().share();
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!worker.joinable())
+      worker = std::thread(&ioThread::run, this);
+    jobs.emplace_back(std::move(job),std::move(done));
+    ++inflight;
+  }
+  cv.notify_all();
+  return future;
+}
+
+// block until every queued job has completed
+void ioThread::drain(){
+  std::unique_lock<std::mutex> lock(mtx);
+  cv.wait(lock, [this]{ return inflight == 0; });
+}
+
+// number of queued or executing jobs
+size_t ioThread::pending(){
+  std::lock_guard<std::mutex> lock(mtx);
+  return inflight;
+}
+
+void ioThread::run(){
+  while (true){
+    std::function<void()> job;
+    std::promise<void> complete;
+    {
+      std::unique_lock<std::mutex> lock(mtx);
+      cv.wait(lock, [this]{ return done || !jobs.empty(); });
+      if (jobs.empty())
+        return;
+      job = std::move(jobs.front().first);
+      complete = std::move(jobs.front().second);
+      jobs.pop_front();
+    }
+    Trace::begin("Asynchronous Write");
+    job();
+    Trace::end();
+    job = nullptr;
+    complete.set_value();
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      --inflight;
+    }
+    cv.notify_all();
+  }
+}
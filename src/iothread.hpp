@@ -0,0 +1,54 @@
+/*
+  Copyright 2019-2021 The University of New Mexico
+
+  This file is part of FIESTA.
+  
+  FIESTA is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+  
+  FIESTA is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+  
+  You should have received a copy of the GNU Lesser General Public License
+  along with FIESTA.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef IOTHREAD_H
+#define IOTHREAD_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+
+// Background I/O worker.  Jobs are executed one at a time in the order they
+// were pushed, so collective HDF5 and MPI operations issued from the worker are
+// matched across ranks as long as every rank pushes jobs in the same order.
+class ioThread {
+  public:
+    static ioThread& instance();
+
+    std::shared_future<void> push(std::function<void()> job);
+    void drain();
+    size_t pending();
+
+    ~ioThread();
+
+  private:
+    ioThread();
+    void run();
+
+    std::thread worker;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::deque<std::pair<std::function<void()>,std::promise<void>>> jobs;
+    size_t inflight;
+    bool done;
+};
+
+#endif
@@ -28,9 +28,16 @@
 #include <string>
 #include <regex>
 #include "block.hpp"
+#include "stats.hpp"
+#include "probes.hpp"
+#include "initial.hpp"
+#include "expression.hpp"
+#include <array>
 #include "fmt/core.h"
 #include "log2.hpp"
 #include <typeinfo>
+#include <algorithm>
+#include <map>
 
 using namespace std;
 using fmt::format;
@@ -49,6 +56,10 @@ luaReader::luaReader(std::string f_, std::string r_):filename(f_),root(r_){
   lua_newtable(L);
   lua_setfield(L,-2,"restart");
   lua_newtable(L);
+  lua_setfield(L,-2,"checkpoint");
+  lua_newtable(L);
+  lua_setfield(L,-2,"rollback");
+  lua_newtable(L);
   lua_setfield(L,-2,"bc");
   lua_newtable(L);
   lua_setfield(L,-2,"time");
@@ -68,6 +79,12 @@ luaReader::luaReader(std::string f_, std::string r_):filename(f_),root(r_){
   lua_setfield(L,-2,"progress");
   lua_newtable(L);
   lua_setfield(L,-2,"status");
+  lua_newtable(L);
+  lua_setfield(L,-2,"timers");
+  lua_newtable(L);
+  lua_setfield(L,-2,"trace");
+  lua_newtable(L);
+  lua_setfield(L,-2,"initialization");
 
   luaL_openlibs(L);
 
@@ -160,6 +177,35 @@ void luaReader::get(std::initializer_list<std::string> keys, vector<T>& v, int n
   lua_settop(L,top);
 }
 
+// get array with default
+template<class T>
+void luaReader::get(std::initializer_list<std::string> keys, vector<T>& v, int n, vector<T> d){
+  bool found=true;
+  int top=lua_gettop(L);
+
+  lua_getglobal(L,root.c_str());
+
+  std::string fullkey=root;
+  for (auto key : keys) fullkey=fmt::format("{}.{}",fullkey,key);
+
+  for (auto key : keys){
+    lua_getfield(L,-1,key.c_str());
+    if(lua_isnoneornil(L,-1)){
+      found=false;
+      break;
+    }
+  }
+  if (found){
+    v.clear();
+    getArray<T>(v,n);
+    Log::info("LUA READER: Found {}={}",fullkey,v);
+  }else{
+    Log::infoWarning("LUA READER: Could not find '{}' setting default ({})",fullkey,d);
+    v=d;
+  }
+  lua_settop(L,top);
+}
+
 void luaReader::getSpeciesData(struct inputConfig& cf){
   int isnum;
 
@@ -205,7 +251,36 @@ void luaReader::getSpeciesData(struct inputConfig& cf){
   lua_pop(L,1);
 }
 
-void luaReader::getIOBlock(struct inputConfig& cf, std::unique_ptr<class rk_func>& f, int ndim, vector<blockWriter<float> >& blocks){
+// Read the error bound in the table at the top of the stack
+static errorBound getErrorBound(lua_State *L, std::string view, std::string field){
+  int isnum;
+  errorBound bound;
+
+  lua_getfield(L,-1,"relative");
+  lua_getfield(L,-2,"absolute");
+  bool rel = !lua_isnoneornil(L,-2);
+  bool abs = !lua_isnoneornil(L,-1);
+  if (rel && abs){
+    Log::error("Lossy compression of {} in ioview '{}' takes either a relative or an absolute tolerance.",field,view);
+    exit(EXIT_FAILURE);
+  }
+  if (rel){
+    bound.tolerance = lua_tonumberx(L,-2,&isnum);
+    bound.relative = true;
+  }
+  if (abs)
+    bound.tolerance = lua_tonumberx(L,-1,&isnum);
+  lua_pop(L,2);
+
+  if (bound.tolerance < 0.0){
+    Log::error("Lossy compression tolerance of {} in ioview '{}' must not be negative.",field,view);
+    exit(EXIT_FAILURE);
+  }
+  return bound;
+}
+
+void luaReader::getIOBlock(struct inputConfig& cf, std::unique_ptr<class rk_func>& f, int ndim, vector<blockWriter<float> >& blocks,
+                           vector<std::shared_ptr<class runningStats>>& stats){
   int isnum;
   size_t numElems;
   size_t numBlocks;
@@ -222,8 +297,16 @@ void luaReader::getIOBlock(struct inputConfig& cf, std::unique_ptr<class rk_func
   if (lua_istable(L,-1)){
     numBlocks=lua_rawlen(L,-1);
     for (size_t i=0; i<numBlocks; ++i){
-      std::string myname,mypath;
+      std::string myname,mypath,layout,type;
+      bool series=false;
+      int perFile=0;
+      int deflate=0;
+      errorBound boundDefault;
+      std::map<std::string,errorBound> bounds;
       vector<size_t> start,limit,stride;
+      vector<std::string> fields;
+      vector<std::pair<std::string,std::string>> pairs;
+      int sample=1;
       lua_pushnumber(L,i+1);
       lua_gettable(L,-2);
       
@@ -249,6 +332,125 @@ void luaReader::getIOBlock(struct inputConfig& cf, std::unique_ptr<class rk_func
         avg = 1;
       lua_pop(L,1);
 
+      lua_getfield(L,-1,"layout");
+      if (!lua_isnoneornil(L,-1))
+        layout.assign(lua_tostring(L,-1));
+      else
+        layout = cf.h5Layout;
+      lua_pop(L,1);
+
+      if (layout != "fields" && layout != "combined"){
+        Log::error("Unknown layout '{}' for ioview '{}'.  Expected 'fields' or 'combined'.",layout,myname);
+        exit(EXIT_FAILURE);
+      }
+
+      lua_getfield(L,-1,"type");
+      if (!lua_isnoneornil(L,-1))
+        type.assign(lua_tostring(L,-1));
+      else
+        type = "solution";
+      lua_pop(L,1);
+
+      if (type != "solution" && type != "statistics"){
+        Log::error("Unknown type '{}' for ioview '{}'.  Expected 'solution' or 'statistics'.",type,myname);
+        exit(EXIT_FAILURE);
+      }
+
+      // append outputs to time series files instead of a file per output
+      lua_getfield(L,-1,"series");
+      if (!lua_isnoneornil(L,-1))
+        series = lua_toboolean(L,-1);
+      lua_pop(L,1);
+
+      lua_getfield(L,-1,"steps_per_file");
+      if (!lua_isnoneornil(L,-1))
+        perFile = lua_tointegerx(L,-1,&isnum);
+      lua_pop(L,1);
+
+      if (perFile < 0){
+        Log::error("steps_per_file of ioview '{}' must not be negative.",myname);
+        exit(EXIT_FAILURE);
+      }
+
+      // error-bounded lossy compression, a default bound and bounds per field
+      lua_getfield(L,-1,"lossy");
+      if (lua_istable(L,-1)){
+        boundDefault = getErrorBound(L,myname,"all fields");
+
+        lua_getfield(L,-1,"deflate");
+        if (!lua_isnoneornil(L,-1))
+          deflate = lua_tointegerx(L,-1,&isnum);
+        else
+          deflate = 1;
+        lua_pop(L,1);
+
+        if (deflate < 1 || deflate > 9){
+          Log::error("Deflate level of ioview '{}' must be between 1 and 9.",myname);
+          exit(EXIT_FAILURE);
+        }
+
+        lua_getfield(L,-1,"fields");
+        if (lua_istable(L,-1)){
+          lua_pushnil(L);
+          while (lua_next(L,-2) != 0){
+            if (lua_type(L,-2) != LUA_TSTRING){
+              Log::error("Lossy compression fields of ioview '{}' must be keyed by field name.",myname);
+              exit(EXIT_FAILURE);
+            }
+            std::string fname(lua_tostring(L,-2));
+            if (!lua_istable(L,-1)){
+              Log::error("Lossy compression of {} in ioview '{}' must be a table.",fname,myname);
+              exit(EXIT_FAILURE);
+            }
+            bounds[fname] = getErrorBound(L,myname,fname);
+            lua_pop(L,1);
+          }
+        }
+        lua_pop(L,1);
+      }
+      lua_pop(L,1);
+
+      if (type == "statistics"){
+        lua_getfield(L,-1,"sample");
+        if (!lua_isnoneornil(L,-1))
+          sample = lua_tointegerx(L,-1,&isnum);
+        lua_pop(L,1);
+
+        // fields to accumulate, all primary variables by default
+        lua_getfield(L,-1,"fields");
+        if (lua_istable(L,-1)){
+          numElems = lua_rawlen(L,-1);
+          for(size_t j=0;j<numElems; ++j){
+            lua_pushnumber(L,j+1);
+            lua_gettable(L,-2);
+            fields.push_back(lua_tostring(L,-1));
+            lua_pop(L,1);
+          }
+        }else{
+          fields = f->varNames;
+        }
+        lua_pop(L,1);
+
+        // pairs of fields to correlate
+        lua_getfield(L,-1,"covariances");
+        if (lua_istable(L,-1)){
+          numElems = lua_rawlen(L,-1);
+          for(size_t j=0;j<numElems; ++j){
+            lua_pushnumber(L,j+1);
+            lua_gettable(L,-2);
+            if (!lua_istable(L,-1) || lua_rawlen(L,-1) != 2){
+              Log::error("Covariances of ioview '{}' must be pairs of field names.",myname);
+              exit(EXIT_FAILURE);
+            }
+            lua_rawgeti(L,-1,1);
+            lua_rawgeti(L,-2,2);
+            pairs.push_back({lua_tostring(L,-2),lua_tostring(L,-1)});
+            lua_pop(L,3);
+          }
+        }
+        lua_pop(L,1);
+      }
+
       lua_getfield(L,-1,"start");
       if (lua_istable(L,-1)){
         numElems = lua_rawlen(L,-1);
@@ -305,6 +507,15 @@ void luaReader::getIOBlock(struct inputConfig& cf, std::unique_ptr<class rk_func
         blocks.push_back(blockWriter<float>(cf,f,myname,mypath,avg,frq,true));
       else
         blocks.push_back(blockWriter<float>(cf,f,myname,mypath,avg,frq,start,limit,stride,true));
+      blocks.back().combineFields(layout == "combined");
+      if (series)
+        blocks.back().appendSteps(perFile);
+      if (deflate > 0)
+        blocks.back().compressLossy(boundDefault,bounds,deflate);
+      if (type == "statistics"){
+        stats.push_back(std::make_shared<runningStats>(cf,f,myname,sample,fields,pairs));
+        blocks.back().writeStatistics(stats.back());
+      }
 
       lua_pop(L,1);
     }
@@ -313,6 +524,448 @@ void luaReader::getIOBlock(struct inputConfig& cf, std::unique_ptr<class rk_func
   }
 }
 
+// Read a point or vector from the table at the top of the stack
+static std::array<FSCAL,3> getPoint(lua_State *L, int ndim){
+  int isnum;
+  std::array<FSCAL,3> x = {0.0, 0.0, 0.0};
+  if (!lua_istable(L,-1)){
+    Log::error("Expected a table of coordinates in probe definition.");
+    exit(EXIT_FAILURE);
+  }
+  for (int d=0; d<ndim; ++d){
+    lua_rawgeti(L,-1,d+1);
+    x[d] = (FSCAL)lua_tonumberx(L,-1,&isnum);
+    lua_pop(L,1);
+  }
+  return x;
+}
+
+// Read probe groups.  Each group samples points listed individually, evenly
+// spaced along a line or on a plane spanned by two edge vectors.
+void luaReader::getProbes(struct inputConfig& cf, std::unique_ptr<class rk_func>& f,
+                          vector<std::shared_ptr<class probeGroup>>& probes){
+  int isnum;
+  size_t numElems;
+
+  lua_getglobal(L,root.c_str());
+  lua_getfield(L, -1, "probes");
+  if (!lua_istable(L,-1)){
+    lua_pop(L,2);
+    return;
+  }
+
+  size_t numGroups=lua_rawlen(L,-1);
+  for (size_t i=0; i<numGroups; ++i){
+    std::string myname,mypath;
+    vector<std::string> fields;
+    vector<std::array<FSCAL,3>> points;
+    int frq=1;
+    int buffer=1000;
+    lua_rawgeti(L,-1,i+1);
+
+    lua_getfield(L,-1,"name");
+    if (lua_isnoneornil(L,-1)){
+      Log::error("Probe group {} in '{}' has no name.",i+1,filename);
+      exit(EXIT_FAILURE);
+    }
+    myname.assign(lua_tostring(L,-1));
+    lua_pop(L,1);
+
+    lua_getfield(L,-1,"path");
+    if (!lua_isnoneornil(L,-1))
+      mypath.assign(lua_tostring(L,-1));
+    else
+      mypath.assign("./");
+    lua_pop(L,1);
+
+    lua_getfield(L,-1,"frequency");
+    if (!lua_isnoneornil(L,-1))
+      frq = lua_tointegerx(L,-1,&isnum);
+    lua_pop(L,1);
+
+    lua_getfield(L,-1,"buffer");
+    if (!lua_isnoneornil(L,-1))
+      buffer = lua_tointegerx(L,-1,&isnum);
+    lua_pop(L,1);
+
+    lua_getfield(L,-1,"fields");
+    if (lua_istable(L,-1)){
+      numElems = lua_rawlen(L,-1);
+      for(size_t j=0;j<numElems; ++j){
+        lua_rawgeti(L,-1,j+1);
+        fields.push_back(lua_tostring(L,-1));
+        lua_pop(L,1);
+      }
+    }else{
+      fields = f->varNames;
+    }
+    lua_pop(L,1);
+
+    lua_getfield(L,-1,"points");
+    if (lua_istable(L,-1)){
+      numElems = lua_rawlen(L,-1);
+      for(size_t j=0;j<numElems; ++j){
+        lua_rawgeti(L,-1,j+1);
+        points.push_back(getPoint(L,cf.ndim));
+        lua_pop(L,1);
+      }
+    }
+    lua_pop(L,1);
+
+    lua_getfield(L,-1,"line");
+    if (lua_istable(L,-1)){
+      lua_getfield(L,-1,"start");
+      auto a = getPoint(L,cf.ndim);
+      lua_getfield(L,-2,"finish");
+      auto b = getPoint(L,cf.ndim);
+      lua_getfield(L,-3,"count");
+      int n = lua_tointegerx(L,-1,&isnum);
+      lua_pop(L,3);
+      for (int j=0; j<n; ++j){
+        FSCAL s = (n > 1) ? (FSCAL)j/(n-1) : 0.0;
+        points.push_back({a[0]+s*(b[0]-a[0]), a[1]+s*(b[1]-a[1]), a[2]+s*(b[2]-a[2])});
+      }
+    }
+    lua_pop(L,1);
+
+    lua_getfield(L,-1,"plane");
+    if (lua_istable(L,-1)){
+      lua_getfield(L,-1,"origin");
+      auto o = getPoint(L,cf.ndim);
+      lua_getfield(L,-2,"u");
+      auto u = getPoint(L,cf.ndim);
+      lua_getfield(L,-3,"v");
+      auto v = getPoint(L,cf.ndim);
+      lua_getfield(L,-4,"count");
+      lua_rawgeti(L,-1,1);
+      int nu = lua_tointegerx(L,-1,&isnum);
+      lua_rawgeti(L,-2,2);
+      int nv = lua_tointegerx(L,-1,&isnum);
+      lua_pop(L,6);
+      for (int b=0; b<nv; ++b){
+        FSCAL sv = (nv > 1) ? (FSCAL)b/(nv-1) : 0.0;
+        for (int a=0; a<nu; ++a){
+          FSCAL su = (nu > 1) ? (FSCAL)a/(nu-1) : 0.0;
+          points.push_back({o[0]+su*u[0]+sv*v[0], o[1]+su*u[1]+sv*v[1], o[2]+su*u[2]+sv*v[2]});
+        }
+      }
+    }
+    lua_pop(L,1);
+
+    probes.push_back(std::make_shared<probeGroup>(cf,f,myname,mypath,frq,buffer,fields,points));
+    lua_pop(L,1);
+  }
+  lua_pop(L,2);
+}
+
+// Read a primitive state from the table at the top of the stack.  Densities
+// are given per species, or as a total density and mass fractions.
+static icState getState(lua_State *L, struct inputConfig& cf, std::string where, bool hydrostatic){
+  int isnum;
+  icState st;
+
+  lua_getfield(L,-1,"density");
+  if (lua_istable(L,-1)){
+    if ((int)lua_rawlen(L,-1) != cf.ns){
+      Log::error("The density of {} needs {} species densities.",where,cf.ns);
+      exit(EXIT_FAILURE);
+    }
+    for (int s=0; s<cf.ns; ++s){
+      lua_rawgeti(L,-1,s+1);
+      st.density.push_back((FSCAL)lua_tonumberx(L,-1,&isnum));
+      lua_pop(L,1);
+    }
+  }else if (lua_isnumber(L,-1)){
+    FSCAL rho = (FSCAL)lua_tonumberx(L,-1,&isnum);
+    lua_getfield(L,-2,"fractions");
+    if (lua_istable(L,-1) && (int)lua_rawlen(L,-1) == cf.ns){
+      for (int s=0; s<cf.ns; ++s){
+        lua_rawgeti(L,-1,s+1);
+        st.density.push_back(rho*(FSCAL)lua_tonumberx(L,-1,&isnum));
+        lua_pop(L,1);
+      }
+    }else if (cf.ns == 1){
+      st.density.push_back(rho);
+    }else{
+      Log::error("The density of {} needs {} mass fractions.",where,cf.ns);
+      exit(EXIT_FAILURE);
+    }
+    lua_pop(L,1);
+  }else{
+    Log::error("Missing density in {}.",where);
+    exit(EXIT_FAILURE);
+  }
+  lua_pop(L,1);
+
+  for (auto rho : st.density){
+    if (rho < 0.0){
+      Log::error("Densities of {} must not be negative.",where);
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  lua_getfield(L,-1,"velocity");
+  if (!lua_isnoneornil(L,-1))
+    st.velocity = getPoint(L,cf.ndim);
+  lua_pop(L,1);
+
+  lua_getfield(L,-1,"pressure");
+  lua_getfield(L,-2,"temperature");
+  bool pres = !lua_isnoneornil(L,-2);
+  bool temp = !lua_isnoneornil(L,-1);
+  if (pres && temp){
+    Log::error("{} takes either a pressure or a temperature.",where);
+    exit(EXIT_FAILURE);
+  }
+  if (!pres && !temp && !hydrostatic){
+    Log::error("Missing pressure or temperature in {}.",where);
+    exit(EXIT_FAILURE);
+  }
+  if (pres)
+    st.pressure = (FSCAL)lua_tonumberx(L,-2,&isnum);
+  if (temp){
+    st.temperature = (FSCAL)lua_tonumberx(L,-1,&isnum);
+    st.hasTemperature = true;
+  }
+  lua_pop(L,2);
+
+  return st;
+}
+
+// Read a number from the table at the top of the stack, required unless a
+// default is given
+static FSCAL getNumber(lua_State *L, std::string key, std::string where, bool required, FSCAL d=0.0){
+  int isnum;
+  FSCAL n = d;
+  lua_getfield(L,-1,key.c_str());
+  if (!lua_isnoneornil(L,-1)){
+    n = (FSCAL)lua_tonumberx(L,-1,&isnum);
+  }else if (required){
+    Log::error("Missing {} in {}.",key,where);
+    exit(EXIT_FAILURE);
+  }
+  lua_pop(L,1);
+  return n;
+}
+
+// Read a point from the table at the top of the stack
+static std::array<FSCAL,3> getPointField(lua_State *L, std::string key, std::string where, int ndim){
+  lua_getfield(L,-1,key.c_str());
+  if (lua_isnoneornil(L,-1)){
+    Log::error("Missing {} in {}.",key,where);
+    exit(EXIT_FAILURE);
+  }
+  std::array<FSCAL,3> x = getPoint(L,ndim);
+  lua_pop(L,1);
+  return x;
+}
+
+// Read declarative initial conditions from fiesta.initialization: a
+// background state, regions painted over it and an optional hydrostatic
+// pressure.  Returns nothing if no background state is given, so that the
+// initial_conditions function is used.
+std::unique_ptr<class initialConditions> luaReader::getInitialConditions(struct inputConfig& cf){
+  size_t numElems;
+  std::unique_ptr<class initialConditions> ic;
+
+  lua_getglobal(L,root.c_str());
+  lua_getfield(L,-1,"initialization");
+  lua_getfield(L,-1,"state");
+  if (!lua_istable(L,-1)){
+    lua_pop(L,3);
+    return ic;
+  }
+  lua_pop(L,1);
+
+  bool hydrostatic = false;
+  FSCAL topPressure = 0.0;
+  FSCAL accel = cf.buoyancy ? cf.gAccel : 9.81;
+  lua_getfield(L,-1,"hydrostatic");
+  if (lua_istable(L,-1)){
+    hydrostatic = true;
+    topPressure = getNumber(L,"pressure","hydrostatic initialization",true);
+    accel = getNumber(L,"acceleration","hydrostatic initialization",false,accel);
+  }
+  lua_pop(L,1);
+
+  lua_getfield(L,-1,"state");
+  icState background = getState(L,cf,"the background state",hydrostatic);
+  lua_pop(L,1);
+
+  std::vector<icRegion> regions;
+  lua_getfield(L,-1,"regions");
+  if (lua_istable(L,-1)){
+    numElems = lua_rawlen(L,-1);
+    for (size_t r=0; r<numElems; ++r){
+      std::string where = fmt::format("initial condition region {}",r+1);
+      icRegion reg;
+      lua_rawgeti(L,-1,r+1);
+
+      lua_getfield(L,-1,"shape");
+      std::string shape = lua_isstring(L,-1) ? lua_tostring(L,-1) : "";
+      lua_pop(L,1);
+
+      if (shape == "sphere" || shape == "circle"){
+        reg.shape = icSphere;
+        reg.a = getPointField(L,"center",where,cf.ndim);
+        reg.radius = getNumber(L,"radius",where,true);
+      }else if (shape == "box"){
+        reg.shape = icBox;
+        reg.a = getPointField(L,"lower",where,cf.ndim);
+        reg.b = getPointField(L,"upper",where,cf.ndim);
+      }else if (shape == "halfspace"){
+        reg.shape = icHalfspace;
+        reg.a = getPointField(L,"origin",where,cf.ndim);
+        reg.b = getPointField(L,"normal",where,cf.ndim);
+
+        // interface displacements, cosines or gaussian bumps
+        lua_getfield(L,-1,"modes");
+        if (lua_istable(L,-1)){
+          size_t nmodes = lua_rawlen(L,-1);
+          for (size_t m=0; m<nmodes; ++m){
+            icMode mode;
+            lua_rawgeti(L,-1,m+1);
+            mode.amplitude = getNumber(L,"amplitude",where,true);
+            lua_getfield(L,-1,"wavevector");
+            bool cosine = !lua_isnoneornil(L,-1);
+            lua_pop(L,1);
+            if (cosine){
+              mode.v = getPointField(L,"wavevector",where,cf.ndim);
+              mode.s = getNumber(L,"phase",where,false);
+            }else{
+              mode.gaussian = true;
+              mode.v = getPointField(L,"center",where,cf.ndim);
+              mode.s = getNumber(L,"width",where,true);
+              if (mode.s <= 0.0){
+                Log::error("Gaussian modes of {} need a positive width.",where);
+                exit(EXIT_FAILURE);
+              }
+            }
+            reg.modes.push_back(mode);
+            lua_pop(L,1);
+          }
+        }
+        lua_pop(L,1);
+      }else{
+        Log::error("Unknown shape '{}' in {}.  Expected 'sphere', 'box' or 'halfspace'.",shape,where);
+        exit(EXIT_FAILURE);
+      }
+
+      reg.width = getNumber(L,"width",where,false);
+      if (reg.width < 0.0){
+        Log::error("The blending width of {} must not be negative.",where);
+        exit(EXIT_FAILURE);
+      }
+
+      lua_getfield(L,-1,"state");
+      if (!lua_istable(L,-1)){
+        Log::error("Missing state in {}.",where);
+        exit(EXIT_FAILURE);
+      }
+      reg.state = getState(L,cf,where,hydrostatic);
+      lua_pop(L,1);
+
+      regions.push_back(reg);
+      lua_pop(L,1);
+    }
+  }
+  lua_pop(L,3);
+
+  ic = std::make_unique<initialConditions>(cf,background,regions,hydrostatic,topPressure,accel);
+  return ic;
+}
+
+// Read a list of strings from the table at the top of the stack
+static std::vector<std::string> getStrings(lua_State *L, std::string key, std::string where){
+  std::vector<std::string> strings;
+  lua_getfield(L,-1,key.c_str());
+  if (lua_istable(L,-1)){
+    size_t n = lua_rawlen(L,-1);
+    for (size_t i=0; i<n; ++i){
+      lua_rawgeti(L,-1,i+1);
+      if (lua_type(L,-1) != LUA_TSTRING && lua_type(L,-1) != LUA_TNUMBER){
+        Log::error("Entry {} of {}.{} must be a string.",i+1,where,key);
+        exit(EXIT_FAILURE);
+      }
+      strings.push_back(lua_tostring(L,-1));
+      lua_pop(L,1);
+    }
+  }else if (!lua_isnoneornil(L,-1)){
+    Log::error("{}.{} must be a list of strings.",where,key);
+    exit(EXIT_FAILURE);
+  }
+  lua_pop(L,1);
+  return strings;
+}
+
+// Read a list of numbers from the table at the top of the stack
+static std::vector<FSCAL> getNumbers(lua_State *L, std::string key, std::string where){
+  std::vector<FSCAL> numbers;
+  lua_getfield(L,-1,key.c_str());
+  if (lua_istable(L,-1)){
+    size_t n = lua_rawlen(L,-1);
+    for (size_t i=0; i<n; ++i){
+      lua_rawgeti(L,-1,i+1);
+      if (lua_type(L,-1) != LUA_TNUMBER){
+        Log::error("Entry {} of {}.{} must be a number.",i+1,where,key);
+        exit(EXIT_FAILURE);
+      }
+      numbers.push_back((FSCAL)lua_tonumber(L,-1));
+      lua_pop(L,1);
+    }
+  }else if (!lua_isnoneornil(L,-1)){
+    Log::error("{}.{} must be a list of numbers.",where,key);
+    exit(EXIT_FAILURE);
+  }
+  lua_pop(L,1);
+  return numbers;
+}
+
+// Read initial conditions or a grid given as a table of expressions instead
+// of a function: the value of each output, definitions of intermediate values
+// and named constants.  Returns nothing if fname is not a table, so that the
+// Lua function is used.
+std::unique_ptr<class expression> luaReader::getExpression(std::string fname, std::vector<std::string> inputs, int nout){
+  std::unique_ptr<class expression> ex;
+  std::string where = fmt::format("{}.{}",root,fname);
+
+  lua_getglobal(L,root.c_str());
+  lua_getfield(L,-1,fname.c_str());
+  if (!lua_istable(L,-1)){
+    lua_pop(L,2);
+    return ex;
+  }
+
+  std::vector<std::string> values = getStrings(L,"values",where);
+  if ((int)values.size() != nout){
+    Log::error("{}.values needs {} expressions.",where,nout);
+    exit(EXIT_FAILURE);
+  }
+  std::vector<std::string> definitions = getStrings(L,"define",where);
+
+  std::map<std::string,FSCAL> constants;
+  lua_getfield(L,-1,"constants");
+  if (lua_istable(L,-1)){
+    lua_pushnil(L);
+    while (lua_next(L,-2) != 0){
+      if (lua_type(L,-2) != LUA_TSTRING || !lua_isnumber(L,-1)){
+        Log::error("{}.constants must map names to numbers.",where);
+        exit(EXIT_FAILURE);
+      }
+      constants[lua_tostring(L,-2)] = (FSCAL)lua_tonumber(L,-1);
+      lua_pop(L,1);
+    }
+  }
+  lua_pop(L,1);
+
+  lua_getfield(L,-1,"validate");
+  bool validate = lua_toboolean(L,-1);
+  lua_pop(L,3);
+
+  ex = std::make_unique<expression>(fname,inputs,constants,definitions,values,validate);
+  return ex;
+}
+
 // Call lua function from c (takes integer arguments and returns a FSCAL)
 FSCAL luaReader::call(std::string f, int n, ...){
   lua_getglobal(L,root.c_str());
@@ -344,6 +997,242 @@ FSCAL luaReader::call(std::string f, int n, ...){
   return z;
 }
 
+// Call lua function with arrays of arguments.  The function returns a table
+// of nout arrays, each as long as the arguments.
+void luaReader::callBatch(std::string f, const std::vector<std::vector<FSCAL>>& args, int nout,
+                          std::vector<std::vector<FSCAL>>& out){
+  lua_getglobal(L,root.c_str());
+  lua_getfield(L, -1, f.c_str());
+  if(lua_isnoneornil(L,-1)){
+    Log::error("Could not find {}.{} in '{}'",root,f,filename);
+    exit(EXIT_FAILURE);
+  }
+  int isnum;
+
+  size_t n = args.empty() ? 0 : args[0].size();
+  for (auto const& arg : args){
+    lua_createtable(L, arg.size(), 0);
+    for (size_t i=0; i<arg.size(); ++i){
+      lua_pushnumber(L, arg[i]);
+      lua_rawseti(L, -2, i+1);
+    }
+  }
+
+  if (lua_pcall(L, args.size(), 1, 0) != LUA_OK)
+    error(L, "error running function '%s': %s\n",f.c_str(),lua_tostring(L, -1));
+  if (!lua_istable(L,-1) || (int)lua_rawlen(L,-1) < nout)
+    error(L, "function '%s' should return a table of %d arrays\n",f.c_str(),nout);
+
+  out.resize(nout);
+  for (int v=0; v<nout; ++v){
+    lua_rawgeti(L, -1, v+1);
+    if (!lua_istable(L,-1) || lua_rawlen(L,-1) != n)
+      error(L, "function '%s' should return arrays of %d numbers\n",f.c_str(),(int)n);
+    out[v].resize(n);
+    for (size_t i=0; i<n; ++i){
+      lua_rawgeti(L, -1, i+1);
+      out[v][i] = (FSCAL)lua_tonumberx(L, -1, &isnum);
+      if (!isnum)
+        error(L, "function '%s' should return arrays of numbers\n",f.c_str());
+      lua_pop(L, 1);
+    }
+    lua_pop(L, 1);
+  }
+  lua_pop(L, 2);
+}
+
+// check if a function is defined in the root table
+bool luaReader::hasFunction(std::string f){
+  lua_getglobal(L,root.c_str());
+  lua_getfield(L, -1, f.c_str());
+  bool found = lua_isfunction(L,-1);
+  lua_pop(L, 2);
+  return found;
+}
+
+// Get a list of strings, empty if it is not found
+std::vector<std::string> luaReader::getStringList(std::initializer_list<std::string> keys){
+  std::vector<std::string> v;
+  int top=lua_gettop(L);
+
+  lua_getglobal(L,root.c_str());
+
+  std::string where=root;
+  size_t n=0;
+  for (auto key : keys){
+    if (++n == keys.size()){
+      v = getStrings(L,key,where);
+      break;
+    }
+    where=fmt::format("{}.{}",where,key);
+    lua_getfield(L,-1,key.c_str());
+    if(!lua_istable(L,-1)) break;
+  }
+  lua_settop(L,top);
+  return v;
+}
+
+std::vector<FSCAL> luaReader::getNumberList(std::initializer_list<std::string> keys){
+  std::vector<FSCAL> v;
+  int top=lua_gettop(L);
+
+  lua_getglobal(L,root.c_str());
+
+  std::string where=root;
+  size_t n=0;
+  for (auto key : keys){
+    if (++n == keys.size()){
+      v = getNumbers(L,key,where);
+      break;
+    }
+    where=fmt::format("{}.{}",where,key);
+    lua_getfield(L,-1,key.c_str());
+    if(!lua_istable(L,-1)) break;
+  }
+  lua_settop(L,top);
+  return v;
+}
+
+static int appendChunk(lua_State *L, const void* p, size_t sz, void* out){
+  static_cast<std::string*>(out)->append(static_cast<const char*>(p),sz);
+  return 0;
+}
+
+// Append a description of the value at idx that does not depend on the order
+// tables are traversed in.  Table entries are sorted by key, functions are
+// described by their stripped bytecode and upvalues, and a table seen before
+// by its number.  Entries of the global table whose path is in skip, the
+// libraries and C functions are left out.
+static void describe(lua_State *L, int idx, std::string path, const std::set<std::string>& skip,
+                     const std::set<const void*>& libs, std::map<const void*,int>& seen, std::string& out){
+  idx = lua_absindex(L,idx);
+  switch (lua_type(L,idx)){
+    case LUA_TNIL:
+      out += "nil";
+      break;
+    case LUA_TBOOLEAN:
+      out += lua_toboolean(L,idx) ? "true" : "false";
+      break;
+    case LUA_TNUMBER:
+      if (lua_isinteger(L,idx))
+        out += format("i{}",(long long)lua_tointeger(L,idx));
+      else
+        out += format("n{:a}",(double)lua_tonumber(L,idx));
+      break;
+    case LUA_TSTRING: {
+      size_t n;
+      const char* str = lua_tolstring(L,idx,&n);
+      out += format("s{}:",n);
+      out.append(str,n);
+      break;
+    }
+    case LUA_TTABLE: {
+      const void* p = lua_topointer(L,idx);
+      if (seen.count(p)){
+        out += format("r{}",seen[p]);
+        break;
+      }
+      int id = seen.size();
+      seen[p] = id;
+
+      // describe the keys, then the values in key order
+      std::vector<std::pair<std::string,std::string>> keys;
+      lua_pushnil(L);
+      while (lua_next(L,idx) != 0){
+        std::string key, name;
+        int kt = lua_type(L,-2);
+        if (kt == LUA_TSTRING){
+          name = lua_tostring(L,-2);
+          key = "s" + name;
+        }else if (kt == LUA_TNUMBER || kt == LUA_TBOOLEAN){
+          std::map<const void*,int> none;
+          describe(L,-2,"",skip,libs,none,key);
+        }else{
+          key = lua_typename(L,kt);
+        }
+        std::string child = path.empty() ? name : path + "." + name;
+        bool lib = (path.empty() && (lua_iscfunction(L,-1) || libs.count(lua_topointer(L,-1)))) ||
+                   (kt == LUA_TSTRING && skip.count(child));
+        if (!lib) keys.push_back({key,name});
+        lua_pop(L,1);
+      }
+      std::sort(keys.begin(),keys.end());
+
+      out += "{";
+      for (auto& k : keys){
+        out += k.first + "=";
+        if (k.first[0] == 's'){
+          lua_getfield(L,idx,k.second.c_str());
+        }else{
+          // find the entry again for keys that are not strings
+          lua_pushnil(L);
+          while (lua_next(L,idx) != 0){
+            std::string key;
+            std::map<const void*,int> none;
+            if (lua_type(L,-2) == LUA_TNUMBER || lua_type(L,-2) == LUA_TBOOLEAN)
+              describe(L,-2,"",skip,libs,none,key);
+            else
+              key = lua_typename(L,lua_type(L,-2));
+            if (key == k.first){
+              lua_remove(L,-2);
+              break;
+            }
+            lua_pop(L,1);
+          }
+        }
+        std::string child = path.empty() ? k.second : path + "." + k.second;
+        describe(L,-1,k.first[0] == 's' ? child : "",skip,libs,seen,out);
+        lua_pop(L,1);
+        out += ";";
+      }
+      out += "}";
+      break;
+    }
+    case LUA_TFUNCTION:
+      if (lua_iscfunction(L,idx)){
+        out += "cfunction";
+        break;
+      }
+      out += "f";
+      lua_pushvalue(L,idx);
+      lua_dump(L,appendChunk,&out,1);
+      lua_pop(L,1);
+      for (int u=1; lua_getupvalue(L,idx,u) != NULL; ++u){
+        out += ",";
+        // the global table, which is described first
+        if (lua_istable(L,-1) && seen.count(lua_topointer(L,-1)) && seen[lua_topointer(L,-1)] == 0)
+          out += "_ENV";
+        else
+          describe(L,-1,"",skip,libs,seen,out);
+        lua_pop(L,1);
+      }
+      break;
+    default:
+      out += lua_typename(L,lua_type(L,idx));
+  }
+}
+
+// Describe the global variables, other than the libraries and the entries in
+// skip, such as "fiesta.time", in a form that only changes when they change.
+std::string luaReader::fingerprint(const std::set<std::string>& skip){
+  std::set<const void*> libs;
+  lua_getglobal(L,"package");
+  lua_getfield(L,-1,"loaded");
+  lua_pushnil(L);
+  while (lua_next(L,-2) != 0){
+    libs.insert(lua_topointer(L,-1));
+    lua_pop(L,1);
+  }
+  lua_pop(L,2);
+
+  std::string out;
+  std::map<const void*,int> seen;
+  lua_pushglobaltable(L);
+  describe(L,-1,"",skip,libs,seen,out);
+  lua_pop(L,1);
+  return out;
+}
+
 // Close Script
 void luaReader::close(){
   lua_close(L);
@@ -451,3 +1340,8 @@ template void luaReader::get<int>(std::initializer_list<std::string>,vector<int>
 template void luaReader::get<double>(std::initializer_list<std::string>,vector<double>&,int);
 template void luaReader::get<float>(std::initializer_list<std::string>,vector<float>&,int);
 template void luaReader::get<size_t>(std::initializer_list<std::string>,vector<size_t>&,int);
+
+template void luaReader::get<int>(std::initializer_list<std::string>,vector<int>&,int,vector<int>);
+template void luaReader::get<size_t>(std::initializer_list<std::string>,vector<size_t>&,int,vector<size_t>);
+template void luaReader::get<double>(std::initializer_list<std::string>,vector<double>&,int,vector<double>);
+template void luaReader::get<float>(std::initializer_list<std::string>,vector<float>&,int,vector<float>);
@@ -23,6 +23,7 @@
 #include <string>
 #include "lua.hpp"
 #include <vector>
+#include <set>
 #include "block.hpp"
 #include "input.hpp"
 #include "rkfunction.hpp"
@@ -40,7 +41,11 @@ public:
   void getArray(std::vector<T>&,int);
 
   void getSpeciesData(struct inputConfig&);
-  void getIOBlock(struct inputConfig&, std::unique_ptr<class rk_func>&, int, vector<blockWriter<float>>&);
+  void getIOBlock(struct inputConfig&, std::unique_ptr<class rk_func>&, int, vector<blockWriter<float>>&,
+                  vector<std::shared_ptr<class runningStats>>&);
+  void getProbes(struct inputConfig&, std::unique_ptr<class rk_func>&, vector<std::shared_ptr<class probeGroup>>&);
+  std::unique_ptr<class initialConditions> getInitialConditions(struct inputConfig&);
+  std::unique_ptr<class expression> getExpression(std::string, std::vector<std::string>, int);
 
   template <class T>
   void get(std::initializer_list<string> keys, T& n);
@@ -51,10 +56,18 @@ public:
   template <class T>
   void get(std::initializer_list<string> keys, std::vector<T>& v, int n);
 
+  template <class T>
+  void get(std::initializer_list<string> keys, std::vector<T>& v, int n, std::vector<T> d);
+
   template <class T>
   void getValue(T& n);
 
   FSCAL call(std::string, int ,...);
+  void callBatch(std::string, const std::vector<std::vector<FSCAL>>&, int, std::vector<std::vector<FSCAL>>&);
+  bool hasFunction(std::string);
+  std::vector<std::string> getStringList(std::initializer_list<string> keys);
+  std::vector<FSCAL> getNumberList(std::initializer_list<string> keys);
+  std::string fingerprint(const std::set<std::string>&);
 
 private:
   lua_State *L;
@@ -19,12 +19,15 @@
 
 #include "fiesta.hpp"
 #include "log2.hpp"
+#include "memory.hpp"
+#include "trace.hpp"
 
 // Compute Objects
 #include "cart2d.hpp"
 #include "cart3d.hpp"
 #include "gen2d.hpp"
 #include "gen3d.hpp"
+#include "terrain3d.hpp"
 
 int main(int argc, char *argv[]) {
   int exit_value=0;
@@ -38,7 +41,9 @@ int main(int argc, char *argv[]) {
  
     // Choose Module
     if (sim.cf.ndim == 3){
-      if (sim.cf.grid > 0)
+      if (sim.cf.terrainFollowing)
+        sim.f = std::make_unique<terrain3d_func>(sim.cf);
+      else if (sim.cf.grid == 1 || sim.cf.grid == 2)
         sim.f = std::make_unique<gen3d_func>(sim.cf);
       else
         sim.f = std::make_unique<cart3d_func>(sim.cf);
@@ -50,29 +55,44 @@ int main(int argc, char *argv[]) {
     }
 
     Fiesta::initializeSimulation(sim);
+    if (sim.cf.memoryReport)
+      Memory::report(sim.cf,"startup");
+
+    if (sim.cf.dryRun) {
+      sim.cf.initTimer.stop();
+      Log::message("Dry run complete, exiting before the main time loop");
+    }else{
+      Log::message("Executing pre-simulation hook");
+      sim.f->preSim();
 
-    Log::message("Executing pre-simulation hook");
-    sim.f->preSim();
+      sim.cf.initTimer.stop();
 
-    sim.cf.initTimer.stop();
+      Log::message("Beginning Main Time Loop");
+      sim.cf.simTimer.start();
+      for (int t = sim.cf.tstart; t < sim.cf.tend+1; ++t) {
+        Trace::step(sim.cf,t);
+        if (Fiesta::checkHealth(sim,t))
+          t = sim.cf.t;
+        else
+          Fiesta::checkIO(sim,t);
 
-    Log::message("Beginning Main Time Loop");
-    sim.cf.simTimer.start();
-    for (int t = sim.cf.tstart; t < sim.cf.tend+1; ++t) {
-      Fiesta::checkIO(sim,t);
+        if (sim.cf.exitFlag==1){
+          exit_value=1;
+          break;
+        }
 
-      if (sim.cf.exitFlag==1){
-        exit_value=1;
-        break;
+        Fiesta::step(sim,t);
       }
+      sim.cf.simTimer.stop();
+      Trace::finish(sim.cf);
+      Log::message("Simulation complete!");
+ 
+      Log::message("Executing post-simulation hook");
+      sim.f->postSim();
 
-      Fiesta::step(sim,t);
+      if (sim.cf.memoryReport)
+        Memory::report(sim.cf,"exit");
     }
-    sim.cf.simTimer.stop();
-    Log::message("Simulation complete!");
- 
-    Log::message("Executing post-simulation hook");
-    sim.f->postSim();
 
     sim.cf.totalTimer.stop();
     Fiesta::reportTimers(sim.cf,sim.f);
@@ -0,0 +1,185 @@
+/*
+  Copyright 2019-2021 The University of New Mexico
+
+  This file is part of FIESTA.
+  
+  FIESTA is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+  
+  FIESTA is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+  
+  You should have received a copy of the GNU Lesser General Public License
+  along with FIESTA.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "memory.hpp"
+#include "Kokkos_Core.hpp"
+#include "log2.hpp"
+#include "pretty.hpp"
+#include "fmt/core.h"
+#ifdef HAVE_MPI
+#include "mpi.h"
+#endif
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <vector>
+
+namespace {
+  struct usage {
+    uint64_t bytes = 0;   // currently allocated
+    uint64_t peak = 0;    // high-water
+    int count = 0;        // live allocations
+  };
+
+  struct allocation {
+    std::string space;
+    std::string label;
+    uint64_t bytes;
+  };
+
+  struct ledger {
+    std::mutex lock;  // the I/O thread allocates staging buffers
+    std::map<const void*, allocation> live;
+    std::map<std::string, usage> spaces;
+    std::map<std::pair<std::string,std::string>, usage> labels;  // by space and label
+  };
+
+  // never destroyed, views in static objects can be freed after main returns
+  ledger &book(){
+    static ledger *l = new ledger;
+    return *l;
+  }
+
+  void add(usage &u, uint64_t bytes){
+    u.bytes += bytes;
+    u.count += 1;
+    u.peak = std::max(u.peak,u.bytes);
+  }
+
+  void remove(usage &u, uint64_t bytes){
+    u.bytes -= std::min(u.bytes,bytes);
+    u.count -= 1;
+  }
+
+  void allocateData(const Kokkos::Tools::SpaceHandle handle, const char *label, const void *ptr, const uint64_t size){
+    ledger &l = book();
+    std::lock_guard<std::mutex> guard(l.lock);
+    allocation a{handle.name, label, size};
+    add(l.spaces[a.space],size);
+    add(l.labels[{a.space,a.label}],size);
+    l.live[ptr] = a;
+  }
+
+  void deallocateData(const Kokkos::Tools::SpaceHandle, const char *, const void *ptr, const uint64_t){
+    ledger &l = book();
+    std::lock_guard<std::mutex> guard(l.lock);
+    auto it = l.live.find(ptr);
+    if (it == l.live.end()) return;  // allocated before tracking started
+    const allocation &a = it->second;
+    remove(l.spaces[a.space],a.bytes);
+    remove(l.labels[{a.space,a.label}],a.bytes);
+    l.live.erase(it);
+  }
+
+  std::string size(uint64_t bytes){
+    if (bytes >= 1073741824)
+      return fmt::format("{:.2f} GiB",bytes/1073741824.0);
+    else if (bytes >= 1048576)
+      return fmt::format("{:.2f} MiB",bytes/1048576.0);
+    else
+      return fmt::format("{:.2f} KiB",bytes/1024.0);
+  }
+
+  // memory spaces used on any rank, in the same order on every rank
+  std::vector<std::string> allSpaces(struct inputConfig &cf, const std::map<std::string, usage> &spaces){
+    std::set<std::string> names;
+    for (auto& s : spaces)
+      names.insert(s.first);
+#ifdef HAVE_MPI
+    std::string mine;
+    for (auto& n : names)
+      mine += n + '\n';
+    int len = mine.size();
+    std::vector<int> lens(cf.numProcs), offsets(cf.numProcs,0);
+    MPI_Allgather(&len, 1, MPI_INT, lens.data(), 1, MPI_INT, cf.comm);
+    for (int r = 1; r < cf.numProcs; ++r)
+      offsets[r] = offsets[r-1] + lens[r-1];
+    std::string all(offsets[cf.numProcs-1]+lens[cf.numProcs-1],'\n');
+    MPI_Allgatherv(mine.data(), len, MPI_CHAR, all.data(), lens.data(), offsets.data(), MPI_CHAR, cf.comm);
+    size_t start = 0;
+    for (size_t end = all.find('\n'); end != std::string::npos; end = all.find('\n',start)){
+      if (end > start)
+        names.insert(all.substr(start,end-start));
+      start = end+1;
+    }
+#endif
+    return std::vector<std::string>(names.begin(),names.end());
+  }
+}
+
+void Memory::track(){
+  Kokkos::Tools::Experimental::set_allocate_data_callback(allocateData);
+  Kokkos::Tools::Experimental::set_deallocate_data_callback(deallocateData);
+}
+
+void Memory::report(struct inputConfig &cf, std::string when){
+  std::map<std::string, usage> spaces;
+  std::vector<std::pair<std::pair<std::string,std::string>, usage>> labels;
+  {
+    ledger &l = book();
+    std::lock_guard<std::mutex> guard(l.lock);
+    spaces = l.spaces;
+    labels.assign(l.labels.begin(),l.labels.end());
+  }
+  std::vector<std::string> names = allSpaces(cf,spaces);
+
+  // current and high-water bytes of each space, summed and largest over ranks
+  size_t ns = names.size();
+  std::vector<uint64_t> local(2*ns), total(2*ns), largest(2*ns);
+  for (size_t s = 0; s < ns; ++s){
+    local[2*s]   = spaces[names[s]].bytes;
+    local[2*s+1] = spaces[names[s]].peak;
+  }
+  total = local;
+  largest = local;
+#ifdef HAVE_MPI
+  MPI_Allreduce(local.data(), total.data(), 2*ns, MPI_UINT64_T, MPI_SUM, cf.comm);
+  MPI_Allreduce(local.data(), largest.data(), 2*ns, MPI_UINT64_T, MPI_MAX, cf.comm);
+#endif
+
+  Log::message("Reporting memory usage at {}:",when);
+  for (size_t s = 0; s < ns; ++s)
+    Log::infoAll("{} memory: {} allocated, {} high-water",names[s],size(local[2*s]),size(local[2*s+1]));
+
+  std::sort(labels.begin(), labels.end(), [](auto &a, auto &b){ return a.second.peak > b.second.peak; });
+  if (labels.size() > 10)
+    labels.resize(10);
+
+  if (cf.rank == 0){
+    using fmt::format;
+    ansiColors c(cf.colorFlag);
+
+    std::string rowFormat = format("{: >8}{{}}{{: <32}}{{: >14}}{{: >14}}{{: >14}}{}\n","",c(reset));
+    std::cout << format(rowFormat,c(green),"Memory Space","Allocated","High-Water","Largest Rank");
+    for (size_t s = 0; s < ns; ++s)
+      std::cout << format(rowFormat,c(reset),names[s],size(total[2*s]),size(total[2*s+1]),size(largest[2*s+1]));
+    std::cout << "\n";
+
+    std::cout << format(rowFormat,c(green),"Largest Allocations on Rank 0","Allocated","High-Water","Views");
+    for (auto& l : labels){
+      std::string label = l.first.second.empty() ? "(unlabeled)" : l.first.second;
+      std::cout << format(rowFormat,c(reset),format("{} ({})",label,l.first.first),
+                          size(l.second.bytes),size(l.second.peak),l.second.count);
+    }
+    std::cout << std::flush;
+  }
+}
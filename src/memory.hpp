@@ -0,0 +1,41 @@
+/*
+  Copyright 2019-2021 The University of New Mexico
+
+  This file is part of FIESTA.
+  
+  FIESTA is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+  
+  FIESTA is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+  
+  You should have received a copy of the GNU Lesser General Public License
+  along with FIESTA.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef MEMORY_HPP
+#define MEMORY_HPP
+
+#include "input.hpp"
+#include <string>
+
+// Accounting of every Kokkos view allocation, device arrays and host mirrors
+// alike, by memory space and label.  Allocations are tracked through the
+// Kokkos Tools allocation callbacks, so the totals follow the views that are
+// actually allocated rather than an estimate.  Installing the callbacks
+// replaces those of any Kokkos tool loaded through KOKKOS_PROFILE_LIBRARY, so
+// tracking is only enabled with --memory or --dry-run.
+namespace Memory {
+  // install the allocation callbacks, after Kokkos is initialized
+  void track();
+
+  // report current and high-water usage on each rank and all ranks, and the
+  // largest allocations on this rank
+  void report(struct inputConfig &cf, std::string when);
+}
+
+#endif
@@ -21,6 +21,7 @@
 #include "debug.hpp"
 #include <type_traits>
 #include "log2.hpp"
+#include "trace.hpp"
 #include "kokkosTypes.hpp"
 
 #define FIESTA_FORWARD_TAG 1
@@ -181,7 +182,9 @@ void mpiHaloExchange::haloExchange(){
 
   // Wait for the sends and receives to finish
   Kokkos::Profiling::pushRegion("mpi::haloExchange::waitall");
+  Trace::begin("MPI Halo Wait");
   MPI_Waitall(12, reqs, MPI_STATUSES_IGNORE);
+  Trace::end();
   Kokkos::Profiling::popRegion(); // mpi::haloExchange::waitall
 
   Kokkos::Profiling::pushRegion("mpi::haloExchange::unpackHalo");
@@ -529,7 +532,9 @@ void orderedHaloExchange::haloExchange(){
   MPI_Irecv(rightRecv.data(), buffSize, MPI_FSCAL, cf.xPlus,  FIESTA_BACKWARD_TAG, cf.comm, &reqs[waitCount++]);
   MPI_Isend(leftSend.data(),  buffSize, MPI_FSCAL, cf.xMinus, FIESTA_BACKWARD_TAG, cf.comm, &reqs[waitCount++]);
   MPI_Isend(rightSend.data(), buffSize, MPI_FSCAL, cf.xPlus,  FIESTA_FORWARD_TAG,  cf.comm, &reqs[waitCount++]);
+  Trace::begin("MPI Halo Wait");
   MPI_Waitall(waitCount, reqs, MPI_STATUSES_IGNORE);
+  Trace::end();
 
   unpackFace({-1,0,0},deviceV,leftRecv);
   unpackFace({+1,0,0},deviceV,rightRecv);
@@ -546,7 +551,9 @@ void orderedHaloExchange::haloExchange(){
   MPI_Irecv(topRecv.data(),    buffSize, MPI_FSCAL, cf.yPlus,  FIESTA_BACKWARD_TAG, cf.comm, &reqs[waitCount++]);
   MPI_Isend(bottomSend.data(), buffSize, MPI_FSCAL, cf.yMinus, FIESTA_BACKWARD_TAG, cf.comm, &reqs[waitCount++]);
   MPI_Isend(topSend.data(),    buffSize, MPI_FSCAL, cf.yPlus,  FIESTA_FORWARD_TAG,  cf.comm, &reqs[waitCount++]);
+  Trace::begin("MPI Halo Wait");
   MPI_Waitall(waitCount, reqs, MPI_STATUSES_IGNORE);
+  Trace::end();
 
   unpackFace({0,-1,0},deviceV,bottomRecv);
   unpackFace({0,+1,0},deviceV,topRecv);
@@ -564,7 +571,9 @@ void orderedHaloExchange::haloExchange(){
     MPI_Irecv(frontRecv.data(), buffSize, MPI_FSCAL, cf.zPlus,  FIESTA_BACKWARD_TAG, cf.comm, &reqs[waitCount++]);
     MPI_Isend(backSend.data(),  buffSize, MPI_FSCAL, cf.zMinus, FIESTA_BACKWARD_TAG, cf.comm, &reqs[waitCount++]);
     MPI_Isend(frontSend.data(), buffSize, MPI_FSCAL, cf.zPlus,  FIESTA_FORWARD_TAG,  cf.comm, &reqs[waitCount++]);
+    Trace::begin("MPI Halo Wait");
     MPI_Waitall(waitCount, reqs, MPI_STATUSES_IGNORE);
+    Trace::end();
 
     unpackFace({0,0,-1},deviceV,backRecv);
     unpackFace({0,0,+1},deviceV,frontRecv);
@@ -638,7 +647,9 @@ void unorderedHaloExchange::haloExchange(){
     }
   }
 
+  Trace::begin("MPI Halo Wait");
   MPI_Waitall(waitCount, reqs, MPI_STATUSES_IGNORE);
+  Trace::end();
   //MPI_Status stat[52];
   //MPI_Waitall(waitCount, reqs, stat);
   //for (int i=0; i<52; ++i)
@@ -705,7 +716,9 @@ void orderedHostHaloExchange::haloExchange(){
   MPI_Irecv(rightRecv_H.data(), buffSize, MPI_FSCAL, cf.xPlus,  FIESTA_BACKWARD_TAG, cf.comm, &reqs[waitCount++]);
   MPI_Isend(leftSend_H.data(),  buffSize, MPI_FSCAL, cf.xMinus, FIESTA_BACKWARD_TAG, cf.comm, &reqs[waitCount++]);
   MPI_Isend(rightSend_H.data(), buffSize, MPI_FSCAL, cf.xPlus,  FIESTA_FORWARD_TAG,  cf.comm, &reqs[waitCount++]);
+  Trace::begin("MPI Halo Wait");
   MPI_Waitall(waitCount, reqs, MPI_STATUSES_IGNORE);
+  Trace::end();
 
   Kokkos::deep_copy(leftRecv, leftRecv_H);
   Kokkos::deep_copy(rightRecv, rightRecv_H);
@@ -726,7 +739,9 @@ void orderedHostHaloExchange::haloExchange(){
   MPI_Irecv(topRecv_H.data(),    buffSize, MPI_FSCAL, cf.yPlus,  FIESTA_BACKWARD_TAG, cf.comm, &reqs[waitCount++]);
   MPI_Isend(bottomSend_H.data(), buffSize, MPI_FSCAL, cf.yMinus, FIESTA_BACKWARD_TAG, cf.comm, &reqs[waitCount++]);
   MPI_Isend(topSend_H.data(),    buffSize, MPI_FSCAL, cf.yPlus,  FIESTA_FORWARD_TAG,  cf.comm, &reqs[waitCount++]);
+  Trace::begin("MPI Halo Wait");
   MPI_Waitall(waitCount, reqs, MPI_STATUSES_IGNORE);
+  Trace::end();
 
   Kokkos::deep_copy(bottomRecv, bottomRecv_H);
   Kokkos::deep_copy(topRecv, topRecv_H);
@@ -748,7 +763,9 @@ void orderedHostHaloExchange::haloExchange(){
     MPI_Irecv(frontRecv_H.data(), buffSize, MPI_FSCAL, cf.zPlus,  FIESTA_BACKWARD_TAG, cf.comm, &reqs[waitCount++]);
     MPI_Isend(backSend_H.data(),  buffSize, MPI_FSCAL, cf.zMinus, FIESTA_BACKWARD_TAG, cf.comm, &reqs[waitCount++]);
     MPI_Isend(frontSend_H.data(), buffSize, MPI_FSCAL, cf.zPlus,  FIESTA_FORWARD_TAG,  cf.comm, &reqs[waitCount++]);
+    Trace::begin("MPI Halo Wait");
     MPI_Waitall(waitCount, reqs, MPI_STATUSES_IGNORE);
+    Trace::end();
 
     Kokkos::deep_copy(backRecv, backRecv_H);
     Kokkos::deep_copy(frontRecv, frontRecv_H);
@@ -20,6 +20,7 @@
 #include "output.hpp"
 #include "Kokkos_Core.hpp"
 #include "input.hpp"
+#include "h5.hpp"
 #include "unistd.h"
 #include <cstdio>
 #include <iomanip>
@@ -85,10 +86,27 @@ void printConfig(struct inputConfig cf) {
   
     if (cf.restart_freq > 0) cout << format(keyValue,"Restart frequency:",cf.restart_freq);
     else cout << format(keyDisabled,"Restart writes:");
+
+    if (cf.checkpoint_freq > 0){
+      cout << format(keyValue,"Checkpoint frequency:",cf.checkpoint_freq);
+      cout << format(keyString,"Checkpoint Path:",cf.checkpointPath);
+    }else{
+      cout << format(keyDisabled,"Checkpoints:");
+    }
+
+    if (cf.rollback_freq > 0){
+      cout << format(keyValue,"Health Check Frequency:",cf.rollback_freq);
+      cout << format(keyPair,"Rollback Snapshots:",cf.snapshots,cf.snapshot_freq);
+    }else{
+      cout << format(keyDisabled,"Rollback:");
+    }
   
     if (cf.stat_freq > 0) cout << format(keyValue,"Status frequency:",cf.stat_freq);
     else cout << format(keyDisabled,"Status reports:");
 
+    if (cf.traceSteps > 0) cout << format(keyValue,"Traced steps:",cf.traceSteps);
+    else cout << format(keyDisabled,"Trace:");
+
 #ifdef HAVE_SINGLE
     cout << format(keyString,"Precision:","single");
 #else
@@ -105,7 +123,11 @@ void printConfig(struct inputConfig cf) {
 
     if (cf.ndim==3){
       cout << format(keyTupleInt,"Number of Cells:",cf.glbl_nci,cf.glbl_ncj,cf.glbl_nck);
-      cout << format(keyTupleGen,"Cell Size:",cf.dx,cf.dy,cf.dz);
+      if (cf.grid == 3)
+        cout << format(keyTupleGen,"Minimum Cell Size:",cf.dx,cf.dy,cf.dz);
+      else
+        cout << format(keyTupleGen,"Cell Size:",cf.dx,cf.dy,cf.dz);
+      if (cf.grid == 2) cout << format(keyString,"Terrain:",cf.terrainName);
     }else{
       cout << format(keyPair,"Number of Cells:",cf.glbl_nci,cf.glbl_ncj);
       cout << format(keyPair,"Cell Size:",cf.dx,cf.dy);
@@ -135,6 +157,17 @@ void printConfig(struct inputConfig cf) {
 
     if (cf.compressible) cout << format(keyYes,"HDF5 Compression:");
     else cout << format(keyDisabled,"HDF5 Compression:");
+
+    if (cf.asyncIO) cout << format(keyEnabled,"Asynchronous Writes:");
+    else cout << format(keyDisabled,"Asynchronous Writes:");
+
+    cout << format(keyValue,"HDF5 Layout:",cf.h5Layout);
+
+    string tuning = h5Settings().summary();
+    if (!tuning.empty()) cout << format(keyString,"HDF5 Tuning:",tuning);
+
+    if (cf.initCache) cout << format(keyEnabled,"IC Cache:");
+    else cout << format(keyDisabled,"IC Cache:");
   
     cout << format(keyValue,"Number of species:",cf.ns);
     string val = format("{}{{}}{}",k(magenta),k(reset));
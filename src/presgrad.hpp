@@ -19,6 +19,9 @@
 
 #ifndef presgrad_H
 #define presgrad_H
+
+#include "rectilinear.hpp"
+
 struct applyPressureGradient2D {
   FS4D dvar;
   FS2D p;
@@ -69,6 +72,27 @@ struct applyPressureGradient3D {
 
   }
 };
+// fourth order pressure gradient on a rectilinear grid, the index space
+// difference divided by the matching difference of the cell centers
+struct applyRectPressureGradient3D {
+  FS4D dvar;
+  FS3D p;
+  rectGrid rg;
+
+  applyRectPressureGradient3D(FS4D dvar_, FS3D p_, rectGrid rg_)
+      : dvar(dvar_), p(p_), rg(rg_) {}
+
+  KOKKOS_INLINE_FUNCTION
+  void operator()(const int i, const int j, const int k) const {
+    FSCAL dxp = (p(i-2,j,k) - 8.0*p(i-1,j,k) + 8.0*p(i+1,j,k) - p(i+2,j,k))/(12.0*rg.metric(0,i));
+    FSCAL dyp = (p(i,j-2,k) - 8.0*p(i,j-1,k) + 8.0*p(i,j+1,k) - p(i,j+2,k))/(12.0*rg.metric(1,j));
+    FSCAL dzp = (p(i,j,k-2) - 8.0*p(i,j,k-1) + 8.0*p(i,j,k+1) - p(i,j,k+2))/(12.0*rg.metric(2,k));
+
+    dvar(i, j, k, 0) = dvar(i, j, k, 0) - dxp;
+    dvar(i, j, k, 1) = dvar(i, j, k, 1) - dyp;
+    dvar(i, j, k, 2) = dvar(i, j, k, 2) - dzp;
+  }
+};
 struct applyGenPressureGradient3D {
 
   FS4D dvar;
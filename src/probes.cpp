@@ -0,0 +1,390 @@
+/*
+  Copyright 2019-2021 The University of New Mexico
+
+  This file is part of FIESTA.
+  
+  FIESTA is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+  
+  FIESTA is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+  
+  You should have received a copy of the GNU Lesser General Public License
+  along with FIESTA.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "probes.hpp"
+#include "input.hpp"
+#include "h5.hpp"
+#include "iothread.hpp"
+#include "log2.hpp"
+#include "fmt/core.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+
+using fmt::format;
+
+// Interpolate every field at every probe from the 4 or 8 cells of its stencil
+struct probeSample {
+  FS4D var, varx;
+  FS2D_I cell;
+  FS2D wgt;
+  FS1D_I src, idx;
+  probeGroup::probeBuffer buf;
+  int row, ndim;
+
+  probeSample(FS4D var_, FS4D varx_, FS2D_I cell_, FS2D wgt_, FS1D_I src_, FS1D_I idx_,
+              probeGroup::probeBuffer buf_, int row_, int ndim_)
+      : var(var_), varx(varx_), cell(cell_), wgt(wgt_), src(src_), idx(idx_), buf(buf_), row(row_), ndim(ndim_) {}
+
+  KOKKOS_INLINE_FUNCTION
+  void operator()(const int p, const int f) const {
+    int nk = (ndim == 3) ? 2 : 1;
+    FSCAL sum = 0.0;
+
+    for (int di = 0; di < 2; ++di) {
+      for (int dj = 0; dj < 2; ++dj) {
+        for (int dk = 0; dk < nk; ++dk) {
+          FSCAL w = (di ? wgt(p, 0) : 1.0 - wgt(p, 0)) * (dj ? wgt(p, 1) : 1.0 - wgt(p, 1));
+          if (ndim == 3) w *= (dk ? wgt(p, 2) : 1.0 - wgt(p, 2));
+
+          int i = cell(p, 0) + di;
+          int j = cell(p, 1) + dj;
+          int k = cell(p, 2) + dk;
+          sum += w * ((src(f) == 0) ? var(i, j, k, idx(f)) : varx(i, j, k, idx(f)));
+        }
+      }
+    }
+    buf(f, row, p) = sum;
+  }
+};
+
+probeGroup::probeGroup(struct inputConfig &cf, std::unique_ptr<class rk_func>&f, std::string name_, std::string path_,
+                       int frequency_, int capacity_, std::vector<std::string> fields_,
+                       std::vector<std::array<FSCAL,3>> points)
+  : name(name_), frequency(frequency_), needVarx(false), path(path_), fields(fields_),
+    capacity(capacity_), written(-1), owner(false), async(cf.asyncIO) {
+
+  if (cf.grid != 0){
+    Log::error("Probe group '{}' requires a cartesian grid.",name);
+    exit(EXIT_FAILURE);
+  }
+  if (frequency < 1 || capacity < 1){
+    Log::error("Frequency and buffer size of probe group '{}' must be positive.",name);
+    exit(EXIT_FAILURE);
+  }
+  if (points.empty()){
+    Log::error("Probe group '{}' has no points.",name);
+    exit(EXIT_FAILURE);
+  }
+
+  fname = format("{}/{}.h5",path,name);
+  nf = fields.size();
+  npts = points.size();
+
+  // Probes belong to the rank holding the cell that contains them.  The
+  // stencil is kept inside that rank's cells, so a probe within half a cell of
+  // a subdomain edge is extrapolated from the two nearest cells instead of
+  // reading ghost cells, which are not current after the last stage.
+  FSCAL h[3] = {cf.dx, cf.dy, cf.dz};
+  std::vector<size_t> glbl = cf.globalCellDims;
+  std::vector<size_t> mine;
+  std::vector<std::array<int,3>> cellV;
+  std::vector<std::array<FSCAL,3>> wgtV;
+
+  for (size_t p = 0; p < npts; ++p){
+    bool inside = true;
+    bool local = true;
+    std::array<int,3> c = {0, 0, 0};
+    std::array<FSCAL,3> w = {0.0, 0.0, 0.0};
+
+    for (int d = 0; d < cf.ndim; ++d){
+      FSCAL x = points[p][d];
+      inside &= (x >= 0.0 && x <= glbl[d]*h[d]);
+
+      long gc = std::clamp((long)std::floor(x/h[d]), 0L, (long)glbl[d]-1);
+      long off = cf.subdomainOffset[d];
+      long n = cf.localCellDims[d];
+      local &= (gc >= off && gc < off+n);
+
+      FSCAL fi = x/h[d] - 0.5 - off;
+      long i0 = std::clamp((long)std::floor(fi), 0L, std::max(n-2, 0L));
+      c[d] = i0 + cf.ng;
+      w[d] = (n > 1) ? fi - i0 : 0.0;
+    }
+
+    if (!inside){
+      Log::error("Point {} of probe group '{}' is outside the domain.",p+1,name);
+      exit(EXIT_FAILURE);
+    }
+
+    if (local){
+      mine.push_back(p);
+      cellV.push_back(c);
+      wgtV.push_back(w);
+    }
+  }
+
+  nloc = mine.size();
+  owner = nloc > 0;
+  colOffset = 0;
+
+  src = FS1D_I("probe_src", nf);
+  idx = FS1D_I("probe_idx", nf);
+  auto srcH = Kokkos::create_mirror_view(src);
+  auto idxH = Kokkos::create_mirror_view(idx);
+  for (int fi = 0; fi < nf; ++fi){
+    if (!f->findField(fields[fi], srcH(fi), idxH(fi))){
+      Log::error("Probe group '{}' requests unknown field '{}'.",name,fields[fi]);
+      exit(EXIT_FAILURE);
+    }
+    needVarx |= (srcH(fi) == 1);
+  }
+  Kokkos::deep_copy(src, srcH);
+  Kokkos::deep_copy(idx, idxH);
+
+  cell = FS2D_I("probe_cell", nloc, 3);
+  wgt = FS2D("probe_wgt", nloc, 3);
+  auto cellH = Kokkos::create_mirror_view(cell);
+  auto wgtH = Kokkos::create_mirror_view(wgt);
+  for (size_t p = 0; p < nloc; ++p){
+    for (int d = 0; d < 3; ++d){
+      cellH(p, d) = cellV[p][d];
+      wgtH(p, d) = wgtV[p][d];
+    }
+  }
+  Kokkos::deep_copy(cell, cellH);
+  Kokkos::deep_copy(wgt, wgtH);
+
+  buf = probeBuffer("probe_buf", nf, capacity, nloc);
+  bufH = Kokkos::create_mirror_view(buf);
+  steps.reserve(capacity);
+  times.reserve(capacity);
+
+#ifdef HAVE_MPI
+  MPI_Comm_split(cf.comm, owner ? 1 : MPI_UNDEFINED, cf.rank, &ownerComm);
+  ownerRank = MPI_PROC_NULL;
+  if (owner){
+    unsigned long mycols = nloc, offset = 0;
+    MPI_Comm_rank(ownerComm, &ownerRank);
+    MPI_Exscan(&mycols, &offset, 1, MPI_UNSIGNED_LONG, MPI_SUM, ownerComm);
+    if (ownerRank > 0) colOffset = offset;
+  }
+#endif
+
+  if (cf.rank == 0 && !cf.dryRun){
+    if (!std::filesystem::exists(path)){
+      Log::message("Creating directory: '{}'",path);
+      std::filesystem::create_directories(path);
+    }
+  }
+#ifdef HAVE_MPI
+  MPI_Barrier(cf.comm);
+#endif
+
+  // the locations and probe numbers of this rank's columns
+  std::vector<double> coords(3*nloc), index(nloc);
+  for (size_t p = 0; p < nloc; ++p){
+    index[p] = mine[p];
+    for (int d = 0; d < 3; ++d)
+      coords[d*nloc + p] = (d < cf.ndim) ? points[mine[p]][d] : 0.0;
+  }
+
+  // continue an existing file when restarting, otherwise start a new one
+  int status = 0;
+  if (owner && !cf.dryRun)
+    status = cf.restart ? reopen(cf, coords, index) : 1;
+#ifdef HAVE_MPI
+  MPI_Allreduce(MPI_IN_PLACE, &status, 1, MPI_INT, MPI_MAX, cf.comm);
+#endif
+  if (status == 2)
+    Log::warning("Probe file '{}' does not match probe group '{}' and was moved to '{}.old'.",fname,name,fname);
+
+  if (owner && status > 0)
+    create(coords, index);
+
+  Log::message("Probe group '{}': {} probes, {} fields, {} samples per write",name,npts,nf,capacity);
+}
+
+probeGroup::~probeGroup(){
+  if (inflight.valid()) inflight.wait();
+#ifdef HAVE_MPI
+  if (ownerComm != MPI_COMM_NULL) MPI_Comm_free(&ownerComm);
+#endif
+}
+
+// Create the file with the probe locations and empty series
+void probeGroup::create(std::vector<double>& coords, std::vector<double>& index){
+  h5Writer<double> writer;
+#ifdef HAVE_MPI
+  writer.open(ownerComm, MPI_INFO_NULL, fname);
+#else
+  writer.open(fname);
+#endif
+
+  writer.createSeries("Coordinates", npts, 3);
+  writer.appendSeries("Coordinates", 3, colOffset, nloc, coords.data());
+  writer.createSeries("Index", npts, 1);
+  writer.appendSeries("Index", 1, colOffset, nloc, index.data());
+  writer.createSeries("Step", 1, capacity);
+  writer.createSeries("Time", 1, capacity);
+  for (auto& field : fields)
+    writer.createSeries(field, npts, capacity);
+
+  writer.close();
+}
+
+// Check that an existing file matches this group and drop its samples from
+// the restart step on.  The columns of the file must hold the same probes at
+// the same locations as this run, which changes with the decomposition.
+// Returns 0 if the file can be continued, 1 if there is no file and 2 if it
+// did not match and was moved aside.
+int probeGroup::reopen(struct inputConfig &cf, std::vector<double>& coords, std::vector<double>& index){
+  if (!std::filesystem::exists(fname)) return 1;
+
+  h5Writer<double> writer;
+#ifdef HAVE_MPI
+  writer.openAppend(ownerComm, MPI_INFO_NULL, fname);
+#else
+  writer.openAppend(fname);
+#endif
+  int match = writer.hasDataset("Coordinates") && writer.hasDataset("Index")
+           && writer.hasDataset("Step") && writer.hasDataset("Time");
+  for (auto& field : fields)
+    match = match && writer.hasDataset(field);
+  if (match)
+    match = writer.seriesDims("Coordinates") == std::vector<size_t>{3, npts}
+         && writer.seriesDims("Index") == std::vector<size_t>{1, npts};
+  if (match){
+    std::vector<double> fileCoords(3*npts), fileIndex(npts);
+    writer.readSeries("Coordinates", fileCoords.data());
+    writer.readSeries("Index", fileIndex.data());
+    for (size_t p = 0; p < nloc; ++p){
+      match = match && fileIndex[colOffset + p] == index[p];
+      for (int d = 0; d < 3; ++d)
+        match = match && fileCoords[d*npts + colOffset + p] == coords[d*nloc + p];
+    }
+  }
+  writer.close();
+#ifdef HAVE_MPI
+  MPI_Allreduce(MPI_IN_PLACE, &match, 1, MPI_INT, MPI_MIN, ownerComm);
+#endif
+
+  if (!match){
+#ifdef HAVE_MPI
+    if (ownerRank == 0)
+      std::filesystem::rename(fname, fname + ".old");
+    MPI_Barrier(ownerComm);
+#else
+    std::filesystem::rename(fname, fname + ".old");
+#endif
+    return 2;
+  }
+
+  trim(cf.tstart);
+  written = cf.tstart - 1;
+  return 0;
+}
+
+// Drop the rows of the file from the given step on
+void probeGroup::trim(int step){
+  h5Writer<double> writer;
+#ifdef HAVE_MPI
+  writer.openAppend(ownerComm, MPI_INFO_NULL, fname);
+#else
+  writer.openAppend(fname);
+#endif
+
+  size_t n = writer.seriesDims("Step")[0];
+  std::vector<double> fileSteps(n);
+  if (n > 0)
+    writer.readSeries("Step", fileSteps.data());
+  size_t keep = std::lower_bound(fileSteps.begin(), fileSteps.end(), (double)step) - fileSteps.begin();
+
+  if (keep < n){
+    writer.resizeSeries("Step", keep);
+    writer.resizeSeries("Time", keep);
+    for (auto& field : fields)
+      writer.resizeSeries(field, keep);
+  }
+  writer.close();
+}
+
+void probeGroup::sample(struct inputConfig &cf, std::unique_ptr<class rk_func>&f, int t, FSCAL time){
+  if (owner)
+    Kokkos::parallel_for(policy_f({0, 0}, {(int)nloc, nf}),
+                         probeSample(f->var, f->varx, cell, wgt, src, idx, buf, steps.size(), cf.ndim));
+
+  steps.push_back(t);
+  times.push_back(time);
+  if ((int)steps.size() == capacity)
+    flush();
+}
+
+// Append the buffered samples to the file
+void probeGroup::flush(){
+  if (steps.empty()) return;
+
+  if (owner){
+    // the previous write must finish before the host buffer is reused
+    if (inflight.valid())
+      inflight.wait();
+    Kokkos::deep_copy(bufH, buf);
+
+    size_t n = steps.size();
+    if (async)
+      inflight = ioThread::instance().push([this,n,s=steps,tm=times](){ writeRows(n,s,tm); });
+    else
+      writeRows(n,steps,times);
+  }
+
+  written = steps.back();
+  steps.clear();
+  times.clear();
+}
+
+void probeGroup::writeRows(size_t n, std::vector<double> stepV, std::vector<double> timeV){
+#ifdef HAVE_MPI
+  size_t stepCols = (ownerRank == 0) ? 1 : 0;
+#else
+  size_t stepCols = 1;
+#endif
+
+  h5Writer<double> writer;
+#ifdef HAVE_MPI
+  writer.openAppend(ownerComm, MPI_INFO_NULL, fname);
+#else
+  writer.openAppend(fname);
+#endif
+
+  writer.appendSeries("Step", n, 0, stepCols, stepV.data());
+  writer.appendSeries("Time", n, 0, stepCols, timeV.data());
+  for (int fi = 0; fi < nf; ++fi)
+    writer.appendSeries(fields[fi], n, colOffset, nloc, bufH.data() + fi*capacity*nloc);
+
+  writer.close();
+}
+
+// Forget samples after the given step, once the solution was rolled back to it
+void probeGroup::rewind(int step){
+  while (!steps.empty() && steps.back() > step){
+    steps.pop_back();
+    times.pop_back();
+  }
+
+  if (written > step){
+    // queue the trim behind pending writes so HDF5 is only used from one thread
+    if (owner){
+      if (async)
+        inflight = ioThread::instance().push([this,step](){ trim(step+1); });
+      else
+        trim(step+1);
+    }
+    written = step;
+  }
+}
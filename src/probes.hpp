@@ -0,0 +1,86 @@
+/*
+  Copyright 2019-2021 The University of New Mexico
+
+  This file is part of FIESTA.
+  
+  FIESTA is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+  
+  FIESTA is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+  
+  You should have received a copy of the GNU Lesser General Public License
+  along with FIESTA.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef PROBES_H
+#define PROBES_H
+
+#include "kokkosTypes.hpp"
+#include "rkfunction.hpp"
+#ifdef HAVE_MPI
+#include "mpi.h"
+#endif
+#include <array>
+#include <future>
+#include <string>
+#include <vector>
+
+// A group of point probes sampled on the device and written as time series.
+// Each probe is interpolated from the cells of the rank whose subdomain
+// contains it, and samples are buffered on the device until the buffer fills,
+// when they are appended to one extendable dataset per field.  Only ranks
+// that own probes take part in the writes.
+class probeGroup {
+  public:
+    typedef Kokkos::View<double ***, Kokkos::LayoutRight> probeBuffer;
+
+    probeGroup(struct inputConfig&, std::unique_ptr<class rk_func>&, std::string, std::string, int, int,
+               std::vector<std::string>, std::vector<std::array<FSCAL,3>>);
+    ~probeGroup();
+
+    void sample(struct inputConfig&, std::unique_ptr<class rk_func>&, int, FSCAL);
+    void flush();
+    void rewind(int);
+
+    std::string name;
+    int frequency;   // steps between samples
+    bool needVarx;   // a field comes from varx
+
+  private:
+    void create(std::vector<double>&, std::vector<double>&);
+    int reopen(struct inputConfig&, std::vector<double>&, std::vector<double>&);
+    void writeRows(size_t, std::vector<double>, std::vector<double>);
+    void trim(int);
+
+    std::string path;
+    std::string fname;
+    std::vector<std::string> fields;
+    int nf;
+    size_t npts;       // probes in the group
+    size_t nloc;       // probes owned by this rank
+    size_t colOffset;  // first column owned by this rank
+    int capacity;      // rows held in the buffer
+    int written;       // last step in the file
+    bool owner;
+#ifdef HAVE_MPI
+    MPI_Comm ownerComm;
+    int ownerRank;
+#endif
+
+    FS2D_I cell;       // lower stencil cell of each probe
+    FS2D wgt;          // interpolation weights
+    FS1D_I src;        // 0 for var, 1 for varx
+    FS1D_I idx;        // index in the source view
+    probeBuffer buf;   // field, row, probe
+    probeBuffer::HostMirror bufH;
+    std::vector<double> steps, times;  // buffered rows
+    std::shared_future<void> inflight;
+    bool async;
+};
+
+#endif
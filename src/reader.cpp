@@ -29,62 +29,130 @@
 #include <filesystem>
 #include "fiesta.hpp"
 #include <fmt/core.h>
+#include "staging.hpp"
+#include "checkpoint.hpp"
+#include "stats.hpp"
 
-void readRestart(struct inputConfig &cf, std::unique_ptr<class rk_func>&f) {
-  if (cf.rank==0){
-    if (!std::filesystem::exists(cf.restartName)){
-      Log::error("Restart file '{}' does not exist.",cf.restartName);
-      exit(EXIT_FAILURE);
-    }
+// Scatter fields read from a restart file, stored back to back with i fastest,
+// into the interior of a view.
+struct unpackRestart {
+  FS4D dst;
+  Kokkos::View<FSCAL*, Kokkos::MemoryUnmanaged> src;
+  size_t offset;
+  int nv;
+  int ng, ngk;   // ghost offset
+  int ei, ej, ek; // extent of each field
+
+  unpackRestart(FS4D dst_, Kokkos::View<FSCAL*, Kokkos::MemoryUnmanaged> src_, size_t offset_, int nv_,
+                int ng_, int ngk_, int ei_, int ej_, int ek_)
+    : dst(dst_), src(src_), offset(offset_), nv(nv_), ng(ng_), ngk(ngk_), ei(ei_), ej(ej_), ek(ek_) {}
+
+  KOKKOS_INLINE_FUNCTION
+  void operator()(const int i, const int j, const int k) const {
+    size_t idx = offset + (size_t)ei*ej*k + (size_t)ei*j + i;
+    size_t n = (size_t)ei*ej*ek;
+    for (int v=0; v<nv; ++v)
+      dst(i+ng, j+ng, k+ngk, v) = src(idx + n*v);
   }
+};
 
-  h5Writer<FSCAL> writer;
-  writer.openRead(cf.restartName);
+// Apply the time index and time of a restart unless a reset was requested
+static void setRestartTime(struct inputConfig &cf, int tstart, FSCAL time){
+  if(cf.restartReset==false){
+    cf.tstart=tstart;
+    cf.time=time;
+  }else{
+    Log::message("Restart reset enabled, using index and time from input file.");
+  }
 
-  size_t idx;
-  std::string path;
+  if(cf.tinterval){
+    cf.tend=cf.tstart+cf.nt;
+  }else{
+    cf.nt=cf.tend-cf.tstart;
+  }
+  cf.t=cf.tstart;
+  Log::message("Restart Properties: t={} time={:.2g}",cf.tstart,cf.time);
+}
 
-  auto readV = (FSCAL *)malloc(cf.ni * cf.nj * cf.nk * sizeof(FSCAL));
-  auto varH = Kokkos::create_mirror_view(f->var);
+// Read the solution, and the grid if requested, from a restart format file.
+// Every field is read into one compact, field major buffer and unpacked on
+// the device, so only one host to device copy is needed.
+static void readFields(struct inputConfig &cf, std::unique_ptr<class rk_func>&f, h5Writer<FSCAL>& writer, bool grid){
+  size_t nCells = cf.nci*cf.ncj*cf.nck;
+  size_t nNodes = cf.ni*cf.nj*cf.nk;
+  size_t nVar = cf.nvt*nCells;
+  size_t nGrid = grid ? cf.ndim*nNodes : 0;
+
+  int lease = cf.staging->acquire((nVar+nGrid)*sizeof(FSCAL));
+  auto readH = cf.staging->host<FSCAL>(lease, nVar+nGrid);
+  auto readD = cf.staging->device<FSCAL>(nVar+nGrid);
+
+  // read cell data
+  std::vector<std::string> paths;
+  for (int v=0; v<cf.nvt; ++v)
+    paths.push_back(fmt::format("/Solution/{}",f->varNames[v]));
+  writer.readFields(paths, cf.ndim, cf.globalCellDims, cf.localCellDims, cf.subdomainOffset, readH.data());
 
   // read grid
-  if (cf.grid==1){
-    auto gridH = Kokkos::create_mirror_view(f->grid);
-    for (int v=0; v<cf.ndim; ++v){
-      path = fmt::format("/Grid/Dimension{}",v);
-      writer.read(path, cf.ndim, cf.globalGridDims, cf.localGridDims, cf.subdomainOffset, readV);
-      for (int i = 0; i < cf.ni; ++i) {
-        for (int j = 0; j < cf.nj; ++j) {
-          for (int k = 0; k < cf.nk; ++k) {
-            idx = (cf.ni * cf.nj) * k + cf.ni * j + i;
-            gridH(i, j, k, v) = readV[idx];
-          }
-        }
-      }
+  if (grid){
+    paths.clear();
+    for (int v=0; v<cf.ndim; ++v)
+      paths.push_back(fmt::format("/Grid/Dimension{}",v));
+    writer.readFields(paths, cf.ndim, cf.globalGridDims, cf.localGridDims, cf.subdomainOffset, readH.data()+nVar);
+  }
+
+  Kokkos::deep_copy(readD,readH);
+
+  int koffset = (cf.ndim == 3) ? cf.ng : 0;
+  policy_f3 cell_pol = policy_f3({0,0,0},{cf.nci,cf.ncj,cf.nck});
+  Kokkos::parallel_for(cell_pol, unpackRestart(f->var, readD, 0, cf.nvt, cf.ng, koffset, cf.nci, cf.ncj, cf.nck));
+  if (grid){
+    policy_f3 node_pol = policy_f3({0,0,0},{cf.ni,cf.nj,cf.nk});
+    Kokkos::parallel_for(node_pol, unpackRestart(f->grid, readD, nVar, cf.ndim, 0, 0, cf.ni, cf.nj, cf.nk));
+  }
+  Kokkos::fence();
+  cf.staging->release(lease);
+}
+
+void readRestart(struct inputConfig &cf, std::unique_ptr<class rk_func>&f) {
+  int tstart;
+  FSCAL time;
+
+  // a node-local checkpoint newer than the restart file takes precedence
+  if (cf.ckpt){
+    int hdfStep = -1;
+    if (std::filesystem::exists(cf.restartName)){
+      h5Writer<FSCAL> writer;
+#ifdef HAVE_MPI
+      writer.openRead(cf.comm, MPI_INFO_NULL, cf.restartName);
+#else
+      writer.openRead(cf.restartName);
+#endif
+      writer.readAttribute("time_index",hdfStep);
+      writer.close();
+    }
+    if (cf.ckpt->recover(cf,f,hdfStep,tstart,time)){
+      Log::message("Restarting from checkpoint at step {}.",tstart);
+      setRestartTime(cf,tstart,time);
+      return;
     }
-    Kokkos::deep_copy(f->grid,gridH);
   }
 
-  // read cell data
-  int koffset, ii, jj, kk;
-  if (cf.ndim == 3) koffset = cf.ng;
-  else koffset = 0;
-  for (int v=0; v<cf.nvt; ++v){
-    path = fmt::format("/Solution/{}",f->varNames[v]);
-    writer.read(path, cf.ndim, cf.globalCellDims, cf.localCellDims, cf.subdomainOffset, readV);
-    for (int k = koffset; k < cf.nck + koffset; ++k) {
-      for (int j = cf.ng; j < cf.ncj + cf.ng; ++j) {
-        for (int i = cf.ng; i < cf.nci + cf.ng; ++i) {
-          ii = i - cf.ng;
-          jj = j - cf.ng;
-          kk = k - koffset;
-          idx = (cf.nci * cf.ncj) * kk + cf.nci * jj + ii;
-          varH(i, j, k, v) = readV[idx];
-        }
-      }
+  if (cf.rank==0){
+    if (!std::filesystem::exists(cf.restartName)){
+      Log::error("Restart file '{}' does not exist.",cf.restartName);
+      exit(EXIT_FAILURE);
     }
   }
-  Kokkos::deep_copy(f->var,varH);
+
+  h5Writer<FSCAL> writer;
+#ifdef HAVE_MPI
+  writer.openRead(cf.comm, MPI_INFO_NULL, cf.restartName);
+#else
+  writer.openRead(cf.restartName);
+#endif
+
+  readFields(cf, f, writer, cf.grid > 0);
 
   std::string temp_title;
   int restart_version;
@@ -98,63 +166,97 @@ void readRestart(struct inputConfig &cf, std::unique_ptr<class rk_func>&f) {
 
 
   writer.readAttribute("title",temp_title);
+  Log::message("Restart Title: '{}'",temp_title);
 
-  if(cf.restartReset==false){
-    writer.readAttribute("time_index",cf.tstart);
-    writer.readAttribute("time",cf.time);
-  }else{
-    Log::message("Restart reset enabled, using index and time from input file.");
-  }
+  writer.readAttribute("time_index",tstart);
+  writer.readAttribute("time",time);
+  setRestartTime(cf,tstart,time);
 
-  if(cf.tinterval){
-    cf.tend=cf.tstart+cf.nt;
-  }else{
-    cf.nt=cf.tend-cf.tstart;
+  writer.close();
+}
+
+// Read the grid and initial conditions from a cache file written by an
+// earlier run.  Returns false if there is no usable cache file.
+bool readInitialCache(struct inputConfig &cf, std::unique_ptr<class rk_func>&f, std::string name){
+  int found = std::filesystem::exists(name);
+#ifdef HAVE_MPI
+  MPI_Bcast(&found, 1, MPI_INT, 0, cf.comm);
+#endif
+  if (!found)
+    return false;
+
+  h5Writer<FSCAL> writer;
+#ifdef HAVE_MPI
+  writer.openRead(cf.comm, MPI_INFO_NULL, name);
+#else
+  writer.openRead(name);
+#endif
+
+  int restart_version;
+  writer.readAttribute("restart_file_version",restart_version);
+  if (restart_version != FIESTA_RESTART_VERSION){
+    Log::warning("Ignoring cache file '{}' with restart version {}.",name,restart_version);
+    writer.close();
+    return false;
   }
-  cf.t=cf.tstart;
-  Log::message("Restart Title: '{}'",temp_title);
-  Log::message("Restart Properties: t={} time={:.2g}",cf.tstart,cf.time);
-  
+
+  readFields(cf, f, writer, cf.grid > 0);
   writer.close();
+  return true;
 }
 
-void readTerrain(struct inputConfig &cf, std::unique_ptr<class rk_func>&f) {
+// Recover statistics accumulators from the restart file.  Statistics start
+// over if the file has none or if the solution came from a newer checkpoint.
+void readStatistics(struct inputConfig &cf, std::unique_ptr<class rk_func>&f,
+                    std::vector<std::shared_ptr<class runningStats>>&stats){
+  if (!std::filesystem::exists(cf.restartName)){
+    Log::warning("Restart file '{}' not found.  Statistics will start over.",cf.restartName);
+    return;
+  }
+
   h5Writer<FSCAL> writer;
+#ifdef HAVE_MPI
+  writer.openRead(cf.comm, MPI_INFO_NULL, cf.restartName);
+#else
   writer.openRead(cf.restartName);
+#endif
 
-  auto readV = (FSCAL *)malloc(cf.ni * cf.nj * sizeof(FSCAL));
-  auto gridH = Kokkos::create_mirror_view(f->grid);
-
-  std::vector<size_t> gridDims,offset,gridCount;
-  gridDims.push_back(cf.globalGridDims[0]);
-  gridDims.push_back(cf.globalGridDims[1]);
-  offset.push_back(cf.subdomainOffset[0]);
-  offset.push_back(cf.subdomainOffset[1]);
-  gridCount.push_back(cf.localGridDims[0]);
-  gridCount.push_back(cf.localGridDims[1]);
+  int hdfStep;
+  writer.readAttribute("time_index",hdfStep);
+  if (hdfStep != cf.tstart){
+    Log::warning("Restart file '{}' is from step {}, not {}.  Statistics will start over.",cf.restartName,hdfStep,cf.tstart);
+    writer.close();
+    return;
+  }
 
-  size_t idx,ii,jj,kk;
-  FSCAL h, dz;
+  size_t nCells = cf.nci*cf.ncj*cf.nck;
+  int koffset = (cf.ndim == 3) ? cf.ng : 0;
+  policy_f3 cell_pol = policy_f3({0,0,0},{cf.nci,cf.ncj,cf.nck});
 
-  // read grid
-  writer.read("Height", 2, cf.globalCellDims, cf.localCellDims, cf.subdomainOffset, readV);
-  for (int i = 0; i < cf.ni; ++i) {
-    for (int j = 0; j < cf.nj; ++j) {
-      idx = cf.ni * j + i;
-      ii = cf.iStart + i;
-      jj = cf.jStart + j;
-
-      h = readV[idx];
-      dz = (cf.h-h)/cf.glbl_nck;
-      for (int k = 0; k < cf.nk; ++k) {
-        kk = cf.kStart + k;
-        gridH(i, j, k, 0) = cf.tdx*ii;
-        gridH(i, j, k, 1) = cf.tdy*jj;
-        gridH(i, j, k, 2) = h + dz*kk;
-      }
+  for (auto& s : stats){
+    std::string count = fmt::format("{} samples",s->name);
+    if (!writer.hasAttribute(count)){
+      Log::warning("Restart file has no statistics for '{}'.  Statistics will start over.",s->name);
+      continue;
     }
+    writer.readAttribute(count,s->samples);
+
+    std::vector<std::string> paths;
+    for (auto const& name : s->accumulatorNames())
+      paths.push_back(fmt::format("/Statistics/{}",name));
+
+    size_t n = paths.size()*nCells;
+    int lease = cf.staging->acquire(n*sizeof(FSCAL));
+    auto readH = cf.staging->host<FSCAL>(lease, n);
+    auto readD = cf.staging->device<FSCAL>(n);
+    writer.readFields(paths, cf.ndim, cf.globalCellDims, cf.localCellDims, cf.subdomainOffset, readH.data());
+    Kokkos::deep_copy(readD,readH);
+    Kokkos::parallel_for(cell_pol, unpackRestart(s->acc, readD, 0, paths.size(), cf.ng, koffset, cf.nci, cf.ncj, cf.nck));
+    Kokkos::fence();
+    cf.staging->release(lease);
+
+    Log::message("Restored {} samples of statistics '{}'.",s->samples,s->name);
   }
 
   writer.close();
-  Kokkos::deep_copy(f->grid,gridH);
 }
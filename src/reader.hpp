@@ -23,4 +23,7 @@
 
 void readRestart(struct inputConfig &cf, std::unique_ptr<class rk_func>&f);
 
-void readTerrain(struct inputConfig &cf, std::unique_ptr<class rk_func>&f);
+bool readInitialCache(struct inputConfig &cf, std::unique_ptr<class rk_func>&f, std::string name);
+
+void readStatistics(struct inputConfig &cf, std::unique_ptr<class rk_func>&f,
+                    std::vector<std::shared_ptr<class runningStats>>&stats);
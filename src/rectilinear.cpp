@@ -0,0 +1,68 @@
+/*
+  Copyright 2019-2021 The University of New Mexico
+
+  This file is part of FIESTA.
+  
+  FIESTA is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+  
+  FIESTA is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+  
+  You should have received a copy of the GNU Lesser General Public License
+  along with FIESTA.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "rectilinear.hpp"
+#include <vector>
+
+// Fill the local cell widths of each axis from the global node coordinates
+rectGrid::rectGrid(struct inputConfig &cf) {
+  int nc[3]     = {cf.glbl_nci, cf.glbl_ncj, cf.glbl_nck};
+  int ngc[3]    = {cf.ngi, cf.ngj, cf.ngk};
+  bool per[3]   = {cf.xPer, cf.yPer, cf.zPer};
+  const char* name[3] = {"dxr", "dyr", "dzr"};
+
+  for (int a=0; a<3; ++a){
+    const std::vector<FSCAL> &x = cf.axisNodes[a];
+    w[a] = FS1D(name[a], ngc[a]);
+    FS1DH wH = Kokkos::create_mirror_view(w[a]);
+    for (int c=0; c<ngc[a]; ++c){
+      int g = (int)cf.subdomainOffset[a] + c - cf.ng;
+      if (g < 0)
+        g = per[a] ? g + nc[a] : -g - 1;
+      else if (g >= nc[a])
+        g = per[a] ? g - nc[a] : 2*nc[a] - 1 - g;
+      wH(c) = x[g+1] - x[g];
+    }
+    Kokkos::deep_copy(w[a], wH);
+  }
+}
+
+// Compute the node coordinates of this block
+void rectGrid::nodes(struct inputConfig &cf, FS4D &grid) {
+  FS1D x("xNodes", cf.ni);
+  FS1D y("yNodes", cf.nj);
+  FS1D z("zNodes", cf.nk);
+  FS1DH xH = Kokkos::create_mirror_view(x);
+  FS1DH yH = Kokkos::create_mirror_view(y);
+  FS1DH zH = Kokkos::create_mirror_view(z);
+  for (int i=0; i<cf.ni; ++i) xH(i) = cf.axisNodes[0][cf.iStart+i];
+  for (int j=0; j<cf.nj; ++j) yH(j) = cf.axisNodes[1][cf.jStart+j];
+  for (int k=0; k<cf.nk; ++k) zH(k) = cf.axisNodes[2][cf.kStart+k];
+  Kokkos::deep_copy(x, xH);
+  Kokkos::deep_copy(y, yH);
+  Kokkos::deep_copy(z, zH);
+
+  Kokkos::parallel_for("rectNodes", policy_f3({0, 0, 0}, {cf.ni, cf.nj, cf.nk}),
+    KOKKOS_LAMBDA(const int i, const int j, const int k) {
+      grid(i, j, k, 0) = x(i);
+      grid(i, j, k, 1) = y(j);
+      grid(i, j, k, 2) = z(k);
+    });
+  Kokkos::fence();
+}
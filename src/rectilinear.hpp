@@ -0,0 +1,70 @@
+/*
+  Copyright 2019-2021 The University of New Mexico
+
+  This file is part of FIESTA.
+  
+  FIESTA is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+  
+  FIESTA is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+  
+  You should have received a copy of the GNU Lesser General Public License
+  along with FIESTA.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef RECTILINEAR_H
+#define RECTILINEAR_H
+
+#include "kokkosTypes.hpp"
+#include "input.hpp"
+
+// Rectilinear grid.  Node coordinates along each axis are independent 1D
+// lists, so cells can be clustered in x, y and z separately.  Only the cell
+// widths are stored, one small array per axis with ng ghost cells on each
+// side, and the kernels read the spacing from them in place of the uniform
+// cell size of the cartesian solver.  Ghost cells past a physical boundary
+// take the width of the cell mirrored into the domain, and cells in periodic
+// blocks the width of the cell they wrap to.
+class rectGrid {
+  public:
+    rectGrid() {}
+    rectGrid(struct inputConfig &);
+    void nodes(struct inputConfig &, FS4D &);
+
+    // width of local cell i along axis a
+    KOKKOS_INLINE_FUNCTION
+    FSCAL width(const int a, const int i) const {
+      return w[a](i);
+    }
+
+    // distance between the centers of cells i and i+1 along axis a
+    KOKKOS_INLINE_FUNCTION
+    FSCAL face(const int a, const int i) const {
+      return 0.5*(w[a](i) + w[a](i+1));
+    }
+
+    // half the distance between the centers of cells i-1 and i+1 along axis a
+    KOKKOS_INLINE_FUNCTION
+    FSCAL span(const int a, const int i) const {
+      return 0.25*w[a](i-1) + 0.5*w[a](i) + 0.25*w[a](i+1);
+    }
+
+    // fourth order derivative of the cell center coordinate along axis a with
+    // respect to the cell index, the same stencil as the central differences
+    KOKKOS_INLINE_FUNCTION
+    FSCAL metric(const int a, const int i) const {
+      FSCAL d1 = 0.5*w[a](i-1) + w[a](i) + 0.5*w[a](i+1);
+      FSCAL d2 = 0.5*w[a](i-2) + w[a](i-1) + w[a](i) + w[a](i+1) + 0.5*w[a](i+2);
+      return (8.0*d1 - d2)/12.0;
+    }
+
+  private:
+    FS1D w[3];   // cell widths along x, y and z, ghosts included
+};
+
+#endif
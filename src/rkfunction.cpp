@@ -20,7 +20,24 @@
 #include "rkfunction.hpp"
 #include "Kokkos_Core.hpp"
 #include "input.hpp"
+#include <algorithm>
 
 //rk_func::rk_func(struct inputConfig &cf_, FS1D &cd_)
 //    : cf(cf_), mcd(cd_){};
 rk_func::rk_func(struct inputConfig &cf_) : cf(cf_){};
+
+bool rk_func::findField(std::string name, int &source, int &index){
+  auto vit = std::find(varNames.begin(), varNames.end(), name);
+  if (vit != varNames.end()){
+    source = 0;
+    index = vit - varNames.begin();
+    return true;
+  }
+  auto xit = std::find(varxNames.begin(), varxNames.end(), name);
+  if (xit != varxNames.end()){
+    source = 1;
+    index = xit - varxNames.begin();
+    return true;
+  }
+  return false;
+}
@@ -45,6 +45,9 @@ public:
   virtual void postStep() = 0;
   virtual void preSim() = 0;
   virtual void postSim() = 0;
+
+  // locate a named field in var (source 0) or varx (source 1)
+  bool findField(std::string name, int &source, int &index);
   // virtual void compute(const FS4D & mvar, FS4D & mdvar) = 0;
 
   FS4D var;
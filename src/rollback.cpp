@@ -0,0 +1,151 @@
+/*
+  Copyright 2019-2021 The University of New Mexico
+
+  This file is part of FIESTA.
+  
+  FIESTA is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+  
+  FIESTA is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+  
+  You should have received a copy of the GNU Lesser General Public License
+  along with FIESTA.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "rollback.hpp"
+#include "input.hpp"
+#include "log2.hpp"
+#ifdef HAVE_MPI
+#include "mpi.h"
+#endif
+
+// Count cells with a non-finite variable, a negative species density or a
+// non-positive internal energy, which for an ideal gas is the same as a
+// non-positive pressure.
+struct healthCheck {
+  FS4D var;
+  int nv;       // number of variables
+  int nd;       // number of dimensions
+  int ns;       // number of species
+
+  healthCheck(FS4D var_, int nv_, int nd_, int ns_)
+      : var(var_), nv(nv_), nd(nd_), ns(ns_) {}
+
+  KOKKOS_INLINE_FUNCTION
+  void operator()(const int i, const int j, const int k, int &bad) const {
+    bool flag = false;
+    for (int v = 0; v < nv; ++v)
+      flag |= isnan(var(i, j, k, v)) || isinf(var(i, j, k, v));
+
+    FSCAL rho = 0;
+    for (int s = 0; s < ns; ++s){
+      flag |= var(i, j, k, nd + 1 + s) < 0;
+      rho += var(i, j, k, nd + 1 + s);
+    }
+
+    FSCAL ke = 0;
+    for (int d = 0; d < nd; ++d)
+      ke += var(i, j, k, d) * var(i, j, k, d);
+    flag |= !(var(i, j, k, nd) - 0.5 * ke / rho > 0);
+
+    bad += flag;
+  }
+};
+
+rollbackRing::rollbackRing(struct inputConfig &cf, std::unique_ptr<class rk_func>&f)
+  : newest(-1), rollbacks(0) {
+
+  for (int s=0; s<cf.snapshots; ++s){
+    snapshotData snap;
+    snap.var = FS4D(Kokkos::ViewAllocateWithoutInitializing("rollback"),
+                    f->var.extent(0), f->var.extent(1), f->var.extent(2), f->var.extent(3));
+    snap.t = -1;
+    snap.time = 0;
+    ring.push_back(snap);
+  }
+}
+
+// Fused check of the interior cells on every rank
+bool rollbackRing::healthy(struct inputConfig &cf, std::unique_ptr<class rk_func>&f){
+  policy_f3 cell_pol = policy_f3({cf.ng, cf.ng, 0}, {cf.ngi - cf.ng, cf.ngj - cf.ng, 1});
+  if (cf.ndim == 3)
+    cell_pol = policy_f3({cf.ng, cf.ng, cf.ng}, {cf.ngi - cf.ng, cf.ngj - cf.ng, cf.ngk - cf.ng});
+
+  int bad = 0;
+  Kokkos::parallel_reduce(cell_pol, healthCheck(f->var, cf.nvt, cf.ndim, cf.ns), bad);
+  Kokkos::fence();
+
+#ifdef HAVE_MPI
+  MPI_Allreduce(MPI_IN_PLACE, &bad, 1, MPI_INT, MPI_SUM, cf.comm);
+#endif
+
+  if (bad > 0)
+    Log::warning("[{}] Health check found {} bad cells.",cf.t,bad);
+  return bad == 0;
+}
+
+// Store var and the statistics accumulators in the oldest slot of the ring
+void rollbackRing::snapshot(struct inputConfig &cf, std::unique_ptr<class rk_func>&f,
+                            std::vector<std::shared_ptr<runningStats>>& stats){
+  newest = (newest + 1) % ring.size();
+  snapshotData &snap = ring[newest];
+  Kokkos::deep_copy(snap.var, f->var);
+
+  // statistics are configured after the ring is created, so their copies are
+  // allocated with the first snapshot
+  if (snap.acc.size() != stats.size()){
+    snap.acc.clear();
+    for (auto& s : stats)
+      snap.acc.push_back(FS4D(Kokkos::ViewAllocateWithoutInitializing("rollback_stats"),
+                              s->acc.extent(0), s->acc.extent(1), s->acc.extent(2), s->acc.extent(3)));
+    snap.samples.resize(stats.size());
+  }
+  for (size_t i=0; i<stats.size(); ++i){
+    Kokkos::deep_copy(snap.acc[i], stats[i]->acc);
+    snap.samples[i] = stats[i]->samples;
+  }
+
+  snap.t = cf.t;
+  snap.time = cf.time;
+  Log::debug("[{}] Stored rollback snapshot",cf.t);
+}
+
+// Return to the newest snapshot, optionally with a smaller time step or the
+// noise filter enabled.  Exits if there is nothing to return to.
+void rollbackRing::restore(struct inputConfig &cf, std::unique_ptr<class rk_func>&f,
+                           std::vector<std::shared_ptr<runningStats>>& stats){
+  if (newest < 0){
+    Log::error("Solution is unstable at step {} and there is no snapshot to roll back to.",cf.t);
+    exit(EXIT_FAILURE);
+  }
+  if (++rollbacks > cf.maxRollbacks){
+    Log::error("Solution is unstable at step {} after {} rollbacks.",cf.t,cf.maxRollbacks);
+    exit(EXIT_FAILURE);
+  }
+
+  snapshotData &snap = ring[newest];
+  Kokkos::deep_copy(f->var, snap.var);
+  for (size_t i=0; i<snap.acc.size(); ++i){
+    Kokkos::deep_copy(stats[i]->acc, snap.acc[i]);
+    stats[i]->samples = snap.samples[i];
+  }
+  Kokkos::fence();
+
+  Log::warning("Solution is unstable at step {}.  Rolling back to step {}.",cf.t,snap.t);
+  cf.t = snap.t;
+  cf.time = snap.time;
+
+  if (cf.rollbackDtFactor < 1.0){
+    cf.dt *= cf.rollbackDtFactor;
+    Log::warning("Reducing time step to {:.3e}s.",cf.dt);
+  }
+  if (cf.rollbackNoise && !cf.noise){
+    cf.noise = true;
+    Log::warning("Enabling noise filter.");
+  }
+}
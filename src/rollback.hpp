@@ -0,0 +1,58 @@
+/*
+  Copyright 2019-2021 The University of New Mexico
+
+  This file is part of FIESTA.
+  
+  FIESTA is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+  
+  FIESTA is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+  
+  You should have received a copy of the GNU Lesser General Public License
+  along with FIESTA.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef ROLLBACK_H
+#define ROLLBACK_H
+
+#include "kokkosTypes.hpp"
+#include "rkfunction.hpp"
+#include "stats.hpp"
+#include <memory>
+#include <vector>
+
+// In-memory rollback.  The solution is checked for non-finite values and
+// negative densities or pressure every few steps, and copies of var are kept
+// in a ring on the device.  When a check fails the solver returns to the
+// newest copy rather than the last restart file.  Running statistics are
+// copied with the solution so samples taken after a snapshot are discarded.
+class rollbackRing {
+  public:
+    rollbackRing(struct inputConfig&, std::unique_ptr<class rk_func>&);
+
+    bool healthy(struct inputConfig&, std::unique_ptr<class rk_func>&);
+    void snapshot(struct inputConfig&, std::unique_ptr<class rk_func>&,
+                  std::vector<std::shared_ptr<runningStats>>&);
+    void restore(struct inputConfig&, std::unique_ptr<class rk_func>&,
+                 std::vector<std::shared_ptr<runningStats>>&);
+
+  private:
+    struct snapshotData {
+      FS4D var;
+      std::vector<FS4D> acc;     // statistics accumulators
+      std::vector<int> samples;  // statistics sample counts
+      int t;
+      FSCAL time;
+    };
+
+    std::vector<snapshotData> ring;
+    int newest;     // index of the newest snapshot, -1 if none
+    int rollbacks;  // rollbacks performed so far
+};
+
+#endif
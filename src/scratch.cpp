@@ -0,0 +1,35 @@
+/*
+  Copyright 2019-2021 The University of New Mexico
+
+  This file is part of FIESTA.
+  
+  FIESTA is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+  
+  FIESTA is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+  
+  You should have received a copy of the GNU Lesser General Public License
+  along with FIESTA.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "scratch.hpp"
+
+// Reserve the arrays of a region, given in bytes
+void scratchArena::reserve(std::initializer_list<size_t> bytes){
+  size_t total = 0;
+  for (size_t b : bytes)
+    total += aligned(b);
+  if (total > highWater)
+    highWater = total;
+}
+
+// Allocate the arena for the largest reserved region
+void scratchArena::allocate(){
+  if (buffer.extent(0) < highWater)
+    buffer = Kokkos::View<char*>(Kokkos::ViewAllocateWithoutInitializing("scratch"), highWater);
+}
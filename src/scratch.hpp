@@ -0,0 +1,84 @@
+/*
+  Copyright 2019-2021 The University of New Mexico
+
+  This file is part of FIESTA.
+  
+  FIESTA is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+  
+  FIESTA is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+  
+  You should have received a copy of the GNU Lesser General Public License
+  along with FIESTA.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef SCRATCH_H
+#define SCRATCH_H
+
+#include "Kokkos_Core.hpp"
+#include "log2.hpp"
+#include <cstdlib>
+#include <initializer_list>
+
+// Device memory for solver temporaries that are only live within one region
+// of a step.  Each region reserves the arrays it needs up front, the arena is
+// sized for the largest region and allocated once, and while a region runs it
+// leases its arrays from the bottom of the arena.  Leases are returned when
+// the region goes out of scope, so regions that do not overlap share the
+// same storage.  The memory is not initialized.
+class scratchArena {
+  public:
+    scratchArena() {}
+
+    // round leases up so that every array starts on an aligned address
+    static size_t aligned(size_t bytes){
+      return (bytes + alignment - 1)/alignment*alignment;
+    }
+
+    void reserve(std::initializer_list<size_t> bytes);
+    void allocate();
+
+    // size of the arena, the largest region
+    size_t bytes() const { return highWater; }
+
+    class region {
+      public:
+        region(scratchArena &a) : arena(a), start(a.top) {}
+        ~region() { arena.top = start; }
+
+        // lease an array of the given extents for the lifetime of the region
+        template <typename V, typename... I>
+        V get(I... n){
+          size_t count = 1;
+          for (size_t e : {(size_t)n...})
+            count *= e;
+          size_t bytes = aligned(count*sizeof(typename V::value_type));
+          if (arena.top + bytes > arena.buffer.extent(0)){
+            Log::error("Scratch arena of {} bytes cannot lease {} more bytes, a region was not reserved.",
+                       arena.buffer.extent(0),bytes);
+            exit(EXIT_FAILURE);
+          }
+          V v(reinterpret_cast<typename V::value_type*>(arena.buffer.data()+arena.top), n...);
+          arena.top += bytes;
+          return v;
+        }
+
+      private:
+        scratchArena &arena;
+        size_t start;
+    };
+
+  private:
+    static constexpr size_t alignment = 256;
+
+    Kokkos::View<char*> buffer;
+    size_t highWater = 0;   // bytes of the largest reserved region
+    size_t top = 0;         // bytes currently leased
+};
+
+#endif
@@ -20,16 +20,31 @@
 #ifndef SIGNAL_H
 #define SIGNAL_H
 
+#include <atomic>
 #include <csignal>
 #include "input.hpp"
 
+// Pending signal bits.  Handlers only record the request in a lock-free
+// atomic; Fiesta::collectSignals() takes the pending bits, reaches consensus
+// across ranks and sets cf.restartFlag and cf.exitFlag.
+#define FIESTA_SIGNAL_RESTART 1
+#define FIESTA_SIGNAL_EXIT 2
+
 class fiestaSignalHandler{
     static fiestaSignalHandler *instance;
     struct inputConfig &cf;
 
     fiestaSignalHandler(struct inputConfig &cf_):cf(cf_){};
 
+    static inline std::atomic<int> pending{0};
+    static_assert(std::atomic<int>::is_always_lock_free, "signal flags must be lock-free");
+
   public:
+    // take the bits raised since the last call
+    static int takeFlags(){
+      return pending.exchange(0);
+    }
+
     static fiestaSignalHandler *getInstance(struct inputConfig &cf){
       if (!instance)
         instance = new fiestaSignalHandler(cf);
@@ -50,14 +65,13 @@ class fiestaSignalHandler{
     }
 
     void sigurgFunction([[maybe_unused]] int signum){
-      cf.exitFlag=1;
-      cf.restartFlag=1;
+      pending.fetch_or(FIESTA_SIGNAL_RESTART | FIESTA_SIGNAL_EXIT);
     }
     void sigusr1Function([[maybe_unused]] int signum){
-      cf.restartFlag=1;
+      pending.fetch_or(FIESTA_SIGNAL_RESTART);
     }
     void sigtermFunction([[maybe_unused]] int signum){
-      cf.exitFlag=1;
+      pending.fetch_or(FIESTA_SIGNAL_EXIT);
     }
 
     static void sigurgHandler(int signum){
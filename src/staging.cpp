@@ -0,0 +1,67 @@
+/*
+  Copyright 2019-2021 The University of New Mexico
+
+  This file is part of FIESTA.
+  
+  FIESTA is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+  
+  FIESTA is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+  
+  You should have received a copy of the GNU Lesser General Public License
+  along with FIESTA.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "staging.hpp"
+
+ioStaging::ioStaging(){}
+
+// Lease a host buffer of at least the requested size.  Free buffers are
+// reused, and resized if necessary, before a new buffer is allocated.
+int ioStaging::acquire(size_t bytes){
+  std::lock_guard<std::mutex> lock(mtx);
+  int lease = -1;
+
+  for (size_t b=0; b<hostBuffers.size(); ++b){
+    if (!leased[b]){
+      lease = b;
+      if (hostBuffers[b].extent(0) >= bytes)
+        break;
+    }
+  }
+
+  if (lease < 0){
+    lease = hostBuffers.size();
+    hostBuffers.push_back(Kokkos::View<char*, Kokkos::HostSpace>());
+    leased.push_back(false);
+  }
+
+  if (hostBuffers[lease].extent(0) < bytes)
+    hostBuffers[lease] = Kokkos::View<char*, Kokkos::HostSpace>(Kokkos::ViewAllocateWithoutInitializing("ioStagingHost"), bytes);
+
+  leased[lease] = true;
+  return lease;
+}
+
+// Return a host buffer to the pool.  May be called from the I/O thread.
+void ioStaging::release(int lease){
+  std::lock_guard<std::mutex> lock(mtx);
+  leased[lease] = false;
+}
+
+size_t ioStaging::hostBytes(){
+  std::lock_guard<std::mutex> lock(mtx);
+  size_t bytes = 0;
+  for (auto &b : hostBuffers)
+    bytes += b.extent(0);
+  return bytes;
+}
+
+size_t ioStaging::deviceBytes(){
+  return deviceBuffer.extent(0);
+}
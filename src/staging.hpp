@@ -0,0 +1,59 @@
+/*
+  Copyright 2019-2021 The University of New Mexico
+
+  This file is part of FIESTA.
+  
+  FIESTA is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+  
+  FIESTA is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+  
+  You should have received a copy of the GNU Lesser General Public License
+  along with FIESTA.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef STAGING_H
+#define STAGING_H
+
+#include "Kokkos_Core.hpp"
+#include <mutex>
+#include <vector>
+
+// Staging buffers shared by all ioviews.  Views pack their selections into a
+// single device buffer and copy them out to host buffers leased from a common
+// pool.  A lease is held until the view's write has completed, so host memory
+// scales with the number of writes in flight rather than the number of views.
+class ioStaging {
+  public:
+    ioStaging();
+
+    template <typename T>
+    Kokkos::View<T*, Kokkos::MemoryUnmanaged> device(size_t n){
+      size_t bytes = n*sizeof(T);
+      if (deviceBuffer.extent(0) < bytes)
+        deviceBuffer = Kokkos::View<char*>(Kokkos::ViewAllocateWithoutInitializing("ioStaging"), bytes);
+      return Kokkos::View<T*, Kokkos::MemoryUnmanaged>(reinterpret_cast<T*>(deviceBuffer.data()), n);
+    }
+
+    template <typename T>
+    Kokkos::View<T*, Kokkos::HostSpace, Kokkos::MemoryUnmanaged> host(int lease, size_t n){
+      return Kokkos::View<T*, Kokkos::HostSpace, Kokkos::MemoryUnmanaged>(reinterpret_cast<T*>(hostBuffers[lease].data()), n);
+    }
+
+    int acquire(size_t bytes);
+    void release(int lease);
+    size_t hostBytes();
+    size_t deviceBytes();
+
+  private:
+    Kokkos::View<char*> deviceBuffer;
+    std::vector<Kokkos::View<char*, Kokkos::HostSpace>> hostBuffers;
+    std::vector<bool> leased;
+    std::mutex mtx;
+};
+
+#endif
@@ -0,0 +1,173 @@
+/*
+  Copyright 2019-2021 The University of New Mexico
+
+  This file is part of FIESTA.
+  
+  FIESTA is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+  
+  FIESTA is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+  
+  You should have received a copy of the GNU Lesser General Public License
+  along with FIESTA.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "stats.hpp"
+#include "input.hpp"
+#include "log2.hpp"
+#include "fmt/core.h"
+#include <algorithm>
+
+using fmt::format;
+
+// Add one sample to the running mean, squared deviations and co-moments of
+// every cell.  Co-moments are updated first, since they need the mean of the
+// first field before this sample.
+struct welfordUpdate {
+  FS4D var, varx, acc;
+  FS1D_I src, idx, pa, pb;
+  int nf, np;
+  FSCAL n;  // sample count including this one
+
+  welfordUpdate(FS4D var_, FS4D varx_, FS4D acc_, FS1D_I src_, FS1D_I idx_, FS1D_I pa_, FS1D_I pb_,
+                int nf_, int np_, FSCAL n_)
+      : var(var_), varx(varx_), acc(acc_), src(src_), idx(idx_), pa(pa_), pb(pb_), nf(nf_), np(np_), n(n_) {}
+
+  KOKKOS_INLINE_FUNCTION
+  FSCAL value(const int i, const int j, const int k, const int f) const {
+    return (src(f) == 0) ? var(i, j, k, idx(f)) : varx(i, j, k, idx(f));
+  }
+
+  KOKKOS_INLINE_FUNCTION
+  void operator()(const int i, const int j, const int k) const {
+    for (int p = 0; p < np; ++p) {
+      int a = pa(p);
+      int b = pb(p);
+      FSCAL xb = value(i, j, k, b);
+      FSCAL da = value(i, j, k, a) - acc(i, j, k, a);
+      FSCAL mb = acc(i, j, k, b) + (xb - acc(i, j, k, b)) / n;
+      acc(i, j, k, 2 * nf + p) += da * (xb - mb);
+    }
+
+    for (int f = 0; f < nf; ++f) {
+      FSCAL x = value(i, j, k, f);
+      FSCAL d = x - acc(i, j, k, f);
+      acc(i, j, k, f) += d / n;
+      acc(i, j, k, nf + f) += d * (x - acc(i, j, k, f));
+    }
+  }
+};
+
+// Convert accumulators to means, variances and covariances
+struct finalizeStats {
+  FS4D acc, out;
+  int nf;
+  FSCAL scale;
+
+  finalizeStats(FS4D acc_, FS4D out_, int nf_, FSCAL scale_)
+      : acc(acc_), out(out_), nf(nf_), scale(scale_) {}
+
+  KOKKOS_INLINE_FUNCTION
+  void operator()(const int i, const int j, const int k, const int v) const {
+    out(i, j, k, v) = (v < nf) ? acc(i, j, k, v) : acc(i, j, k, v) * scale;
+  }
+};
+
+runningStats::runningStats(struct inputConfig &cf, std::unique_ptr<class rk_func>&f, std::string name_, int sample_,
+                           std::vector<std::string> fields_, std::vector<std::pair<std::string,std::string>> pairs_)
+  : name(name_), sample(sample_), samples(0), needVarx(false), fields(fields_) {
+
+  if (sample < 1){
+    Log::error("Sample frequency of statistics view '{}' must be positive.",name);
+    exit(EXIT_FAILURE);
+  }
+
+  // fields of each pair are accumulated as well, since their means are needed
+  for (auto const& [a, b] : pairs_){
+    for (auto const& field : {a, b})
+      if (std::find(fields.begin(), fields.end(), field) == fields.end())
+        fields.push_back(field);
+    int ia = std::find(fields.begin(), fields.end(), a) - fields.begin();
+    int ib = std::find(fields.begin(), fields.end(), b) - fields.begin();
+    pairs.push_back({ia, ib});
+  }
+
+  nf = fields.size();
+  np = pairs.size();
+
+  src = FS1D_I("stats_src", nf);
+  idx = FS1D_I("stats_idx", nf);
+  pa = FS1D_I("stats_pa", np);
+  pb = FS1D_I("stats_pb", np);
+  auto srcH = Kokkos::create_mirror_view(src);
+  auto idxH = Kokkos::create_mirror_view(idx);
+  auto paH = Kokkos::create_mirror_view(pa);
+  auto pbH = Kokkos::create_mirror_view(pb);
+
+  for (int fi = 0; fi < nf; ++fi){
+    if (!f->findField(fields[fi], srcH(fi), idxH(fi))){
+      Log::error("Statistics view '{}' requests unknown field '{}'.",name,fields[fi]);
+      exit(EXIT_FAILURE);
+    }
+    needVarx |= (srcH(fi) == 1);
+  }
+  for (int p = 0; p < np; ++p){
+    paH(p) = pairs[p].first;
+    pbH(p) = pairs[p].second;
+  }
+
+  Kokkos::deep_copy(src, srcH);
+  Kokkos::deep_copy(idx, idxH);
+  Kokkos::deep_copy(pa, paH);
+  Kokkos::deep_copy(pb, pbH);
+
+  acc = FS4D("stats_acc", cf.ngi, cf.ngj, cf.ngk, 2*nf+np);
+}
+
+void runningStats::update(struct inputConfig &cf, std::unique_ptr<class rk_func>&f){
+  policy_f3 cell_pol = policy_f3({cf.ng, cf.ng, 0}, {cf.ngi - cf.ng, cf.ngj - cf.ng, 1});
+  if (cf.ndim == 3)
+    cell_pol = policy_f3({cf.ng, cf.ng, cf.ng}, {cf.ngi - cf.ng, cf.ngj - cf.ng, cf.ngk - cf.ng});
+
+  samples += 1;
+  Kokkos::parallel_for(cell_pol, welfordUpdate(f->var, f->varx, acc, src, idx, pa, pb, nf, np, samples));
+}
+
+// Means, variances and covariances of the samples so far
+FS4D& runningStats::result(){
+  if (out.extent(0) == 0)
+    out = FS4D("stats_out", acc.extent(0), acc.extent(1), acc.extent(2), acc.extent(3));
+
+  FSCAL scale = (samples > 0) ? 1.0/samples : 0.0;
+  policy_f4 all_pol = policy_f4({0, 0, 0, 0}, {(int)acc.extent(0), (int)acc.extent(1), (int)acc.extent(2), (int)acc.extent(3)});
+  Kokkos::parallel_for(all_pol, finalizeStats(acc, out, nf, scale));
+  return out;
+}
+
+std::vector<std::string> runningStats::resultNames(){
+  std::vector<std::string> names;
+  for (auto const& field : fields)
+    names.push_back(format("Mean {}",field));
+  for (auto const& field : fields)
+    names.push_back(format("Variance {}",field));
+  for (auto const& [a, b] : pairs)
+    names.push_back(format("Covariance {} {}",fields[a],fields[b]));
+  return names;
+}
+
+// Dataset names of the raw accumulators in restart files
+std::vector<std::string> runningStats::accumulatorNames(){
+  std::vector<std::string> names;
+  for (auto const& field : fields)
+    names.push_back(format("{} Mean {}",name,field));
+  for (auto const& field : fields)
+    names.push_back(format("{} M2 {}",name,field));
+  for (auto const& [a, b] : pairs)
+    names.push_back(format("{} C2 {} {}",name,fields[a],fields[b]));
+  return names;
+}
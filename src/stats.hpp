@@ -0,0 +1,61 @@
+/*
+  Copyright 2019-2021 The University of New Mexico
+
+  This file is part of FIESTA.
+  
+  FIESTA is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+  
+  FIESTA is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+  
+  You should have received a copy of the GNU Lesser General Public License
+  along with FIESTA.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef STATS_H
+#define STATS_H
+
+#include "kokkosTypes.hpp"
+#include "rkfunction.hpp"
+#include <string>
+#include <utility>
+#include <vector>
+
+// Running statistics of selected var and varx fields, accumulated on the
+// device with Welford's method.  Each cell holds the running mean and the sum
+// of squared deviations of every field, and the co-moment of each requested
+// pair.  The accumulators are written to restart files so averages continue
+// across restarts.
+class runningStats {
+  public:
+    runningStats(struct inputConfig&, std::unique_ptr<class rk_func>&, std::string, int,
+                 std::vector<std::string>, std::vector<std::pair<std::string,std::string>>);
+
+    void update(struct inputConfig&, std::unique_ptr<class rk_func>&);
+    FS4D& result();
+
+    std::vector<std::string> resultNames();
+    std::vector<std::string> accumulatorNames();
+
+    std::string name;
+    int sample;      // steps between samples
+    int samples;     // samples accumulated so far
+    bool needVarx;   // a field comes from varx
+    FS4D acc;        // mean, squared deviations, co-moments
+
+  private:
+    int nf, np;
+    std::vector<std::string> fields;
+    std::vector<std::pair<int,int>> pairs;
+    FS1D_I src;      // 0 for var, 1 for varx
+    FS1D_I idx;      // index in the source view
+    FS1D_I pa, pb;   // fields of each pair
+    FS4D out;        // mean, variance, covariance
+};
+
+#endif
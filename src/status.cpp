@@ -34,71 +34,80 @@
 #include "yogrt.h"
 #endif
 #include <limits>
+#include <vector>
 
 using std::cout;
 
-struct maxVarFunctor2d {
+// Fused status reduction.  Computes the min, max and number of non-finite
+// values of every var and varx component in a single pass.  The reduction
+// array is packed as [min(0..n-1), max(0..n-1), bad(0..n-1)] where n=nvt+nvx.
+struct statusReducer {
+  typedef FSCAL value_type[];
+
+  unsigned value_count;
   FS4D var;
-  int v;
+  FS4D varx;
+  int nv;
+  int nx;
 
-  maxVarFunctor2d(FS4D var_, int v_) : var(var_), v(v_) {}
+  statusReducer(FS4D var_, FS4D varx_, int nv_, int nx_)
+      : value_count(3 * (nv_ + nx_)), var(var_), varx(varx_), nv(nv_), nx(nx_) {}
 
   KOKKOS_INLINE_FUNCTION
-  void operator()(const int i, const int j, FSCAL &lmax) const {
-
-    FSCAL s = var(i, j, 0, v);
-
-    if (s > lmax)
-      lmax = s;
+  void check(value_type r, const int n, const int idx, const FSCAL s) const {
+    if (isnan(s) || isinf(s)) {
+      r[2 * n + idx] += 1;
+    } else {
+      if (s < r[idx]) r[idx] = s;
+      if (s > r[n + idx]) r[n + idx] = s;
+    }
   }
-};
-
-struct minVarFunctor2d {
-  FS4D var;
-  int v;
-
-  minVarFunctor2d(FS4D var_, int v_) : var(var_), v(v_) {}
 
   KOKKOS_INLINE_FUNCTION
-  void operator()(const int i, const int j, FSCAL &lmin) const {
-
-    FSCAL s = var(i, j, 0, v);
-
-    if (s < lmin)
-      lmin = s;
+  void operator()(const int i, const int j, const int k, value_type r) const {
+    const int n = nv + nx;
+    for (int v = 0; v < nv; ++v)
+      check(r, n, v, var(i, j, k, v));
+    for (int v = 0; v < nx; ++v)
+      check(r, n, nv + v, varx(i, j, k, v));
   }
-};
-
-struct minVarFunctor3d {
-  FS4D var;
-  int v;
-
-  minVarFunctor3d(FS4D var_, int v_) : var(var_), v(v_) {}
 
   KOKKOS_INLINE_FUNCTION
-  void operator()(const int i, const int j, const int k, FSCAL &lmin) const {
-    FSCAL s = var(i, j, k, v);
-    if (s < lmin)
-      lmin = s;
+  void join(volatile value_type dst, const volatile value_type src) const {
+    const int n = nv + nx;
+    for (int v = 0; v < n; ++v) {
+      if (src[v] < dst[v]) dst[v] = src[v];
+      if (src[n + v] > dst[n + v]) dst[n + v] = src[n + v];
+      dst[2 * n + v] += src[2 * n + v];
+    }
   }
-};
-
-struct maxVarFunctor3d {
-  FS4D var;
-  int v;
-
-  maxVarFunctor3d(FS4D var_, int v_) : var(var_), v(v_) {}
 
   KOKKOS_INLINE_FUNCTION
-  void operator()(const int i, const int j, const int k, FSCAL &lmax) const {
-
-    FSCAL s = var(i, j, k, v);
-
-    if (s > lmax)
-      lmax = s;
+  void init(value_type r) const {
+    const int n = nv + nx;
+    for (int v = 0; v < n; ++v) {
+      r[v] = Kokkos::reduction_identity<FSCAL>::min();
+      r[n + v] = Kokkos::reduction_identity<FSCAL>::max();
+      r[2 * n + v] = 0;
+    }
   }
 };
 
+#ifdef HAVE_MPI
+// MPI counterpart of statusReducer::join so the packed array can be reduced
+// across ranks with a single collective.
+void statusReduceOp(void *in, void *inout, int *len, MPI_Datatype *dtype) {
+  FSCAL *src = (FSCAL *)in;
+  FSCAL *dst = (FSCAL *)inout;
+  const int n = *len / 3;
+  for (int v = 0; v < n; ++v) {
+    if (src[v] < dst[v]) dst[v] = src[v];
+    if (src[n + v] > dst[n + v]) dst[n + v] = src[n + v];
+    dst[2 * n + v] += src[2 * n + v];
+  }
+}
+#endif
+
 bool isBad(FSCAL val){
       if ((isnormal(val) || val == 0) && (val > -1.0e+200 && val < 1.0e+200))
         return false;
@@ -114,12 +123,6 @@ bool isConcern(FSCAL val){
 }
 
 void statusCheck(int cFlag, struct inputConfig cf, std::unique_ptr<class rk_func>&f, FSCAL time, Timer::fiestaTimer &wall, Timer::fiestaTimer &sim) {
-  FSCAL max[f->varxNames.size()];
-  FSCAL min[f->varxNames.size()];
-#ifdef HAVE_MPI
-  FSCAL max_recv[f->varxNames.size()];
-  FSCAL min_recv[f->varxNames.size()];
-#endif
   ansiColors c(cFlag);
   string smin,smax;
 
@@ -151,103 +154,51 @@ void statusCheck(int cFlag, struct inputConfig cf, std::unique_ptr<class rk_func
     cout << std::flush;
   }
 
-  // var
-  if (cf.ndim == 2) {
-    policy_f cell_pol = policy_f({cf.ng, cf.ng}, {cf.ngi - cf.ng, cf.ngj - cf.ng});
-    for (int v = 0; v < cf.nvt; ++v) {
-      Kokkos::parallel_reduce(cell_pol, maxVarFunctor2d(f->var, v), Kokkos::Max<FSCAL>(max[v]));
-      Kokkos::parallel_reduce(cell_pol, minVarFunctor2d(f->var, v), Kokkos::Min<FSCAL>(min[v]));
-      Kokkos::fence();
-      #ifdef HAVE_MPI
-        MPI_Allreduce(&max[v], &max_recv[v], 1, MPI_DOUBLE, MPI_MAX, cf.comm);
-        MPI_Allreduce(&min[v], &min_recv[v], 1, MPI_DOUBLE, MPI_MIN, cf.comm);
-        max[v] = max_recv[v];
-        min[v] = min_recv[v];
-      #endif
-    }
-  } else {
-    policy_f3 cell_pol = policy_f3({cf.ng, cf.ng, cf.ng}, {cf.ngi - cf.ng, cf.ngj - cf.ng, cf.ngk-cf.ng});
-    for (int v = 0; v < cf.nvt; ++v) {
-      Kokkos::parallel_reduce(cell_pol, maxVarFunctor3d(f->var, v), Kokkos::Max<FSCAL>(max[v]));
-      Kokkos::parallel_reduce(cell_pol, minVarFunctor3d(f->var, v), Kokkos::Min<FSCAL>(min[v]));
-      Kokkos::fence();
-      #ifdef HAVE_MPI
-        MPI_Allreduce(&max[v], &max_recv[v], 1, MPI_DOUBLE, MPI_MAX, cf.comm);
-        MPI_Allreduce(&min[v], &min_recv[v], 1, MPI_DOUBLE, MPI_MIN, cf.comm);
-        max[v] = max_recv[v];
-        min[v] = min_recv[v];
-      #endif
-    }
-  }
-
-  if (cf.rank == 0) {
-    for (int v = 0; v < cf.nvt; ++v) {
-      if (isBad(min[v]))
-        smin = format("{}{:>11.2e}{}",c(red),min[v],c(reset));
-      else if (isConcern(min[v]))
-        smin = format("{}{:>11.2e}{}",c(yellow),min[v],c(reset));
-      else
-        smin = format("{}{:>11.2e}{}",c(magenta),min[v],c(reset));
+  const int nv = cf.nvt;
+  const int nx = f->varxNames.size();
+  const int n = nv + nx;
+  std::vector<FSCAL> res(3 * n);
 
-      if (isBad(max[v]))
-        smax = format("{}{:>11.2e}{}",c(red),max[v],c(reset));
-      else if (isConcern(max[v]))
-        smax = format("{}{:>11.2e}{}",c(yellow),max[v],c(reset));
-      else
-        smax = format("{}{:>11.2e}{}",c(magenta),max[v],c(reset));
+  policy_f3 cell_pol = policy_f3({cf.ng, cf.ng, 0}, {cf.ngi - cf.ng, cf.ngj - cf.ng, 1});
+  if (cf.ndim == 3)
+    cell_pol = policy_f3({cf.ng, cf.ng, cf.ng}, {cf.ngi - cf.ng, cf.ngj - cf.ng, cf.ngk - cf.ng});
 
-      cout << fmt::format("{: >8}{: <16}{: >11}{: >11}\n","",f->varNames[v],smin,smax);
-      cout << std::flush;
-    }
-  }
+  Kokkos::parallel_reduce(cell_pol, statusReducer(f->var, f->varx, nv, nx), res.data());
+  Kokkos::fence();
 
-  // varx
-  if (cf.ndim == 2) {
-    policy_f cell_pol = policy_f({cf.ng, cf.ng}, {cf.ngi - cf.ng, cf.ngj - cf.ng});
-    for (size_t v = 0; v < f->varxNames.size(); ++v) {
-      Kokkos::parallel_reduce(cell_pol, maxVarFunctor2d(f->varx, v), Kokkos::Max<FSCAL>(max[v]));
-      Kokkos::parallel_reduce(cell_pol, minVarFunctor2d(f->varx, v), Kokkos::Min<FSCAL>(min[v]));
-      Kokkos::fence();
-      #ifdef HAVE_MPI
-        MPI_Allreduce(&max[v], &max_recv[v], 1, MPI_DOUBLE, MPI_MAX, cf.comm);
-        MPI_Allreduce(&min[v], &min_recv[v], 1, MPI_DOUBLE, MPI_MIN, cf.comm);
-        max[v] = max_recv[v];
-        min[v] = min_recv[v];
-      #endif
-    }
-  } else {
-    policy_f3 cell_pol = policy_f3({cf.ng,cf.ng,cf.ng}, {cf.ngi - cf.ng, cf.ngj - cf.ng, cf.ngk-cf.ng});
-    for (size_t v = 0; v < f->varxNames.size(); ++v) {
-      Kokkos::parallel_reduce(cell_pol, maxVarFunctor3d(f->varx, v), Kokkos::Max<FSCAL>(max[v]));
-      Kokkos::parallel_reduce(cell_pol, minVarFunctor3d(f->varx, v), Kokkos::Min<FSCAL>(min[v]));
-      Kokkos::fence();
-      #ifdef HAVE_MPI
-        MPI_Allreduce(&max[v], &max_recv[v], 1, MPI_DOUBLE, MPI_MAX, cf.comm);
-        MPI_Allreduce(&min[v], &min_recv[v], 1, MPI_DOUBLE, MPI_MIN, cf.comm);
-        max[v] = max_recv[v];
-        min[v] = min_recv[v];
-      #endif
-    }
-  }
+#ifdef HAVE_MPI
+  static MPI_Op statusOp = MPI_OP_NULL;
+  if (statusOp == MPI_OP_NULL)
+    MPI_Op_create(&statusReduceOp, 1, &statusOp);
+  MPI_Allreduce(MPI_IN_PLACE, res.data(), 3 * n, MPI_FSCAL, statusOp, cf.comm);
+#endif
 
   if (cf.rank == 0) {
-    for (size_t v = 0; v < f->varxNames.size(); ++v) {
-      if (isBad(min[v]))
-        smin = format("{}{:>11.2e}{}",c(red),min[v],c(reset));
-      else if (isConcern(min[v]))
-        smin = format("{}{:>11.2e}{}",c(yellow),min[v],c(reset));
+    for (int v = 0; v < n; ++v) {
+      FSCAL min = res[v];
+      FSCAL max = res[n + v];
+      size_t nbad = (size_t)res[2 * n + v];
+
+      if (isBad(min))
+        smin = format("{}{:>11.2e}{}",c(red),min,c(reset));
+      else if (isConcern(min))
+        smin = format("{}{:>11.2e}{}",c(yellow),min,c(reset));
       else
-        smin = format("{}{:>11.2e}{}",c(magenta),min[v],c(reset));
+        smin = format("{}{:>11.2e}{}",c(magenta),min,c(reset));
 
-      if (isBad(max[v]))
-        smax = format("{}{:>11.2e}{}",c(red),max[v],c(reset));
-      else if (isConcern(max[v]))
-        smax = format("{}{:>11.2e}{}",c(yellow),max[v],c(reset));
+      if (isBad(max))
+        smax = format("{}{:>11.2e}{}",c(red),max,c(reset));
+      else if (isConcern(max))
+        smax = format("{}{:>11.2e}{}",c(yellow),max,c(reset));
       else
-        smax = format("{}{:>11.2e}{}",c(magenta),max[v],c(reset));
+        smax = format("{}{:>11.2e}{}",c(magenta),max,c(reset));
 
-      cout << fmt::format("{: >8}{: <16}{: >11}{: >11}\n","",f->varxNames[v],smin,smax);
-      cout << std::flush;
+      string name = (v < nv) ? f->varNames[v] : f->varxNames[v - nv];
+      if (nbad > 0)
+        cout << fmt::format("{: >8}{: <16}{: >11}{: >11} {}{} non-finite{}\n","",name,smin,smax,c(red),nbad,c(reset));
+      else
+        cout << fmt::format("{: >8}{: <16}{: >11}{: >11}\n","",name,smin,smax);
     }
+    cout << std::flush;
   }
 }
@@ -0,0 +1,119 @@
+/*
+  Copyright 2019-2021 The University of New Mexico
+
+  This file is part of FIESTA.
+  
+  FIESTA is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+  
+  FIESTA is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+  
+  You should have received a copy of the GNU Lesser General Public License
+  along with FIESTA.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "terrain.hpp"
+#include "h5.hpp"
+#include "log2.hpp"
+#ifdef HAVE_MPI
+#include "mpi.h"
+#endif
+#include <filesystem>
+#include <vector>
+
+// Exchange ng node columns (axis 0) or rows (axis 1) of the surface with the
+// blocks before and after this one.  Neighbouring blocks share their boundary
+// nodes, so the halo past the last node starts at the second node of the next
+// block.  Halos on physical boundaries are left as they are.
+static void exchangeSurface(FS2DH &s, int axis, int nc, int ng, int lower, int upper, struct inputConfig &cf){
+  int len = s.extent(1-axis);
+  int count = ng*len;
+  std::vector<FSCAL> ls(count), lr(count), us(count), ur(count);
+
+  auto at = [&](int a, int b) -> FSCAL& { return (axis == 0) ? s(a,b) : s(b,a); };
+
+  for (int a=0; a<ng; ++a){
+    for (int b=0; b<len; ++b){
+      us[a*len+b] = at(nc+a, b);
+      ls[a*len+b] = at(ng+1+a, b);
+    }
+  }
+
+#ifdef HAVE_MPI
+  MPI_Sendrecv(us.data(), count, MPI_FSCAL, upper, 0, lr.data(), count, MPI_FSCAL, lower, 0, cf.comm, MPI_STATUS_IGNORE);
+  MPI_Sendrecv(ls.data(), count, MPI_FSCAL, lower, 1, ur.data(), count, MPI_FSCAL, upper, 1, cf.comm, MPI_STATUS_IGNORE);
+#else
+  // a single block is its own periodic neighbour
+  lr = us;
+  ur = ls;
+#endif
+
+  for (int a=0; a<ng; ++a){
+    for (int b=0; b<len; ++b){
+      if (lower >= 0) at(a, b) = lr[a*len+b];
+      if (upper >= 0) at(nc+ng+1+a, b) = ur[a*len+b];
+    }
+  }
+}
+
+// Read this block's nodes of the 'Height' dataset in the terrain file, fill
+// in the halo from the neighbouring blocks and copy the surface to the device.
+terrainGrid::terrainGrid(struct inputConfig &cf)
+    : tdx(cf.tdx), tdy(cf.tdy), lid(cf.h), stretch(cf.tstretch), nk(cf.glbl_nck),
+      kOffset(cf.kStart-cf.ng), ng(cf.ng), ngi(cf.ngi), ngj(cf.ngj), ngk(cf.ngk),
+      mirror{cf.xMinus < 0, cf.xPlus < 0, cf.yMinus < 0, cf.yPlus < 0, cf.zMinus < 0, cf.zPlus < 0} {
+
+  if (cf.rank == 0){
+    if (!std::filesystem::exists(cf.terrainName)){
+      Log::error("Terrain file '{}' does not exist.",cf.terrainName);
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  h5Writer<FSCAL> writer;
+#ifdef HAVE_MPI
+  writer.openRead(cf.comm, MPI_INFO_NULL, cf.terrainName);
+#else
+  writer.openRead(cf.terrainName);
+#endif
+
+  std::vector<FSCAL> readV(cf.ni*cf.nj);
+  std::vector<size_t> gridDims  = {cf.globalGridDims[0], cf.globalGridDims[1]};
+  std::vector<size_t> gridCount = {cf.localGridDims[0], cf.localGridDims[1]};
+  std::vector<size_t> offset    = {cf.subdomainOffset[0], cf.subdomainOffset[1]};
+  writer.read("Height", 2, gridDims, gridCount, offset, readV.data());
+  writer.close();
+
+  surface = FS2D("surface", cf.ngi+1, cf.ngj+1);
+  FS2DH surfaceH = Kokkos::create_mirror_view(surface);
+  for (int j=0; j<cf.nj; ++j)
+    for (int i=0; i<cf.ni; ++i)
+      surfaceH(i+ng, j+ng) = readV[(size_t)cf.ni*j+i];
+
+  // x first, so that the y exchange carries the corners
+  exchangeSurface(surfaceH, 0, cf.nci, ng, cf.xMinus, cf.xPlus, cf);
+  exchangeSurface(surfaceH, 1, cf.ncj, ng, cf.yMinus, cf.yPlus, cf);
+
+  Kokkos::deep_copy(surface, surfaceH);
+}
+
+// Compute the node coordinates of this block
+void terrainGrid::nodes(struct inputConfig &cf, FS4D &grid) {
+  terrainGrid tg = *this;
+  int iStart = cf.iStart;
+  int jStart = cf.jStart;
+  int kStart = cf.kStart;
+
+  Kokkos::parallel_for("terrainNodes", policy_f3({0, 0, 0}, {cf.ni, cf.nj, cf.nk}),
+    KOKKOS_LAMBDA(const int i, const int j, const int k) {
+      grid(i, j, k, 0) = tg.tdx*(iStart+i);
+      grid(i, j, k, 1) = tg.tdy*(jStart+j);
+      grid(i, j, k, 2) = tg.height(i, j, kStart+k);
+    });
+  Kokkos::fence();
+}
@@ -0,0 +1,160 @@
+/*
+  Copyright 2019-2021 The University of New Mexico
+
+  This file is part of FIESTA.
+  
+  FIESTA is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+  
+  FIESTA is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+  
+  You should have received a copy of the GNU Lesser General Public License
+  along with FIESTA.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TERRAIN_H
+#define TERRAIN_H
+
+#include "kokkosTypes.hpp"
+#include "input.hpp"
+
+// Terrain following grid.  Nodes sit on columns over a 2D surface height map,
+// x and y uniform with spacing tdx and tdy, and z stretched from the surface
+// up to a flat lid at height h.  Only the surface is stored, with a halo of ng
+// nodes, and node coordinates and metric terms are computed from it when
+// needed.  The surface and the ghost cell mapping are indexed by local cell,
+// so the corners of cell (i,j) are surface nodes (i,j) to (i+1,j+1).
+class terrainGrid {
+  public:
+    terrainGrid(struct inputConfig &);
+    void nodes(struct inputConfig &, FS4D &);
+
+    // fraction of the column height at global node level K, uniform or
+    // clustered toward the surface by the stretching factor
+    KOKKOS_INLINE_FUNCTION
+    FSCAL level(const int K) const {
+      FSCAL eta = (FSCAL)K/nk;
+      if (stretch == 0.0)
+        return eta;
+      return expm1(stretch*eta)/expm1(stretch);
+    }
+
+    // height of local node (i,j) at global level K
+    KOKKOS_INLINE_FUNCTION
+    FSCAL height(const int i, const int j, const int K) const {
+      FSCAL s = surface(i+ng, j+ng);
+      return s + (lid - s)*level(K);
+    }
+
+    // last row of the metric tensor, d(zeta)/d(x,y,z), of a local cell
+    // including ghosts.  The first two rows are (1/tdx,0,0) and (0,1/tdy,0).
+    // Ghost cells past a physical boundary take the metrics of the cell
+    // mirrored into the domain, as the generalized solver does, and cells in
+    // neighbouring or periodic blocks the metrics of that cell.
+    KOKKOS_INLINE_FUNCTION
+    void metrics(int i, int j, int k, FSCAL m[3]) const {
+      if (mirror[0] && i < ng)       i = 2*ng-1-i;
+      if (mirror[1] && i >= ngi-ng)  i = 2*(ngi-ng)-1-i;
+      if (mirror[2] && j < ng)       j = 2*ng-1-j;
+      if (mirror[3] && j >= ngj-ng)  j = 2*(ngj-ng)-1-j;
+      if (mirror[4] && k < ng)       k = 2*ng-1-k;
+      if (mirror[5] && k >= ngk-ng)  k = 2*(ngk-ng)-1-k;
+
+      int K = ((kOffset+k) % nk + nk) % nk;
+      FSCAL s0 = level(K);
+      FSCAL s1 = level(K+1);
+      FSCAL sb = 1.0 - 0.5*(s0+s1);
+
+      FSCAL h00 = surface(i,j);
+      FSCAL h10 = surface(i+1,j);
+      FSCAL h01 = surface(i,j+1);
+      FSCAL h11 = surface(i+1,j+1);
+
+      // differences of the face averaged heights across the cell
+      FSCAL zxi = 0.5*sb*((h10+h11) - (h00+h01));
+      FSCAL zet = 0.5*sb*((h01+h11) - (h00+h10));
+      FSCAL zzt = (lid - 0.25*(h00+h10+h01+h11))*(s1-s0);
+
+      m[0] = -zxi/(tdx*zzt);
+      m[1] = -zet/(tdy*zzt);
+      m[2] = 1.0/zzt;
+    }
+
+    FSCAL tdx, tdy;
+
+  private:
+    FS2D surface;       // surface height at nodes, with a halo of ng nodes
+    FSCAL lid;          // height of the top of the domain
+    FSCAL stretch;      // vertical stretching factor, 0 for uniform levels
+    int nk;             // number of global cells in z
+    int kOffset;        // global cell index of local cell 0, ghosts included
+    int ng, ngi, ngj, ngk;
+    bool mirror[6];     // physical boundaries on the x, y and z min/max sides
+};
+
+// contravariant velocity from the momentum and the terrain metrics
+struct computeTerrainVelocity {
+  FS4D var;
+  terrainGrid tg;
+  FS3D rho;
+  FS4D vel;
+
+  computeTerrainVelocity(FS4D var_, terrainGrid tg_, FS3D r_, FS4D v_)
+      : var(var_), tg(tg_), rho(r_), vel(v_) {}
+
+  KOKKOS_INLINE_FUNCTION
+  void operator()(const int i, const int j, const int k) const {
+    FSCAL m[3];
+    tg.metrics(i, j, k, m);
+
+    vel(i, j, k, 0) = var(i, j, k, 0) / rho(i, j, k) / tg.tdx;
+    vel(i, j, k, 1) = var(i, j, k, 1) / rho(i, j, k) / tg.tdy;
+    vel(i, j, k, 2) = (m[0] * var(i, j, k, 0) / rho(i, j, k) +
+                       m[1] * var(i, j, k, 1) / rho(i, j, k) +
+                       m[2] * var(i, j, k, 2) / rho(i, j, k));
+  }
+};
+
+// fourth order pressure gradient in computational space, with the zeta
+// metrics of the neighbouring cells computed on the fly
+struct applyTerrainPressureGradient {
+  FS4D dvar;
+  terrainGrid tg;
+  FS3D p;
+
+  applyTerrainPressureGradient(FS4D dvar_, terrainGrid tg_, FS3D p_)
+      : dvar(dvar_), tg(tg_), p(p_) {}
+
+  KOKKOS_INLINE_FUNCTION
+  void operator()(const int i, const int j, const int k) const {
+    FSCAL mm2[3], mm1[3], mp1[3], mp2[3];
+    tg.metrics(i, j, k - 2, mm2);
+    tg.metrics(i, j, k - 1, mm1);
+    tg.metrics(i, j, k + 1, mp1);
+    tg.metrics(i, j, k + 2, mp2);
+
+    FSCAL dxipxi = (p(i - 2, j, k) - 8.0 * p(i - 1, j, k) +
+                    8.0 * p(i + 1, j, k) - p(i + 2, j, k)) /
+                   (12.0 * tg.tdx);
+    FSCAL detpet = (p(i, j - 2, k) - 8.0 * p(i, j - 1, k) +
+                    8.0 * p(i, j + 1, k) - p(i, j + 2, k)) /
+                   (12.0 * tg.tdy);
+
+    FSCAL dztpzt[3];
+    for (int d = 0; d < 3; ++d)
+      dztpzt[d] = (p(i, j, k - 2) * mm2[d] - 8.0 * p(i, j, k - 1) * mm1[d] +
+                   8.0 * p(i, j, k + 1) * mp1[d] - p(i, j, k + 2) * mp2[d]) /
+                  (12.0);
+
+    dvar(i, j, k, 0) = (dvar(i, j, k, 0) - (dxipxi + dztpzt[0]));
+    dvar(i, j, k, 1) = (dvar(i, j, k, 1) - (detpet + dztpzt[1]));
+    dvar(i, j, k, 2) = (dvar(i, j, k, 2) - dztpzt[2]);
+  }
+};
+
+#endif
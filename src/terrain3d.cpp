@@ -0,0 +1,157 @@
+/*
+  Copyright 2019-2021 The University of New Mexico
+
+  This file is part of FIESTA.
+  
+  FIESTA is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+  
+  FIESTA is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+  
+  You should have received a copy of the GNU Lesser General Public License
+  along with FIESTA.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "kokkosTypes.hpp"
+#include <cassert>
+#include "input.hpp"
+#include "Kokkos_Core.hpp"
+#include "advect.hpp"
+#include "bc.hpp"
+#include "flux.hpp"
+#include "terrain3d.hpp"
+#include "secondary.hpp"
+#include "velocity.hpp"
+
+terrain3d_func::terrain3d_func(struct inputConfig &cf_) : rk_func(cf_), tg(cf_) {
+
+  // Allocate all device arrays here
+  grid    = FS4D("coords",  cf.ni,  cf.nj,  cf.nk,  3);      // Grid Coords
+  var     = FS4D("var",     cf.ngi, cf.ngj, cf.ngk, cf.nvt); // Primary  Array
+  tmp1    = FS4D("tmp1",    cf.ngi, cf.ngj, cf.ngk, cf.nvt); // Temporary Array
+  dvar    = FS4D("dvar",    cf.ngi, cf.ngj, cf.ngk, cf.nvt); // RHS Output
+  rho     = FS3D("rho",     cf.ngi, cf.ngj, cf.ngk);         // Total Density
+  p       = FS3D("p",       cf.ngi, cf.ngj, cf.ngk);         // Pressure
+  T       = FS3D("T",       cf.ngi, cf.ngj, cf.ngk);         // Temperature
+  tvel    = FS4D("tvel",    cf.ngi, cf.ngj, cf.ngk,  3);     // Velocity
+  fluxx   = FS3D("fluxx",   cf.ngi, cf.ngj, cf.ngk); // Advective Fluxes in X
+  fluxy   = FS3D("fluxy",   cf.ngi, cf.ngj, cf.ngk); // Advective Fluxes in Y
+  fluxz   = FS3D("fluxz",   cf.ngi, cf.ngj, cf.ngk); // Advective Fluxes in z
+
+  // Create and copy minimal configuration array for data needed
+  // withing Kokkos kernels.
+  cd = FS1D("deviceCF", 6 + cf.ns * 3);
+  FS1DH hostcd = Kokkos::create_mirror_view(cd);
+  Kokkos::deep_copy(hostcd, cd);
+  hostcd(0) = cf.ns; // number of gas species
+  hostcd(1) = cf.dx; // cell size
+  hostcd(2) = cf.dy; // cell size
+  hostcd(3) = cf.dz; // cell size
+  hostcd(4) = cf.nv; // number of flow variables
+  hostcd(5) = cf.ng; // number of flow variables
+
+  // include gas properties for each gas species
+  int sdx = 6;
+  for (int s = 0; s < cf.ns; ++s) {
+    hostcd(sdx) = cf.gamma[s];        // ratio of specific heats
+    hostcd(sdx + 1) = cf.R / cf.M[s]; // species gas comstant
+    hostcd(sdx + 2) = cf.mu[s];       // kinematic viscosity
+    sdx += 3;
+  }
+  Kokkos::deep_copy(cd, hostcd); // copy congifuration array to device
+
+  // Primaty Variable Names
+  varNames.push_back("X-Momentum");
+  varNames.push_back("Y-Momentum");
+  varNames.push_back("Z-Momentum");
+  varNames.push_back("Energy");
+  for (int v=0; v<cf.ns; ++v)
+    varNames.push_back("Density " + cf.speciesName[v]);
+  assert(varNames.size()==(size_t)cf.nvt);
+
+  // Secondary Variable Names
+  varxNames.push_back("X-Velocity");
+  varxNames.push_back("Y-Velocity");
+  varxNames.push_back("Z-Velocity");
+  varxNames.push_back("Pressure");
+  varxNames.push_back("Temperature");
+  varxNames.push_back("Density");
+
+  // Create Secondary Variable Array
+  varx = FS4D("varx",cf.ngi,cf.ngj,cf.ngk,varxNames.size());
+
+  // Create Timers
+  timers["flux"]        = Timer::fiestaTimer("Flux Calculation");
+  timers["pressgrad"]   = Timer::fiestaTimer("Pressure Gradient Calculation");
+  timers["calcSecond"]  = Timer::fiestaTimer("Secondary Variable Calculation");
+  timers["solWrite"]    = Timer::fiestaTimer("Solution Write Time");
+  timers["resWrite"]    = Timer::fiestaTimer("Restart Write Time");
+  timers["statCheck"]   = Timer::fiestaTimer("Status Check");
+  timers["rk"] = Timer::fiestaTimer("Runge Stage Update");
+  timers["halo"] = Timer::fiestaTimer("Halo Exchanges");
+  timers["bc"] = Timer::fiestaTimer("Boundary Conditions");
+};
+
+void terrain3d_func::preStep() {}
+
+void terrain3d_func::postStep() {
+
+  // MDRange Policy for all cells including ghost cells
+  policy_f3 ghost_pol = policy_f3({0, 0, 0}, {cf.ngi, cf.ngj, cf.ngk});
+
+  // Copy secondary variables to extra variables array
+  if (( (cf.write_freq >0) && (cf.t % cf.write_freq == 0) )||
+      ( (cf.stat_freq  >0) && (cf.t % cf.stat_freq  == 0) )||
+      cf.ioThisStep){
+
+      timers["calcSecond"].reset();
+      Kokkos::parallel_for(ghost_pol, calculateRhoPT3D(var, p, rho, T, cd));
+      Kokkos::parallel_for(ghost_pol, computeVelocity3D(var, rho, tvel));
+      Kokkos::parallel_for(ghost_pol, copyExtraVars3D(varx, tvel, p, rho, T));
+      Kokkos::fence();
+      timers["calcSecond"].accumulate();
+
+    }
+}
+
+void terrain3d_func::preSim() {}
+
+void terrain3d_func::postSim() {}
+
+void terrain3d_func::compute() {
+  applyBCs(cf,this);
+  // create range policies
+  policy_f3 ghost_pol = policy_f3({0, 0, 0}, {cf.ngi, cf.ngj, cf.ngk});
+  policy_f3 cell_pol = policy_f3(
+      {cf.ng, cf.ng, cf.ng}, {cf.ngi - cf.ng, cf.ngj - cf.ng, cf.ngk - cf.ng});
+  policy_f3 weno_pol =
+      policy_f3({cf.ng - 1, cf.ng - 1, cf.ng - 1},
+                {cf.ngi - cf.ng, cf.ngj - cf.ng, cf.ngk - cf.ng});
+
+  /**** WENO ****/
+  timers["calcSecond"].reset();
+  Kokkos::parallel_for(ghost_pol, calculateRhoPT3D(var, p, rho, T, cd));
+  Kokkos::parallel_for(ghost_pol, computeTerrainVelocity(var, tg, rho, tvel));
+  Kokkos::fence();
+  timers["calcSecond"].accumulate();
+
+  timers["flux"].reset();
+  for (int v = 0; v < cf.nv; ++v) {
+    Kokkos::parallel_for(
+        weno_pol,
+        calculateFluxesG(var, p, rho, tvel, fluxx, fluxy, fluxz, cf.dx, cf.dy, cf.dz, v));
+    Kokkos::parallel_for(cell_pol, advect3D(dvar, varx, fluxx, fluxy, fluxz, v));
+  }
+  Kokkos::fence();
+  timers["flux"].accumulate();
+
+  timers["pressgrad"].reset();
+  Kokkos::parallel_for(cell_pol, applyTerrainPressureGradient(dvar, tg, p));
+  Kokkos::fence();
+  timers["pressgrad"].accumulate();
+}
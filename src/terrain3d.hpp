@@ -0,0 +1,54 @@
+/*
+  Copyright 2019-2021 The University of New Mexico
+
+  This file is part of FIESTA.
+  
+  FIESTA is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+  
+  FIESTA is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+  
+  You should have received a copy of the GNU Lesser General Public License
+  along with FIESTA.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TERRAIN3D_H
+#define TERRAIN3D_H
+
+#include "Kokkos_Core.hpp"
+#include "kokkosTypes.hpp"
+#include "input.hpp"
+#include "rkfunction.hpp"
+#include "terrain.hpp"
+
+// Generalized solver on a terrain following grid.  Metric terms come from
+// the terrain surface as they are needed, in place of a stored metric tensor.
+// The node coordinates in grid are only kept for output, restarts and initial
+// conditions, the solver kernels never read them.
+class terrain3d_func : public rk_func {
+
+public:
+  terrain3d_func(struct inputConfig &cf);
+  void compute();
+  void preStep();
+  void postStep();
+  void preSim();
+  void postSim();
+
+  terrainGrid tg; // Terrain Surface and Vertical Levels
+  FS3D p;         // Pressure
+  FS3D T;         // Temperature
+  FS4D tvel;      // Transformed Velocity
+  FS3D rho;       // Total Density
+  FS3D fluxx;     // Weno Fluxes in X direction
+  FS3D fluxy;     // Weno Fluxes in Y direction
+  FS3D fluxz;     // Weno Fluxes in Z direction
+  FS1D cd;        // Device configuration array
+};
+
+#endif
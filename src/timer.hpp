@@ -23,6 +23,7 @@
 #include <string>
 #include <chrono>
 #include <fmt/core.h>
+#include "trace.hpp"
 
 namespace Timer{
   inline std::string format(double time){
@@ -77,6 +78,8 @@ namespace Timer{
     void accumulate(){
       m_new = std::chrono::high_resolution_clock::now();
       time += std::chrono::duration_cast<std::chrono::duration<double>>(m_new-m_old).count();
+      if (Trace::active())
+        Trace::complete(description, m_old, m_new);
     }
 
     void stop(){
@@ -0,0 +1,226 @@
+/*
+  Copyright 2019-2021 The University of New Mexico
+
+  This file is part of FIESTA.
+  
+  FIESTA is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+  
+  FIESTA is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+  
+  You should have received a copy of the GNU Lesser General Public License
+  along with FIESTA.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "trace.hpp"
+#include "input.hpp"
+#include "log2.hpp"
+#include "fmt/core.h"
+#ifdef HAVE_MPI
+#include "mpi.h"
+#endif
+#include <climits>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+  struct event {
+    int name;       // index into the interned names
+    int thread;
+    int step;
+    double start;   // microseconds since the trace origin
+    double duration;
+  };
+
+  struct tracer {
+    std::mutex lock;  // the I/O thread records its jobs
+    std::vector<event> ring;
+    size_t head = 0;      // next slot to write
+    size_t recorded = 0;  // events recorded in the window, including overwritten ones
+    std::vector<std::string> names;
+    std::map<std::string,int> nameIndex;
+    std::map<std::thread::id,int> threads;
+    Trace::clock::time_point origin;
+    int step = 0;
+    int steps = 0;
+    int first = -1, last = -1;  // traced steps, first inclusive and last exclusive
+    bool written = false;
+  };
+
+  tracer &state(){
+    static tracer *t = new tracer;
+    return *t;
+  }
+
+  // regions begun and not yet ended on this thread.  Every begin pushes an
+  // entry so begin and end stay paired, and regions begun while tracing was
+  // inactive are marked so they are not recorded.
+  struct region {
+    std::string name;
+    Trace::clock::time_point start;
+    bool traced;
+  };
+  thread_local std::vector<region> regions;
+
+  std::string escape(const std::string &s){
+    std::string e;
+    for (char ch : s){
+      if (ch == '"' || ch == '\\') e += '\\';
+      e += ch;
+    }
+    return e;
+  }
+
+  // this rank's events, oldest first, as comma separated trace events
+  std::string serialize(tracer &tr, int rank){
+    std::string out = fmt::format("{{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": {}, \"args\": {{\"name\": \"rank {}\"}}}}",rank,rank);
+    for (auto& th : tr.threads)
+      out += fmt::format(",\n{{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": {}, \"tid\": {}, \"args\": {{\"name\": \"{}\"}}}}",
+                         rank,th.second,th.second == 0 ? "main" : fmt::format("thread {}",th.second));
+    size_t n = std::min(tr.recorded,tr.ring.size());
+    size_t oldest = (tr.recorded > tr.ring.size()) ? tr.head : 0;
+    for (size_t i = 0; i < n; ++i){
+      const event &e = tr.ring[(oldest+i) % tr.ring.size()];
+      out += fmt::format(",\n{{\"name\": \"{}\", \"ph\": \"X\", \"pid\": {}, \"tid\": {}, \"ts\": {:.3f}, \"dur\": {:.3f}, \"args\": {{\"step\": {}}}}}",
+                         escape(tr.names[e.name]),rank,e.thread,e.start,e.duration,e.step);
+    }
+    return out;
+  }
+
+  // Gather the events of every rank to rank 0 one rank at a time and write
+  // them to a single trace file, with a process for each rank
+  void write(struct inputConfig &cf){
+    tracer &tr = state();
+    std::string mine;
+    unsigned long dropped;
+    {
+      std::lock_guard<std::mutex> guard(tr.lock);
+      mine = serialize(tr,cf.rank);
+      dropped = (tr.recorded > tr.ring.size()) ? tr.recorded - tr.ring.size() : 0;
+      tr.written = true;
+    }
+#ifdef HAVE_MPI
+    unsigned long maxDropped = dropped;
+    MPI_Reduce(&dropped, &maxDropped, 1, MPI_UNSIGNED_LONG, MPI_MAX, 0, cf.comm);
+    dropped = maxDropped;
+#endif
+
+    std::string fname = fmt::format("{}/{}.json",cf.pathName,cf.traceName);
+    if (cf.rank == 0){
+      FILE *out = fopen(fname.c_str(), "w");
+      if (!out)
+        Log::warning("Could not write trace '{}'",fname);
+      if (out) fmt::print(out,"{{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n{}",mine);
+#ifdef HAVE_MPI
+      for (int r = 1; r < cf.numProcs; ++r){
+        unsigned long bytes;
+        MPI_Recv(&bytes, 1, MPI_UNSIGNED_LONG, r, 0, cf.comm, MPI_STATUS_IGNORE);
+        std::string theirs(bytes,' ');
+        for (unsigned long off = 0; off < bytes; off += INT_MAX)
+          MPI_Recv(&theirs[off], std::min<unsigned long>(INT_MAX,bytes-off), MPI_CHAR, r, 1, cf.comm, MPI_STATUS_IGNORE);
+        if (out) fmt::print(out,",\n{}",theirs);
+      }
+#endif
+      if (out){
+        fmt::print(out,"\n]}}\n");
+        fclose(out);
+        Log::message("Wrote trace of steps {} to {} to '{}'",tr.first,std::min(tr.last,tr.step+1)-1,fname);
+      }
+      if (dropped > 0)
+        Log::warning("Trace ring of {} events overflowed, up to {} of the oldest events on a rank were dropped",
+                     tr.ring.size(),dropped);
+    }
+#ifdef HAVE_MPI
+    else{
+      unsigned long bytes = mine.size();
+      MPI_Send(&bytes, 1, MPI_UNSIGNED_LONG, 0, 0, cf.comm);
+      for (unsigned long off = 0; off < bytes; off += INT_MAX)
+        MPI_Send(&mine[off], std::min<unsigned long>(INT_MAX,bytes-off), MPI_CHAR, 0, 1, cf.comm);
+    }
+#endif
+  }
+}
+
+// Set up the traced window and a common time origin on all ranks
+void Trace::configure(struct inputConfig &cf){
+  if (cf.traceSteps <= 0) return;
+  tracer &tr = state();
+  tr.ring.resize(cf.traceEvents);
+  tr.steps = cf.traceSteps;
+  tr.first = cf.traceStart;
+  tr.threads[std::this_thread::get_id()] = 0;
+#ifdef HAVE_MPI
+  MPI_Barrier(cf.comm);
+#endif
+  tr.origin = clock::now();
+}
+
+void Trace::step(struct inputConfig &cf, int t){
+  tracer &tr = state();
+  if (tr.ring.empty() || tr.written) return;
+  {
+    // the I/O thread reads the step when it records its jobs
+    std::lock_guard<std::mutex> guard(tr.lock);
+    tr.step = t;
+  }
+  // the window starts with the first step of the run unless a start is given
+  if (tr.first < 0)
+    tr.first = t;
+  tr.last = tr.first + tr.steps;
+  active() = (t >= tr.first && t < tr.last);
+  if (t == tr.last)
+    write(cf);
+}
+
+void Trace::finish(struct inputConfig &cf){
+  tracer &tr = state();
+  active() = false;
+  if (!tr.ring.empty() && !tr.written && tr.first >= 0 && tr.step >= tr.first)
+    write(cf);
+}
+
+void Trace::complete(const std::string &name, clock::time_point start, clock::time_point stop){
+  tracer &tr = state();
+  std::lock_guard<std::mutex> guard(tr.lock);
+  auto nit = tr.nameIndex.find(name);
+  if (nit == tr.nameIndex.end()){
+    nit = tr.nameIndex.emplace(name,tr.names.size()).first;
+    tr.names.push_back(name);
+  }
+  auto tit = tr.threads.find(std::this_thread::get_id());
+  if (tit == tr.threads.end())
+    tit = tr.threads.emplace(std::this_thread::get_id(),tr.threads.size()).first;
+
+  event &e = tr.ring[tr.head];
+  e.name = nit->second;
+  e.thread = tit->second;
+  e.step = tr.step;
+  e.start = std::chrono::duration<double,std::micro>(start - tr.origin).count();
+  e.duration = std::chrono::duration<double,std::micro>(stop - start).count();
+  tr.head = (tr.head + 1) % tr.ring.size();
+  ++tr.recorded;
+}
+
+void Trace::begin(const std::string &name){
+  if (active())
+    regions.push_back({name,clock::now(),true});
+  else
+    regions.push_back({std::string(),clock::time_point(),false});
+}
+
+void Trace::end(){
+  if (regions.empty()) return;
+  clock::time_point stop = clock::now();
+  if (regions.back().traced && active())
+    complete(regions.back().name,regions.back().start,stop);
+  regions.pop_back();
+}
@@ -0,0 +1,59 @@
+/*
+  Copyright 2019-2021 The University of New Mexico
+
+  This file is part of FIESTA.
+  
+  FIESTA is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+  
+  FIESTA is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+  
+  You should have received a copy of the GNU Lesser General Public License
+  along with FIESTA.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+struct inputConfig;
+
+// Timeline of named regions on each rank, exported as Chrome trace events for
+// Perfetto or chrome://tracing.  Regions are recorded into a fixed ring of
+// events while a window of steps is traced, and the rings of all ranks are
+// written to one file when the window closes.  Outside the window recording
+// is a single branch.
+namespace Trace {
+  using clock = std::chrono::high_resolution_clock;
+
+  // true while the current step is in the traced window
+  inline std::atomic<bool>& active(){
+    static std::atomic<bool> a(false);
+    return a;
+  }
+
+  void configure(struct inputConfig &cf);
+
+  // open or close the window at the start of step t
+  void step(struct inputConfig &cf, int t);
+
+  // write the trace if the run ended inside the window
+  void finish(struct inputConfig &cf);
+
+  // record a region that has ended
+  void complete(const std::string &name, clock::time_point start, clock::time_point stop);
+
+  // record a region from begin to the matching end on this thread
+  void begin(const std::string &name);
+  void end();
+}
+
+#endif
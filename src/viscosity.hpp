@@ -22,6 +22,8 @@
 #ifndef VISCOSOTY_HPP
 #define VISCOSOTY_HPP
 
+#include "rectilinear.hpp"
+
 struct calculateStressTensor2dv {
   FS4D var;
   FS2D rho;
@@ -661,4 +663,90 @@ struct applyViscousTermz3dv {
     dvar(i,j,k,3) += d;
   }
 };
+
+// Stress tensor on the faces between cells (i,j,k) and their neighbours along
+// axis dir of a rectilinear grid.  Normal derivatives are taken across the
+// face and tangential ones from the averages of the two cells on either side,
+// each divided by the distance between the cell centers they span.
+struct calculateRectStressTensor3dv {
+  FS4D var;
+  FS3D rho;
+  FS4D vel;
+  FS4D stress;
+  rectGrid rg;
+  Kokkos::View<FSCAL *> cd;
+  int dir;
+
+  calculateRectStressTensor3dv(FS4D var_, FS3D rho_, FS4D v_, FS4D str_, rectGrid rg_,
+                               Kokkos::View<FSCAL *> cd_, int dir_)
+      : var(var_), rho(rho_), vel(v_), stress(str_), rg(rg_), cd(cd_), dir(dir_) {}
+
+  KOKKOS_INLINE_FUNCTION
+  void operator()(const int i, const int j, const int k) const {
+    int ns = (int)cd(0);
+    int c[3] = {i, j, k};
+    int e[3] = {dir == 0, dir == 1, dir == 2};
+    FSCAL g[3][3];  // g[a][w] = d(vel w)/d(x a)
+    FSCAL mu;
+
+    mu = 0.0;
+    for (int s=0; s<ns; ++s){
+        mu += ((var(i+e[0],j+e[1],k+e[2],4+s)/rho(i+e[0],j+e[1],k+e[2]) + var(i,j,k,4+s)/rho(i,j,k))/2.0)*cd(6+3*s+2);
+    }
+
+    for (int a=0; a<3; ++a){
+      if (a == dir){
+        FSCAL d = rg.face(a,c[a]);
+        for (int w=0; w<3; ++w)
+          g[a][w] = (vel(i+e[0],j+e[1],k+e[2],w) - vel(i,j,k,w))/d;
+      }else{
+        int ia = (a == 0), ja = (a == 1), ka = (a == 2);
+        FSCAL d = 4.0*rg.span(a,c[a]);
+        for (int w=0; w<3; ++w)
+          g[a][w] = ( (vel(i+e[0]+ia,j+e[1]+ja,k+e[2]+ka,w)+vel(i+ia,j+ja,k+ka,w))
+                     -(vel(i+e[0]-ia,j+e[1]-ja,k+e[2]-ka,w)+vel(i-ia,j-ja,k-ka,w)) )/d;
+      }
+    }
+
+    stress(i,j,k,0) = (2.0 / 3.0) * mu * (2.0 * g[0][0] - g[1][1] - g[2][2]);
+    stress(i,j,k,1) = (2.0 / 3.0) * mu * (2.0 * g[1][1] - g[0][0] - g[2][2]);
+    stress(i,j,k,2) = (2.0 / 3.0) * mu * (2.0 * g[2][2] - g[0][0] - g[1][1]);
+    stress(i,j,k,3) = mu*(g[1][0] + g[0][1]);
+    stress(i,j,k,4) = mu*(g[2][0] + g[0][2]);
+    stress(i,j,k,5) = mu*(g[2][1] + g[1][2]);
+  }
+};
+
+// Divergence of the stress on the faces along axis dir over the width of a
+// rectilinear cell, and the work it does
+struct applyRectViscousTerm3dv {
+  FS4D dvar;
+  FS4D vel;
+  FS4D stress;
+  rectGrid rg;
+  int dir;
+
+  applyRectViscousTerm3dv(FS4D dvar_, FS4D vel_, FS4D str_, rectGrid rg_, int dir_)
+      : dvar(dvar_), vel(vel_), stress(str_), rg(rg_), dir(dir_) {}
+
+  KOKKOS_INLINE_FUNCTION
+  void operator()(const int i, const int j, const int k) const {
+    // stress components acting on the faces along each axis
+    const int row[3][3] = {{0,3,4},{3,1,5},{4,5,2}};
+    int c[3] = {i, j, k};
+    int ih = (dir == 0), jh = (dir == 1), kh = (dir == 2);
+    FSCAL d = rg.width(dir,c[dir]);
+    FSCAL work = 0.0;
+
+    for (int w=0; w<3; ++w){
+      FSCAL sr = stress(i,j,k,row[dir][w]);
+      FSCAL sl = stress(i-ih,j-jh,k-kh,row[dir][w]);
+      FSCAL ur = (vel(i+ih,j+jh,k+kh,w)+vel(i,j,k,w))/2.0;
+      FSCAL ul = (vel(i-ih,j-jh,k-kh,w)+vel(i,j,k,w))/2.0;
+      dvar(i,j,k,w) += (sr - sl)/d;
+      work += (ur*sr - ul*sl)/d;
+    }
+    dvar(i,j,k,3) += work;
+  }
+};
 #endif
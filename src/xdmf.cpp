@@ -41,9 +41,60 @@ void writeXMFDataItem(FILE* xmf, string path, int ndim, size_t *dims){
   fprintf(xmf, "        %s\n", path.c_str());
   fprintf(xmf, "       </DataItem>\n");
 }
-void writeXMF(string fname, string hname, int gridType, FSCAL time,
+
+// Reference one field of a file.  With the combined layout all fields of a
+// group live in one dataset with the field index slowest, and in a time series
+// file the entry index is slower still, so the field is selected with a
+// hyperslab of that dataset.
+void writeXMFField(FILE* xmf, string hname, string group, string name, bool combined, int idx, int nfields,
+                   int ndim, size_t *dims, int entry=-1, size_t nentries=0){
+  vector<size_t> lead, leadDims;
+  if (entry >= 0){
+    lead.push_back(entry);
+    leadDims.push_back(nentries);
+  }
+  if (combined){
+    lead.push_back(idx);
+    leadDims.push_back(nfields);
+  }
+
+  if (lead.empty()){
+    writeXMFDataItem(xmf, fmt::format("{}:/{}/{}",hname,group,name), ndim, dims);
+    return;
+  }
+
+  string fdims, start, stride, count, full;
+  for (size_t i=0; i<lead.size(); ++i){
+    start  += fmt::format(" {}",lead[i]);
+    stride += " 1";
+    count  += " 1";
+    full   += fmt::format(" {}",leadDims[i]);
+  }
+  for (int i=0; i<ndim; ++i){
+    fdims  += fmt::format(" {}",dims[i]);
+    start  += " 0";
+    stride += " 1";
+    count  += fmt::format(" {}",dims[i]);
+    full   += fmt::format(" {}",dims[i]);
+  }
+
+  fprintf(xmf, "       <DataItem ItemType=\"HyperSlab\" Dimensions=\"%s\" Type=\"HyperSlab\">\n",fdims.substr(1).c_str());
+  fprintf(xmf, "        <DataItem Dimensions=\"3 %zu\" Format=\"XML\">\n",ndim+lead.size());
+  fprintf(xmf, "         %s\n",start.substr(1).c_str());
+  fprintf(xmf, "         %s\n",stride.substr(1).c_str());
+  fprintf(xmf, "         %s\n",count.substr(1).c_str());
+  fprintf(xmf, "        </DataItem>\n");
+  fprintf(xmf, "        <DataItem Dimensions=\"%s\" NumberType=\"Float\" " "Precision=\"4\" Format=\"HDF\">\n",full.substr(1).c_str());
+  fprintf(xmf, "         %s:/%s/%s\n",hname.c_str(),group.c_str(),name.c_str());
+  fprintf(xmf, "        </DataItem>\n");
+  fprintf(xmf, "       </DataItem>\n");
+}
+
+// Write one uniform grid, with the fields of one entry when the file holds a
+// time series
+static void writeXMFGrid(FILE* xmf, string hname, int gridType, FSCAL time, int entry, size_t nentries,
                int ndim, size_t *in_dims, vector<FSCAL> origin, vector<FSCAL> dx, int nvt, bool writeVarx,
-               vector<string> vNames, vector<string> vxNames, std::map<std::string,FS4D> &dgmap){
+               vector<string> vNames, vector<string> vxNames, vector<string> dgNames, bool combined, bool momentum){
 
     size_t gdims[ndim];
     size_t dims[ndim];
@@ -53,17 +104,15 @@ void writeXMF(string fname, string hname, int gridType, FSCAL time,
     }
     //for (int i : dims) gdims.push_back(i+1);
 
-    stringstream path;
-
-    FILE *xmf = 0;
-    xmf = fopen(fname.c_str(), "w");
-
-    // Header
-    fprintf(xmf, "<?xml version=\"1.0\" ?>\n");
-    fprintf(xmf, "<!DOCTYPE Xdmf SYSTEM \"Xdmf.dtd\" []>\n");
-    fprintf(xmf, "<Xdmf Version=\"3.0\">\n");
-    fprintf(xmf, " <Domain>\n");
-
+    // field indexes within a combined dataset
+    int nfields = nvt + dgNames.size()*nvt;
+    int vxStart = nvt;
+    int dgStart = nvt;
+    if (writeVarx){
+      nfields += vxNames.size();
+      dgStart += vxNames.size();
+    }
+    string sol = combined ? "Fields" : "";
 
     // Grid Header
     fprintf(xmf, "   <Grid Name=\"mesh1\" GridType=\"Uniform\">\n");
@@ -105,34 +154,39 @@ void writeXMF(string fname, string hname, int gridType, FSCAL time,
       // Grid Coordinate Arrays
       for (int d=0; d<ndim; ++d){
         //for (int d : actDims){
-        path.str("");
-        path << hname << ":/Grid/Dimension" << d;
-        writeXMFDataItem(xmf, path.str(), ndim, gdims);
+        if (combined)
+          writeXMFField(xmf, hname, "Grid", "Coordinates", true, d, ndim, ndim, gdims);
+        else
+          writeXMFField(xmf, hname, "Grid", fmt::format("Dimension{}",d), false, d, ndim, ndim, gdims);
       }
       fprintf(xmf, "     </Geometry>\n");
     }
 
-    // Momentum Vector
-    fprintf(xmf, "     <Attribute Name=\"Momentum\" AttributeType=\"Vector\" " "Center=\"Cell\">\n");
-    if (ndim == 1)
-      fprintf(xmf, "      <DataItem Dimensions=\"%zu 1\" Function=\"JOIN($0)\" " "ItemType=\"Function\">\n",dims[0]);
-    else if (ndim == 2)
-      fprintf(xmf, "      <DataItem Dimensions=\"%zu %zu 2\" Function=\"JOIN($0,$1)\" " "ItemType=\"Function\">\n",dims[0],dims[1]);
-    else
-      fprintf(xmf, "      <DataItem Dimensions=\"%zu %zu %zu 3\" Function=\"JOIN($0,$1,$2)\" " "ItemType=\"Function\">\n", dims[0], dims[1],dims[2]);
+    // Momentum Vector, when the leading fields are the momentum components
+    int firstScalar = 0;
+    if (momentum){
+      fprintf(xmf, "     <Attribute Name=\"Momentum\" AttributeType=\"Vector\" " "Center=\"Cell\">\n");
+      if (ndim == 1)
+        fprintf(xmf, "      <DataItem Dimensions=\"%zu 1\" Function=\"JOIN($0)\" " "ItemType=\"Function\">\n",dims[0]);
+      else if (ndim == 2)
+        fprintf(xmf, "      <DataItem Dimensions=\"%zu %zu 2\" Function=\"JOIN($0,$1)\" " "ItemType=\"Function\">\n",dims[0],dims[1]);
+      else
+        fprintf(xmf, "      <DataItem Dimensions=\"%zu %zu %zu 3\" Function=\"JOIN($0,$1,$2)\" " "ItemType=\"Function\">\n", dims[0], dims[1],dims[2]);
 
-    writeXMFDataItem(xmf, fmt::format("{}:/Solution/{}",hname,vNames[0]), ndim, dims);
-    if (ndim >= 1) writeXMFDataItem(xmf, fmt::format("{}:/Solution/{}",hname,vNames[1]), ndim, dims);
-    if (ndim >= 2) writeXMFDataItem(xmf, fmt::format("{}:/Solution/{}",hname,vNames[2]), ndim, dims);
+      writeXMFField(xmf, hname, "Solution", combined ? sol : vNames[0], combined, 0, nfields, ndim, dims, entry, nentries);
+      if (ndim >= 1) writeXMFField(xmf, hname, "Solution", combined ? sol : vNames[1], combined, 1, nfields, ndim, dims, entry, nentries);
+      if (ndim >= 2) writeXMFField(xmf, hname, "Solution", combined ? sol : vNames[2], combined, 2, nfields, ndim, dims, entry, nentries);
 
-    fprintf(xmf, "      </DataItem>\n");
-    fprintf(xmf, "     </Attribute>\n");
+      fprintf(xmf, "      </DataItem>\n");
+      fprintf(xmf, "     </Attribute>\n");
+      firstScalar = ndim;
+    }
 
     // Other Variables
 
-    for (int var = ndim; var < nvt; ++var) {
+    for (int var = firstScalar; var < nvt; ++var) {
       fprintf(xmf, "     <Attribute Name=\"%s\" AttributeType=\"Scalar\" " "Center=\"Cell\">\n",vNames[var].c_str());
-      writeXMFDataItem(xmf, fmt::format("{}:/Solution/{}",hname,vNames[var]), ndim, dims);
+      writeXMFField(xmf, hname, "Solution", combined ? sol : vNames[var], combined, var, nfields, ndim, dims, entry, nentries);
       fprintf(xmf, "     </Attribute>\n");
     }
 
@@ -146,30 +200,71 @@ void writeXMF(string fname, string hname, int gridType, FSCAL time,
       else
         fprintf(xmf, "      <DataItem Dimensions=\"%zu %zu %zu 3\" Function=\"JOIN($0,$1,$2)\" " "ItemType=\"Function\">\n", dims[0], dims[1],dims[2]);
 
-      writeXMFDataItem(xmf, fmt::format("{}:/Solution/{}",hname,vxNames[0]), ndim, dims);
-      if (ndim >= 1) writeXMFDataItem(xmf, fmt::format("{}:/Solution/{}",hname,vxNames[1]), ndim, dims);
-      if (ndim >= 2) writeXMFDataItem(xmf, fmt::format("{}:/Solution/{}",hname,vxNames[2]), ndim, dims);
+      writeXMFField(xmf, hname, "Solution", combined ? sol : vxNames[0], combined, vxStart, nfields, ndim, dims, entry, nentries);
+      if (ndim >= 1) writeXMFField(xmf, hname, "Solution", combined ? sol : vxNames[1], combined, vxStart+1, nfields, ndim, dims, entry, nentries);
+      if (ndim >= 2) writeXMFField(xmf, hname, "Solution", combined ? sol : vxNames[2], combined, vxStart+2, nfields, ndim, dims, entry, nentries);
       fprintf(xmf, "      </DataItem>\n");
       fprintf(xmf, "     </Attribute>\n");
 
       // Other Extra Variables
       for (size_t var = ndim; var < vxNames.size(); ++var) {
         fprintf(xmf, "     <Attribute Name=\"%s\" AttributeType=\"Scalar\" " "Center=\"Cell\">\n",vxNames[var].c_str());
-        writeXMFDataItem(xmf, fmt::format("{}:/Solution/{}",hname,vxNames[var]), ndim, dims);
+        writeXMFField(xmf, hname, "Solution", combined ? sol : vxNames[var], combined, vxStart+var, nfields, ndim, dims, entry, nentries);
         fprintf(xmf, "     </Attribute>\n");
       }
     }
 
-    for (const auto& [name,data]:dgmap){
+    int dg = dgStart;
+    for (const auto& name : dgNames){
       for (int nv=0;nv<nvt;++nv){
         std::string myname = fmt::format("{}-{}",name,nv);
         fprintf(xmf, "     <Attribute Name=\"%s\" AttributeType=\"Scalar\" " "Center=\"Cell\">\n",myname.c_str());
-        writeXMFDataItem(xmf, fmt::format("{}:/Solution/{}",hname,myname), ndim, dims);
+        writeXMFField(xmf, hname, "Solution", combined ? sol : myname, combined, dg++, nfields, ndim, dims, entry, nentries);
         fprintf(xmf, "     </Attribute>\n");
       }
     }
 
-    // End Field Variables
+    fprintf(xmf, "   </Grid>\n");
+}
+
+void writeXMF(string fname, string hname, int gridType, FSCAL time,
+               int ndim, size_t *in_dims, vector<FSCAL> origin, vector<FSCAL> dx, int nvt, bool writeVarx,
+               vector<string> vNames, vector<string> vxNames, vector<string> dgNames, bool combined, bool momentum){
+
+    FILE *xmf = 0;
+    xmf = fopen(fname.c_str(), "w");
+
+    // Header
+    fprintf(xmf, "<?xml version=\"1.0\" ?>\n");
+    fprintf(xmf, "<!DOCTYPE Xdmf SYSTEM \"Xdmf.dtd\" []>\n");
+    fprintf(xmf, "<Xdmf Version=\"3.0\">\n");
+    fprintf(xmf, " <Domain>\n");
+
+    writeXMFGrid(xmf, hname, gridType, time, -1, 0, ndim, in_dims, origin, dx, nvt, writeVarx, vNames, vxNames, dgNames, combined, momentum);
+
+    fprintf(xmf, " </Domain>\n");
+    fprintf(xmf, "</Xdmf>\n");
+    fclose(xmf);
+}
+
+// Write a temporal collection with one grid for each entry of a time series
+// file
+void writeXMFSeries(string fname, string hname, int gridType, vector<FSCAL> times,
+               int ndim, size_t *in_dims, vector<FSCAL> origin, vector<FSCAL> dx, int nvt, bool writeVarx,
+               vector<string> vNames, vector<string> vxNames, vector<string> dgNames, bool combined, bool momentum){
+
+    FILE *xmf = 0;
+    xmf = fopen(fname.c_str(), "w");
+
+    // Header
+    fprintf(xmf, "<?xml version=\"1.0\" ?>\n");
+    fprintf(xmf, "<!DOCTYPE Xdmf SYSTEM \"Xdmf.dtd\" []>\n");
+    fprintf(xmf, "<Xdmf Version=\"3.0\">\n");
+    fprintf(xmf, " <Domain>\n");
+
+    fprintf(xmf, "   <Grid Name=\"series\" GridType=\"Collection\" CollectionType=\"Temporal\">\n");
+    for (size_t e=0; e<times.size(); ++e)
+      writeXMFGrid(xmf, hname, gridType, times[e], e, times.size(), ndim, in_dims, origin, dx, nvt, writeVarx, vNames, vxNames, dgNames, combined, momentum);
     fprintf(xmf, "   </Grid>\n");
 
     fprintf(xmf, " </Domain>\n");
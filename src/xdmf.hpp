@@ -29,6 +29,7 @@
 
 using namespace std;
 void writeXMFDataItem(FILE*, string, int, vector<int> &);
-void writeXMF(string, string, int, FSCAL, int, size_t*, vector<FSCAL>, vector<FSCAL>, int, bool, vector<string>, vector<string>, std::map<std::string,FS4D>&);
+void writeXMF(string, string, int, FSCAL, int, size_t*, vector<FSCAL>, vector<FSCAL>, int, bool, vector<string>, vector<string>, vector<string>, bool, bool);
+void writeXMFSeries(string, string, int, vector<FSCAL>, int, size_t*, vector<FSCAL>, vector<FSCAL>, int, bool, vector<string>, vector<string>, vector<string>, bool, bool);
 
 #endif
@@ -0,0 +1,169 @@
+#include <cassert>
+#include "fiesta.hpp"
+#include "input.hpp"
+#include <vector>
+#include "mpi.hpp"
+#include "rkfunction.hpp"
+#include "cart3d.hpp"
+#include "checkpoint.hpp"
+#include "staging.hpp"
+#include "iothread.hpp"
+#include <iostream>
+#include <filesystem>
+#include "log2.hpp"
+#include "fmt/core.h"
+
+// fill var with a pattern unique to the rank and step
+void fill(struct inputConfig &cf, std::unique_ptr<class rk_func> &f, int t){
+  FS4DH varH = Kokkos::create_mirror_view(f->var);
+  for (size_t i=0; i<varH.extent(0); ++i)
+    for (size_t j=0; j<varH.extent(1); ++j)
+      for (size_t k=0; k<varH.extent(2); ++k)
+        for (size_t v=0; v<varH.extent(3); ++v)
+          varH(i,j,k,v) = 1000*t + 100*cf.rank + 10*v + i + 0.5*j + 0.25*k;
+  Kokkos::deep_copy(f->var,varH);
+}
+
+// true if var holds the pattern of the given step on every rank
+bool matches(struct inputConfig &cf, std::unique_ptr<class rk_func> &f, int t){
+  FS4DH varH = Kokkos::create_mirror_view(f->var);
+  Kokkos::deep_copy(varH,f->var);
+  int ok = 1;
+  for (size_t i=0; i<varH.extent(0); ++i)
+    for (size_t j=0; j<varH.extent(1); ++j)
+      for (size_t k=0; k<varH.extent(2); ++k)
+        for (size_t v=0; v<varH.extent(3); ++v)
+          ok &= varH(i,j,k,v) == 1000*t + 100*cf.rank + 10*v + i + 0.5*j + 0.25*k;
+  MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_MIN, cf.comm);
+  return ok;
+}
+
+int main(int argc, char* argv[]) {
+  {
+    struct inputConfig cf;
+
+    cf.ndim=3;
+    cf.glbl_nci=6;
+    cf.glbl_ncj=6;
+    cf.glbl_nck=6;
+    cf.ng=3;
+    cf.xPer=0;
+    cf.yPer=0;
+    cf.zPer=0;
+    cf.nvt=5;
+    cf.nv=5;
+
+    cf.ceq=false;
+    cf.noise=false;
+    cf.visc=false;
+    cf.buoyancy=false;
+
+    cf.xProcs=2;
+    cf.yProcs=1;
+    cf.zProcs=1;
+
+    cf.dx=1;
+    cf.dy=1;
+    cf.dz=1;
+
+    cf.R = 1;
+    cf.ns=1;
+    cf.speciesName= {"TestAir"};
+    cf.gamma = {1.0};
+    cf.M = {1.0};
+    cf.mu = {1.0};
+
+    Kokkos::InitArguments kokkosArgs;
+    kokkosArgs.ndevices = 1;
+    MPI_Init(NULL,NULL);
+    int temp_rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &temp_rank);
+    Log::Logger(3,0,temp_rank);
+    Kokkos::initialize(kokkosArgs);
+
+    mpi_init(cf);
+    assert(cf.numProcs == 2);
+
+    std::unique_ptr<class rk_func> f = std::make_unique<cart3d_func>(cf);
+
+    // both ranks share the local directory, as ranks on one node would
+    cf.pathName = "checkpoint_recover";
+    cf.checkpointPath = "checkpoint_recover/local";
+    cf.checkpointKeep = 2;
+    cf.checkpointDrain = 0;
+    cf.checkpointPartner = true;
+    cf.staging = std::make_shared<ioStaging>();
+    if (cf.rank == 0)
+      std::filesystem::remove_all(cf.pathName);
+    MPI_Barrier(cf.comm);
+
+    int t;
+    FSCAL time;
+    {
+      checkpointManager ckpt(cf);
+      for (int s=5; s<=15; s+=5){
+        fill(cf,f,s);
+        ckpt.write(cf,f,s,0.1*s);
+      }
+      ioThread::instance().drain();
+      MPI_Barrier(cf.comm);
+
+      // only the newest two generations are kept
+      std::string own = fmt::format("{}/checkpoint-{{}}.{}",cf.checkpointPath,cf.rank);
+      std::string held = fmt::format("{}/partner-{{}}.{}",cf.checkpointPath,1-cf.rank);
+      assert(!std::filesystem::exists(fmt::format(own,5)));
+      assert(std::filesystem::exists(fmt::format(own,10)));
+      assert(std::filesystem::exists(fmt::format(own,15)));
+      assert(!std::filesystem::exists(fmt::format(held,5)));
+      assert(std::filesystem::exists(fmt::format(held,15)));
+    }
+
+    // round trip from each rank's own files
+    {
+      checkpointManager ckpt(cf);
+      fill(cf,f,0);
+      assert(ckpt.recover(cf,f,-1,t,time));
+      assert(t == 15);
+      assert(time == 0.1*15);
+      assert(matches(cf,f,15));
+
+      // nothing newer than the requested step
+      assert(!ckpt.recover(cf,f,15,t,time));
+    }
+    MPI_Barrier(cf.comm);
+
+    // rank 1 loses its own copy and recovers from the one held by rank 0
+    if (cf.rank == 1)
+      std::filesystem::remove(fmt::format("{}/checkpoint-15.1",cf.checkpointPath));
+    MPI_Barrier(cf.comm);
+    {
+      checkpointManager ckpt(cf);
+      fill(cf,f,0);
+      assert(ckpt.recover(cf,f,-1,t,time));
+      assert(t == 15);
+      assert(matches(cf,f,15));
+    }
+    MPI_Barrier(cf.comm);
+
+    // with both copies of step 15 gone, every rank falls back to step 10
+    if (cf.rank == 0)
+      std::filesystem::remove(fmt::format("{}/partner-15.1",cf.checkpointPath));
+    MPI_Barrier(cf.comm);
+    {
+      checkpointManager ckpt(cf);
+      fill(cf,f,0);
+      assert(ckpt.recover(cf,f,-1,t,time));
+      assert(t == 10);
+      assert(time == 0.1*10);
+      assert(matches(cf,f,10));
+    }
+    MPI_Barrier(cf.comm);
+
+    if (cf.rank == 0)
+      std::filesystem::remove_all(cf.pathName);
+  }
+  Kokkos::finalize();
+  MPI_Finalize();
+
+  return 0;
+}
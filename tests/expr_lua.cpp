@@ -0,0 +1,77 @@
+#include "input.hpp"
+#include "expression.hpp"
+#include "log2.hpp"
+#include <array>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <cassert>
+#ifdef HAVE_MPI
+#include "mpi.h"
+#endif
+
+// Evaluate three expressions at the nodes of a small grid on the device and
+// count the values that differ from the equivalent Lua function
+size_t differences(struct inputConfig &cf, std::vector<std::string> values){
+  std::vector<std::string> definitions = {"a = (i - 3)/2", "b = j - 2.5", "c = k*1.5 + 0.25"};
+  expression ex("test", {"i","j","k","d"}, {}, definitions, values, true);
+
+  FS4D grid("grid", cf.ni, cf.nj, cf.nk, 3);
+  ex.grid(cf, grid);
+  FS4DH gridH = Kokkos::create_mirror_view(grid);
+  Kokkos::deep_copy(gridH, grid);
+
+  size_t n = cf.ni*cf.nj*cf.nk;
+  auto point = [&](size_t p){
+    return std::array<FSCAL,3>{(FSCAL)(p % cf.ni), (FSCAL)((p / cf.ni) % cf.nj), (FSCAL)(p / (cf.ni*cf.nj))};
+  };
+  auto result = [&](size_t p, int v){
+    return gridH(p % cf.ni, (p / cf.ni) % cf.nj, p / (cf.ni*cf.nj), v);
+  };
+  size_t differ = ex.compare(n, point, result);
+  std::cout << values[0] << ", " << values[1] << ", " << values[2] << ": " << differ << " differ\n";
+  return differ;
+}
+
+int main(){
+#ifdef HAVE_MPI
+  MPI_Init(NULL,NULL);
+#endif
+  Log::Logger(3,0,0);
+  Kokkos::InitArguments kokkosArgs;
+  Kokkos::initialize(kokkosArgs);
+  {
+    struct inputConfig cf;
+    cf.ndim = 3;
+    cf.ni = 7;
+    cf.nj = 6;
+    cf.nk = 5;
+    cf.iStart = 0;
+    cf.jStart = 0;
+    cf.kStart = 0;
+
+    // floor division and modulo with mixed signs, fractions and zero divisors
+    assert(differences(cf, {"a // b", "a % b", "-a // 0.3"}) == 0);
+    assert(differences(cf, {"(a - 1) % 0.75", "a // (b - b)", "a % (b - b)"}) == 0);
+
+    // exponentiation is right associative and binds tighter than unary minus
+    assert(differences(cf, {"b ^ a", "-c ^ 0.5", "2 ^ -a ^ 2"}) == 0);
+    assert(differences(cf, {"c ^ 2", "(a + b/3) ^ 2", "b ^ 2 ^ 0.5"}) == 0);
+
+    // squares of values that are not exactly representable go through pow
+    assert(differences(cf, {"(c/3) ^ 2", "(a/7 + 0.1) ^ 2", "(b*0.1) ^ 2"}) == 0);
+
+    // and/or with numeric operands return an operand, not a boolean
+    assert(differences(cf, {"a and b", "a or b", "(a < b) and a or b"}) == 0);
+    assert(differences(cf, {"(a > 0 and a or 0) + c", "not (a < b) and c or b", "a > b and b or c and a"}) == 0);
+
+    // logarithm with an optional base
+    assert(differences(cf, {"log(c)", "log(c, 2)", "log(c + a*a, b*b + 2)"}) == 0);
+  }
+  Kokkos::finalize();
+#ifdef HAVE_MPI
+  MPI_Finalize();
+#endif
+
+  return 0;
+}
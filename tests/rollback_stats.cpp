@@ -0,0 +1,99 @@
+#include "fiesta.hpp"
+#include "input.hpp"
+#include <vector>
+#ifdef HAVE_MPI
+#include "mpi.hpp"
+#endif
+#include "rkfunction.hpp"
+#include "cart3d.hpp"
+#include "rollback.hpp"
+#include "stats.hpp"
+#include <iostream>
+#include <cmath>
+#include <cassert>
+#include "test.hpp"
+
+// set the solution at rest with the given density
+void fill(std::unique_ptr<class rk_func> &f, int ndim, FSCAL rho){
+  FS4DH varH = Kokkos::create_mirror_view(f->var);
+  for (size_t i=0; i<varH.extent(0); ++i)
+    for (size_t j=0; j<varH.extent(1); ++j)
+      for (size_t k=0; k<varH.extent(2); ++k){
+        for (int d=0; d<ndim; ++d)
+          varH(i,j,k,d) = 0.0;
+        varH(i,j,k,ndim) = 1.0;
+        varH(i,j,k,ndim+1) = rho;
+      }
+  Kokkos::deep_copy(f->var,varH);
+}
+
+int main(){
+  {
+    Fiesta::Simulation sim;
+    struct inputConfig &cf = sim.cf;
+    sim.f.reset(initTests(cf));
+
+    cf.tstart = 0;
+    cf.tend = 20;
+    cf.t = 0;
+    cf.time = 0;
+    cf.dt = 1;
+    cf.exitFlag = 0;
+    cf.restartFlag = 0;
+    cf.signalReq = MPI_REQUEST_NULL;
+    cf.out_freq = 0;
+    cf.stat_freq = 0;
+    cf.write_freq = 0;
+    cf.restart_freq = 0;
+    cf.checkpoint_freq = 0;
+    cf.rollback_freq = 1;
+    cf.snapshot_freq = 5;
+    cf.snapshots = 2;
+    cf.maxRollbacks = 3;
+    cf.rollbackDtFactor = 1.0;
+    cf.rollbackNoise = false;
+
+    sim.rollback = std::make_unique<rollbackRing>(cf,sim.f);
+    std::string density = sim.f->varNames[cf.ndim+1];
+    sim.stats.push_back(std::make_shared<runningStats>(cf,sim.f,"stats",1,std::vector<std::string>{density},
+                                                       std::vector<std::pair<std::string,std::string>>{}));
+
+    // the time loop of main, where the step to 13 fails once and the solver
+    // returns to the snapshot at step 10
+    fill(sim.f, cf.ndim, 1.0);
+    bool failed = false;
+    int rollbacks = 0;
+    for (int t = cf.tstart; t < cf.tend+1; ++t){
+      if (Fiesta::checkHealth(sim,t)){
+        t = cf.t;
+        ++rollbacks;
+      }else
+        Fiesta::checkIO(sim,t);
+
+      // the density at step t is t+1
+      if (t == 12 && !failed){
+        fill(sim.f, cf.ndim, -1.0);
+        failed = true;
+      }else
+        fill(sim.f, cf.ndim, t+2);
+      cf.t = t+1;
+    }
+    assert(failed && rollbacks == 1);
+
+    // every step after the first is sampled exactly once, including the
+    // snapshot step that was returned to
+    assert(sim.stats[0]->samples == 20);
+    FS4D result = sim.stats[0]->result();
+    FS4DH resultH = Kokkos::create_mirror_view(result);
+    Kokkos::deep_copy(resultH, result);
+    FSCAL mean = resultH(cf.ng,cf.ng,cf.ng,0);
+    std::cout << "samples " << sim.stats[0]->samples << ", mean " << mean << "\n";
+    assert(std::abs(mean - 11.5) < 1e-12);
+  }
+  Kokkos::finalize();
+#ifdef HAVE_MPI
+  MPI_Finalize();
+#endif
+
+  return 0;
+}
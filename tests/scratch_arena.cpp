@@ -0,0 +1,94 @@
+#include "kokkosTypes.hpp"
+#include "scratch.hpp"
+#include "log2.hpp"
+#include <iostream>
+#include <string>
+#include <cassert>
+
+// byte offset of a lease from the start of another
+template <typename A, typename B>
+ptrdiff_t offset(const A& a, const B& b){
+  return reinterpret_cast<const char*>(b.data()) - reinterpret_cast<const char*>(a.data());
+}
+
+int main(int argc, char* argv[]){
+  Log::Logger(3,0,0);
+  Kokkos::InitArguments kokkosArgs;
+  Kokkos::initialize(kokkosArgs);
+  {
+    scratchArena scratch;
+
+    // the arena is sized for the largest region, with every array aligned
+    scratch.reserve({100*sizeof(FSCAL), 50*sizeof(FSCAL)});
+    scratch.reserve({300*sizeof(FSCAL)});
+    scratch.reserve({10*sizeof(int)});
+    assert(scratchArena::aligned(1) == 256);
+    assert(scratchArena::aligned(256) == 256);
+    assert(scratch.bytes() == scratchArena::aligned(300*sizeof(FSCAL)));
+    scratch.allocate();
+
+    if (argc > 1 && std::string(argv[1]) == "overflow"){
+      // a lease larger than any reserved region must stop the run
+      scratchArena::region r(scratch);
+      FS1D a = r.get<FS1D>(200);
+      FS1D b = r.get<FS1D>(200);
+      std::cout << "overflow not detected\n";
+      return 0;
+    }
+
+    FS1D first;
+    {
+      scratchArena::region r(scratch);
+      FS1D a = r.get<FS1D>(100);
+      FS1D b = r.get<FS1D>(50);
+      assert(a.extent(0) == 100);
+      assert(b.extent(0) == 50);
+      assert(offset(a,b) == (ptrdiff_t)scratchArena::aligned(100*sizeof(FSCAL)));
+      first = a;
+
+      // a nested region returns its leases to the enclosing region
+      FS3D_I n;
+      {
+        scratchArena::region inner(scratch);
+        n = inner.get<FS3D_I>(2,5,1);
+        assert(offset(b,n) == (ptrdiff_t)scratchArena::aligned(50*sizeof(FSCAL)));
+      }
+      FS1D_I m = r.get<FS1D_I>(10);
+      assert(offset(n,m) == 0);
+    }
+
+    // regions that do not overlap share storage
+    {
+      scratchArena::region r(scratch);
+      FS1D c = r.get<FS1D>(300);
+      assert(offset(first,c) == 0);
+      Kokkos::parallel_for(300, KOKKOS_LAMBDA(const int i){ c(i) = i; });
+      FS1DH cH = Kokkos::create_mirror_view(c);
+      Kokkos::deep_copy(cH, c);
+      for (int i=0; i<300; ++i)
+        assert(cH(i) == i);
+    }
+
+    {
+      scratchArena::region r(scratch);
+      FS2D d = r.get<FS2D>(20,15);
+      assert(d.extent(0) == 20 && d.extent(1) == 15);
+      assert(offset(first,d) == 0);
+    }
+
+    // allocating again keeps the arena when nothing larger was reserved
+    FS1D before;
+    {
+      scratchArena::region r(scratch);
+      before = r.get<FS1D>(1);
+    }
+    scratch.allocate();
+    {
+      scratchArena::region r(scratch);
+      assert(offset(before, r.get<FS1D>(1)) == 0);
+    }
+  }
+  Kokkos::finalize();
+
+  return 0;
+}
@@ -0,0 +1,146 @@
+#include "fiesta.hpp"
+#include "input.hpp"
+#include <vector>
+#ifdef HAVE_MPI
+#include "mpi.hpp"
+#endif
+#include "rkfunction.hpp"
+#include "cart3d.hpp"
+#include "block.hpp"
+#include "staging.hpp"
+#include "hdf5.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <cassert>
+#include "test.hpp"
+
+// set every variable to a value unique to the step and variable
+void fill(std::unique_ptr<class rk_func> &f, FSCAL base){
+  FS4DH varH = Kokkos::create_mirror_view(f->var);
+  for (size_t i=0; i<varH.extent(0); ++i)
+    for (size_t j=0; j<varH.extent(1); ++j)
+      for (size_t k=0; k<varH.extent(2); ++k)
+        for (size_t v=0; v<varH.extent(3); ++v)
+          varH(i,j,k,v) = base + v;
+  Kokkos::deep_copy(f->var,varH);
+}
+
+// read the steps of a series file and check that every value of each entry
+// matches the base value expected for it
+std::vector<int> readSeries(std::string fname, std::vector<std::string> names, std::vector<FSCAL> bases){
+  hid_t file = H5Fopen(fname.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+  assert(file >= 0);
+
+  hid_t dset = H5Dopen(file, "/Properties/Step", H5P_DEFAULT);
+  hid_t space = H5Dget_space(dset);
+  hsize_t n;
+  H5Sget_simple_extent_dims(space, &n, NULL);
+  std::vector<int> steps(n);
+  H5Dread(dset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, steps.data());
+  H5Sclose(space);
+  H5Dclose(dset);
+  assert(steps.size() == bases.size());
+
+  for (size_t v=0; v<names.size(); ++v){
+    dset = H5Dopen(file, ("/Solution/" + names[v]).c_str(), H5P_DEFAULT);
+    space = H5Dget_space(dset);
+    hsize_t dims[4];
+    assert(H5Sget_simple_extent_ndims(space) == 4);
+    H5Sget_simple_extent_dims(space, dims, NULL);
+    assert(dims[0] == n);
+    std::vector<FSCAL> data(dims[0]*dims[1]*dims[2]*dims[3]);
+    H5Dread(dset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, data.data());
+    size_t entry = data.size()/n;
+    for (size_t e=0; e<n; ++e)
+      for (size_t p=0; p<entry; ++p)
+        assert(data[e*entry+p] == bases[e] + v);
+    H5Sclose(space);
+    H5Dclose(dset);
+  }
+  H5Fclose(file);
+  return steps;
+}
+
+// number of times a string occurs in a file
+size_t occurrences(std::string fname, std::string pattern){
+  std::ifstream in(fname);
+  std::stringstream ss;
+  ss << in.rdbuf();
+  std::string text = ss.str();
+  size_t count = 0;
+  for (size_t pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos+1))
+    ++count;
+  return count;
+}
+
+int main(){
+  {
+    struct inputConfig cf;
+    std::unique_ptr<class rk_func> f(initTests(cf));
+
+    cf.tend = 20;
+    cf.t = 0;
+    cf.grid = 0;
+    cf.restart = 0;
+    cf.asyncIO = false;
+    cf.dryRun = false;
+    cf.chunkable = false;
+    cf.compressible = false;
+    cf.diagnostics = false;
+    cf.title = "series test";
+    cf.metadata = "none";
+    cf.dxvec = {1.0, 1.0, 1.0};
+    cf.staging = std::make_shared<ioStaging>();
+
+    std::string path = "series_append";
+    std::filesystem::remove_all(path);
+
+    // two outputs per file, every five steps
+    {
+      blockWriter<FSCAL> view(cf, f, "test", path, false, 5, true);
+      view.appendSteps(2);
+      for (int t=0; t<=15; t+=5){
+        fill(f, 1000*t);
+        view.write(cf, f, t, 0.1*t);
+      }
+    }
+    assert(std::filesystem::exists(path + "/test-00.h5"));
+    assert(std::filesystem::exists(path + "/test-10.h5"));
+    assert(!std::filesystem::exists(path + "/test-05.h5"));
+    assert(!std::filesystem::exists(path + "/test-15.h5"));
+
+    assert((readSeries(path + "/test-00.h5", f->varNames, {0, 5000}) == std::vector<int>{0, 5}));
+    assert((readSeries(path + "/test-10.h5", f->varNames, {10000, 15000}) == std::vector<int>{10, 15}));
+
+    // one temporal collection per file with a time for each entry
+    assert(occurrences(path + "/test-10.xmf", "CollectionType=\"Temporal\"") == 1);
+    assert(occurrences(path + "/test-10.xmf", "<Time Value=") == 2);
+
+    // restarting from step 10 replaces the entries from step 10 on
+    cf.restart = 1;
+    {
+      blockWriter<FSCAL> view(cf, f, "test", path, false, 5, true);
+      view.appendSteps(2);
+      fill(f, 500);
+      view.write(cf, f, 10, 1.0);
+      assert((readSeries(path + "/test-10.h5", f->varNames, {500}) == std::vector<int>{10}));
+      assert(occurrences(path + "/test-10.xmf", "<Time Value=") == 1);
+
+      fill(f, 1500);
+      view.write(cf, f, 15, 1.5);
+    }
+    assert((readSeries(path + "/test-10.h5", f->varNames, {500, 1500}) == std::vector<int>{10, 15}));
+    assert((readSeries(path + "/test-00.h5", f->varNames, {0, 5000}) == std::vector<int>{0, 5}));
+    assert(occurrences(path + "/test-10.xmf", "<Time Value=") == 2);
+
+    std::filesystem::remove_all(path);
+  }
+  Kokkos::finalize();
+#ifdef HAVE_MPI
+  MPI_Finalize();
+#endif
+
+  return 0;
+}
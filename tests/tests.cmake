@@ -6,6 +6,25 @@ set(TEST_NAMES
     bc_outflow
     bc_reflective
     bc_hydrostatic
+    expr_lua
+    series_append
+    rollback_stats
+    )
+
+add_executable(scratch_arena tests/scratch_arena.cpp)
+target_link_libraries(scratch_arena PRIVATE Kokkos::kokkos FiestaCore)
+add_test(NAME scratch_arena COMMAND ./tests/scratch_arena)
+add_test(NAME scratch_arena_overflow COMMAND ./tests/scratch_arena overflow)
+set_tests_properties(scratch_arena_overflow
+    PROPERTIES
+    PASS_REGULAR_EXPRESSION "cannot lease"
+    FAIL_REGULAR_EXPRESSION "overflow not detected"
+    )
+set_target_properties( scratch_arena
+    PROPERTIES
+    ARCHIVE_OUTPUT_DIRECTORY "${CMAKE_BINARY_DIR}/tests"
+    LIBRARY_OUTPUT_DIRECTORY "${CMAKE_BINARY_DIR}/tests"
+    RUNTIME_OUTPUT_DIRECTORY "${CMAKE_BINARY_DIR}/tests"
     )
 
 if (NOT Fiesta_NO_MPI)
@@ -32,7 +51,15 @@ if (NOT Fiesta_NO_MPI)
     add_test(NAME halox_ordered_host_copy COMMAND mpirun --oversubscribe -n 8 ./tests/halotest_ordered 1)
     add_test(NAME halox_ordered_gpu_aware COMMAND mpirun --oversubscribe -n 8 ./tests/halotest_ordered 2)
 
-    set_target_properties( halotest_ordered halotest_unordered
+    add_executable(checkpoint_recover tests/checkpoint_recover.cpp src/cart3d.cpp)
+    target_link_libraries(checkpoint_recover PRIVATE Kokkos::kokkos FiestaCore)
+    add_test(NAME checkpoint_recover COMMAND mpirun --oversubscribe -n 2 ./tests/checkpoint_recover)
+
+    add_executable(trace_ring tests/trace_ring.cpp)
+    target_link_libraries(trace_ring PRIVATE Kokkos::kokkos FiestaCore)
+    add_test(NAME trace_ring COMMAND mpirun -n 1 ./tests/trace_ring)
+
+    set_target_properties( halotest_ordered halotest_unordered checkpoint_recover trace_ring
         PROPERTIES
         ARCHIVE_OUTPUT_DIRECTORY "${CMAKE_BINARY_DIR}/tests"
         LIBRARY_OUTPUT_DIRECTORY "${CMAKE_BINARY_DIR}/tests"
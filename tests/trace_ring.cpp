@@ -0,0 +1,111 @@
+#include "input.hpp"
+#include "trace.hpp"
+#include "log2.hpp"
+#include "mpi.h"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <regex>
+#include <string>
+#include <vector>
+#include <cassert>
+
+struct traced {
+  std::string name;
+  int step;
+  double dur;
+};
+
+// the complete events of a trace file in the order they were written
+std::vector<traced> readTrace(std::string fname){
+  std::ifstream in(fname);
+  std::string line;
+  std::vector<traced> events;
+  std::regex pattern("\\{\"name\": \"([^\"]*)\", \"ph\": \"X\", \"pid\": 0, \"tid\": 0, \"ts\": [-0-9.]+, \"dur\": ([0-9.]+), \"args\": \\{\"step\": (-?[0-9]+)\\}\\},?");
+  while (std::getline(in, line)){
+    std::smatch m;
+    if (std::regex_match(line, m, pattern))
+      events.push_back({m[1], std::stoi(m[3]), std::stod(m[2])});
+  }
+  return events;
+}
+
+// record a short region directly
+void record(std::string name){
+  Trace::clock::time_point start = Trace::clock::now();
+  Trace::complete(name, start, start + std::chrono::microseconds(1));
+}
+
+int main(){
+  MPI_Init(NULL,NULL);
+  Log::Logger(3,0,0);
+  {
+    struct inputConfig cf;
+    cf.comm = MPI_COMM_WORLD;
+    MPI_Comm_rank(cf.comm, &cf.rank);
+    MPI_Comm_size(cf.comm, &cf.numProcs);
+    cf.pathName = ".";
+    cf.traceName = "trace_ring";
+    cf.traceStart = -1;
+    cf.traceSteps = 2;
+    cf.traceEvents = 4;
+
+    std::string fname = "./trace_ring.json";
+    std::filesystem::remove(fname);
+    Trace::configure(cf);
+
+    // regions before the window are not recorded
+    assert(!Trace::active());
+    Trace::begin("early");
+    Trace::end();
+
+    // a region begun before the window stays paired with its end, and is not
+    // recorded when it ends inside the window
+    Trace::begin("spanning");
+    Trace::step(cf, 10);
+    assert(Trace::active());
+    record("a0");
+    record("a1");
+    Trace::begin("child");
+    Trace::end();
+    Trace::end();
+    record("a2");
+
+    // nested regions are recorded as they end
+    Trace::step(cf, 11);
+    Trace::begin("outer");
+    Trace::begin("inner");
+    Trace::end();
+    Trace::end();
+    record("a3");
+    assert(!std::filesystem::exists(fname));
+
+    // the window closes and the trace is written at the start of step 12
+    Trace::step(cf, 12);
+    assert(!Trace::active());
+    assert(std::filesystem::exists(fname));
+    Trace::begin("late");
+    Trace::end();
+    Trace::finish(cf);
+
+    // seven events in a ring of four keep the newest four, oldest first
+    std::vector<traced> events = readTrace(fname);
+    assert(events.size() == 4);
+    assert(events[0].name == "a2" && events[0].step == 10);
+    assert(events[1].name == "inner" && events[1].step == 11);
+    assert(events[2].name == "outer" && events[2].step == 11);
+    assert(events[3].name == "a3" && events[3].step == 11);
+    assert(events[2].dur >= events[1].dur);
+
+    std::ifstream in(fname);
+    std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    assert(text.find("{\"displayTimeUnit\": \"ms\", \"traceEvents\": [") == 0);
+    assert(text.find("\"args\": {\"name\": \"rank 0\"}") != std::string::npos);
+    assert(text.rfind("]}\n") == text.size()-3);
+
+    std::filesystem::remove(fname);
+  }
+  MPI_Finalize();
+
+  return 0;
+}